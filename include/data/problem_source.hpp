@@ -0,0 +1,41 @@
+#ifndef DATA_PROBLEM_SOURCE_HPP
+#define DATA_PROBLEM_SOURCE_HPP
+
+#include "dataset.hpp"
+
+#include <memory>
+
+namespace wlplan {
+  namespace data {
+    // Pull-style access to the problems of a dataset so that their states can be loaded or
+    // generated on demand instead of all being held in memory. Colour collection reads the source
+    // once after reset() and keeps the generated graphs, which can be spilled to disk.
+    class ProblemSource {
+     public:
+      virtual ~ProblemSource() = default;
+
+      // restart from the first problem
+      virtual void reset() = 0;
+
+      // returns nullptr after the last problem; the returned data may be released after the next
+      // call to next() or reset()
+      virtual std::shared_ptr<const ProblemDataset> next() = 0;
+    };
+
+    // Reads the problems of a dataset in memory without copying them.
+    class DomainDatasetSource : public ProblemSource {
+     public:
+      explicit DomainDatasetSource(const DomainDataset &dataset);
+
+      void reset() override;
+
+      std::shared_ptr<const ProblemDataset> next() override;
+
+     private:
+      const DomainDataset &dataset;
+      size_t index;
+    };
+  }  // namespace data
+}  // namespace wlplan
+
+#endif  // DATA_PROBLEM_SOURCE_HPP
@@ -0,0 +1,139 @@
+#ifndef FEATURE_GENERATOR_COLOUR_HASH_HPP
+#define FEATURE_GENERATOR_COLOUR_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // a colour key is the sequence of ints that is hashed to a single colour in WL refinement
+    using ColourKey = std::span<const int>;
+
+    // murmur3 64-bit finaliser
+    inline uint64_t mix64(uint64_t h) {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    inline uint64_t colour_fingerprint(const ColourKey key) {
+      uint64_t h = mix64(key.size() + 0x9e3779b97f4a7c15ULL);
+      for (const int i : key) {
+        h = mix64(h ^ (uint32_t)i) + 0x9e3779b97f4a7c15ULL;
+      }
+      return mix64(h);
+    }
+
+    // Open addressing dictionary from colour keys to colours. Keys are copied into one contiguous
+    // arena, and each slot of the linearly probed table only holds the 64-bit fingerprint of its
+    // key and an entry index. Full keys are only compared when fingerprints match, and lookups do
+    // not allocate. Entries cannot be removed, and are iterated in insertion order.
+    class ColourHash {
+     public:
+      // returned by find() for keys that are not in the dictionary
+      static constexpr int NOT_FOUND = -1;
+
+      class const_iterator {
+       public:
+        const_iterator(const ColourHash *hash, size_t entry) : hash(hash), entry(entry) {}
+        std::pair<ColourKey, int> operator*() const {
+          return {hash->get_key(entry), hash->values[entry]};
+        }
+        const_iterator &operator++() {
+          entry++;
+          return *this;
+        }
+        bool operator==(const const_iterator &other) const { return entry == other.entry; }
+        bool operator!=(const const_iterator &other) const { return entry != other.entry; }
+
+       private:
+        const ColourHash *hash;
+        size_t entry;
+      };
+
+      ColourHash();
+
+      size_t size() const { return values.size(); }
+      bool empty() const { return values.empty(); }
+      void reserve(size_t n_entries);
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, size()); }
+
+      inline int find(const ColourKey key) const { return find(key, colour_fingerprint(key)); }
+      inline int find(const ColourKey key, const uint64_t fingerprint) const {
+        for (size_t i = fingerprint & mask;; i = (i + 1) & mask) {
+          const Slot &slot = slots[i];
+          if (slot.entry == EMPTY) {
+            return NOT_FOUND;
+          }
+          if (slot.fingerprint == fingerprint && key_equals(slot.entry, key)) {
+            return values[slot.entry];
+          }
+        }
+      }
+
+      bool contains(const ColourKey key) const { return find(key) != NOT_FOUND; }
+
+      // throws std::out_of_range if the key does not exist
+      int at(const ColourKey key) const;
+
+      // inserts the key with the given value if it does not exist, and returns the stored value
+      // and whether an insertion took place
+      inline std::pair<int, bool> insert(const ColourKey key, const int value) {
+        return insert(key, value, colour_fingerprint(key));
+      }
+      std::pair<int, bool> insert(const ColourKey key, const int value, const uint64_t fingerprint);
+
+      void insert_or_assign(const ColourKey key, const int value);
+
+     private:
+      static constexpr int EMPTY = -1;
+
+      struct Slot {
+        uint64_t fingerprint;
+        int entry;
+      };
+
+      // keys of entry i are arena[key_offsets[i]:key_offsets[i + 1]]
+      std::vector<int> arena;
+      std::vector<size_t> key_offsets;
+      std::vector<int> values;
+      std::vector<uint64_t> fingerprints;
+
+      std::vector<Slot> slots;
+      size_t mask;
+
+      inline ColourKey get_key(const size_t entry) const {
+        return ColourKey(arena.data() + key_offsets[entry],
+                         key_offsets[entry + 1] - key_offsets[entry]);
+      }
+
+      inline bool key_equals(const size_t entry, const ColourKey key) const {
+        size_t begin = key_offsets[entry];
+        if (key_offsets[entry + 1] - begin != key.size()) {
+          return false;
+        }
+        for (size_t i = 0; i < key.size(); i++) {
+          if (arena[begin + i] != key[i]) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      // index of the slot holding the key, or of the empty slot where it would be inserted
+      size_t find_slot(const ColourKey key, const uint64_t fingerprint) const;
+
+      void rehash(size_t n_slots);
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_COLOUR_HASH_HPP
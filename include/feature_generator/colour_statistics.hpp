@@ -0,0 +1,80 @@
+#ifndef FEATURE_GENERATOR_COLOUR_STATISTICS_HPP
+#define FEATURE_GENERATOR_COLOUR_STATISTICS_HPP
+
+#include "colouring_store.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Number of times each colour occurs in each data index during collection, which is used to
+    // find equivalent features for pruning. Counts of colours that are still being collected are
+    // appended to small per-colour buffers. seal() then compresses them into runs of consecutive
+    // data indices with the same count, stored back to back for all colours in a ColouringStore,
+    // together with a 64-bit signature of the runs of each colour. Two colours have the same counts
+    // iff their runs are equal, as runs are always maximal. If a spill directory is given, sealed
+    // runs are spilled to it like intermediate colourings, and only the offsets and signatures of
+    // sealed colours are kept in memory.
+    class ColourStatistics {
+     public:
+      explicit ColourStatistics(const std::string &spill_directory = "");
+
+      ColourStatistics(ColourStatistics &&) = default;
+      ColourStatistics &operator=(ColourStatistics &&) = default;
+
+      // number of colours, which are sealed or open
+      int size() const { return n_sealed + (int)open.size(); }
+
+      // drops all counts, and colours below n_colours are sealed without counts and ignored by add()
+      void reset(const int n_colours, const std::string &spill_directory = "");
+
+      // opens colours up to n_colours
+      void resize(const int n_colours);
+
+      // counts of each open colour must be added in nondecreasing order of data index
+      void add(const int colour, const int data_index, const int count = 1) {
+        if (colour < n_sealed) {
+          return;
+        }
+        std::vector<std::pair<int, int>> &counts = open[colour - n_sealed];
+        if (!counts.empty() && counts.back().first == data_index) {
+          counts.back().second += count;
+        } else {
+          counts.emplace_back(data_index, count);
+        }
+      }
+
+      // compresses the counts of all open colours, after which they can no longer be added to
+      void seal();
+
+      // the following require all colours to be sealed
+      uint64_t get_signature(const int colour) const { return signatures[colour]; }
+      long get_total_count(const int colour) const;
+      bool equal(const int colour1, const int colour2) const;
+      // statistics of the given colours, where colour i of the result is colours[i]
+      ColourStatistics select(const std::vector<int> &colours) const;
+
+     private:
+      // a run is stored as the ints (first data index, length, count)
+      static constexpr int RUN_SIZE = 3;
+
+      std::string spill_directory;
+      int n_sealed;
+      // runs of sealed colour i are entry i of the store
+      ColouringStore runs;
+      std::vector<uint64_t> signatures;
+
+      // (data_index, count) pairs of open colour n_sealed + i, sorted by data index
+      std::vector<std::vector<std::pair<int, int>>> open;
+
+      // appends the runs of the next sealed colour
+      void append_runs(const std::vector<int> &colour_runs);
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_COLOUR_STATISTICS_HPP
@@ -0,0 +1,61 @@
+#ifndef FEATURE_GENERATOR_COLOURING_STORE_HPP
+#define FEATURE_GENERATOR_COLOURING_STORE_HPP
+
+#include "embedding.hpp"
+
+#include <string>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Intermediate colourings of all graphs during collection, stored back to back in one array.
+    // Other int arrays, such as encoded graphs or the sealed runs of colour statistics, are stored
+    // in the same way.
+    // If a spill directory is given, the array lives in a memory-mapped temporary file in that
+    // directory so that the operating system can page it out, and collection is limited by disk
+    // space instead of memory. Only the offsets of each colouring are kept in memory.
+    class ColouringStore {
+     public:
+      // colourings are kept in memory if spill_directory is empty
+      explicit ColouringStore(const std::string &spill_directory);
+      ~ColouringStore();
+
+      ColouringStore(const ColouringStore &) = delete;
+      ColouringStore &operator=(const ColouringStore &) = delete;
+      ColouringStore(ColouringStore &&other) noexcept;
+      ColouringStore &operator=(ColouringStore &&other) noexcept;
+
+      size_t size() const { return offsets.size() - 1; }
+      bool is_spilled() const { return fd != -1; }
+
+      // appending may move the colourings, so it must not run concurrently with other accesses
+      void push_back(const Colouring &colours);
+
+      // colourings of different graphs can be accessed concurrently
+      int *begin(const size_t i) { return data + offsets[i]; }
+      int *end(const size_t i) { return data + offsets[i + 1]; }
+      const int *begin(const size_t i) const { return data + offsets[i]; }
+      const int *end(const size_t i) const { return data + offsets[i + 1]; }
+      void load(const size_t i, Colouring &colours) const;
+      void store(const size_t i, const Colouring &colours);
+
+      // writes spilled colourings back to disk and drops them from memory, after which they are
+      // paged in again on their next access
+      void release();
+
+     private:
+      std::vector<size_t> offsets;
+      int *data;
+      size_t capacity;
+
+      // storage when not spilled
+      std::vector<int> memory;
+      // spill file, which is unlinked on creation so that it is removed once closed
+      int fd;
+
+      void reserve(const size_t new_capacity);
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_COLOURING_STORE_HPP
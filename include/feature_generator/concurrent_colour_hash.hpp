@@ -0,0 +1,55 @@
+#ifndef FEATURE_GENERATOR_CONCURRENT_COLOUR_HASH_HPP
+#define FEATURE_GENERATOR_CONCURRENT_COLOUR_HASH_HPP
+
+#include "features.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Colour dictionary for a single WL iteration that can be written to by several threads at
+    // once. Keys are split over shards by their hash, each guarded by its own mutex. Colours that
+    // already exist in the given ColourHash are returned as is. New colours are given provisional
+    // ids, and the smallest occurrence each colour was seen at is kept so that new colours can be
+    // renumbered afterwards in the same order as a sequential pass would have hashed them.
+    class ConcurrentColourHash {
+     public:
+      // provisional ids are encoded as negative numbers below UNSEEN_COLOUR
+      static inline bool is_provisional(const int colour) { return colour < UNSEEN_COLOUR; }
+      static inline int to_provisional(const int index) { return UNSEEN_COLOUR - 1 - index; }
+      static inline int from_provisional(const int colour) { return UNSEEN_COLOUR - 1 - colour; }
+
+      // occurrences are compared lexicographically by (graph_index, node_index)
+      static inline uint64_t occurrence(const size_t graph_index, const size_t node_index) {
+        return ((uint64_t)graph_index << 32) | (uint64_t)node_index;
+      }
+
+      ConcurrentColourHash(const ColourHash &existing, const int n_threads);
+
+      int get(const ColourKey colour, const uint64_t occurrence);
+
+      // number of provisional ids handed out, which may be larger than the number of new colours
+      size_t get_n_provisional() const;
+
+      // new colours and their provisional ids ordered by first occurrence
+      std::vector<std::pair<std::vector<int>, int>> get_new_colours() const;
+
+     private:
+      // colours maps keys to their index in first_occurrence
+      struct Shard {
+        std::mutex mutex;
+        ColourHash colours;
+        std::vector<uint64_t> first_occurrence;
+      };
+
+      const ColourHash &existing;
+      std::vector<std::unique_ptr<Shard>> shards;
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_CONCURRENT_COLOUR_HASH_HPP
@@ -0,0 +1,88 @@
+#ifndef FEATURE_GENERATOR_EMBEDDING_HPP
+#define FEATURE_GENERATOR_EMBEDDING_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // colours[u] is the current colour of node (or node tuple) u during WL refinement
+    using Colouring = std::vector<int>;
+
+    // sparse feature vector as (colour, count) pairs sorted by colour
+    using Embedding = std::vector<std::pair<int, int>>;
+    using EmbeddingVec = std::vector<int>;
+
+    // Accumulates colour counts for a single graph into an Embedding. Counts are stored in the
+    // output pairs directly, with a dense colour to position index so that updates are O(1).
+    // Only touched entries of the index are reset in to_embedding(), so the same counter can be
+    // reused across graphs without clearing memory proportional to the number of colours.
+    class EmbeddingCounter {
+     public:
+      EmbeddingCounter() = default;
+
+      inline void add(const int colour) { entry(colour).second++; }
+
+      // the count is kept as an int to match the Embedding type
+      inline void add(const int colour, const double value) { entry(colour).second += value; }
+
+      // returns the sorted embedding and resets the counter
+      Embedding to_embedding();
+
+     private:
+      std::vector<int> position;
+      Embedding x;
+
+      inline std::pair<int, int> &entry(const int colour) {
+        if (colour >= (int)position.size()) {
+          position.resize(colour + 1, -1);
+        }
+        int &pos = position[colour];
+        if (pos == -1) {
+          pos = x.size();
+          x.emplace_back(colour, 0);
+        }
+        return x[pos];
+      }
+    };
+
+    // feature matrix in compressed sparse row format, with the same buffer layout as
+    // scipy.sparse.csr_matrix((data, indices, indptr), shape=(n_rows, n_cols))
+    struct CSRMatrix {
+      int64_t n_rows = 0;
+      int64_t n_cols = 0;
+      std::vector<int64_t> indptr;
+      std::vector<int32_t> indices;
+      std::vector<int32_t> data;
+    };
+
+    // Builds a CSRMatrix from rows that may be written concurrently and in any order. A row is
+    // appended to indices and data as soon as all rows before it are written, so only rows that
+    // finish ahead of order are held in separate buffers.
+    class CSRWriter {
+     public:
+      CSRWriter(const size_t n_rows, const int n_cols);
+
+      void write_row(const size_t i, Embedding &&x);
+
+      // all rows must have been written
+      CSRMatrix finish();
+
+     private:
+      std::mutex mutex;
+      CSRMatrix matrix;
+      std::unordered_map<size_t, Embedding> pending_rows;
+
+      void append_row(const Embedding &x);
+    };
+
+    std::map<int, int> embedding_to_map(const Embedding &embedding);
+    Embedding map_to_embedding(const std::map<int, int> &embedding);
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_EMBEDDING_HPP
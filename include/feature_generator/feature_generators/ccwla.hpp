@@ -26,7 +26,8 @@ namespace wlplan {
 
       int get_n_features() const override;
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
     };
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -12,6 +12,59 @@
 
 namespace wlplan {
   namespace feature_generator {
+    // Edges of a graph reversed, as nodes are refined with the colours of their successors.
+    class PredecessorLists {
+     public:
+      // reuses the memory of the previous graph
+      void build(const graph_generator::Graph &graph);
+
+      int begin(const int v) const { return offsets[v]; }
+      int end(const int v) const { return offsets[v + 1]; }
+      int get_predecessor(const int j) const { return predecessors[j]; }
+
+     private:
+      std::vector<int> offsets;
+      std::vector<int> predecessors;
+      std::vector<int> next;
+    };
+
+    // Nodes whose colours can depend on an individualised node after a number of iterations, which
+    // are the nodes with a path of at most that many edges to it, in order of their distance.
+    class IndividualisationBall {
+     public:
+      // empties the ball for a graph of n_nodes nodes, reusing memory
+      void reset(const int n_nodes);
+      void build(const PredecessorLists &predecessors, const int node, const int radius);
+
+      int size() const { return nodes.size(); }
+      int get_node(const int k) const { return nodes[k]; }
+      int get_depth(const int k) const { return depths[k]; }
+      // index k of node u in the ball, or -1 if u is not in the ball
+      int get_position(const int u) const { return positions[u]; }
+
+     private:
+      std::vector<int> nodes;
+      std::vector<int> depths;
+      std::vector<int> positions;
+    };
+
+    // Memory of IWLFeatures::embed_impl that is kept in a workspace between graphs, with the
+    // memory of each thread that individualises nodes of a graph
+    struct IWLScratch : public EmbeddingScratch {
+      PredecessorLists predecessors;
+      std::vector<Colouring> base_colours;
+      std::vector<IndividualisationBall> balls;
+      std::vector<Colouring> colours;
+      std::vector<Colouring> new_colours;
+      // number of individualised nodes at each distance from each node
+      std::vector<std::vector<int>> depth_counts;
+      std::vector<int> cover;
+    };
+
+    // Individualised WL, which runs WL once for each node with that node given a distinct initial
+    // colour. Colours of nodes further than k edges from the individualised node are the same as
+    // without individualisation after k iterations, so only the balls around individualised nodes
+    // are refined, with colours outside of them taken from one shared WL colouring.
     class IWLFeatures : public WLFeatures {
      public:
       IWLFeatures(const std::string feature_name,
@@ -31,13 +84,44 @@ namespace wlplan {
 
       IWLFeatures(const std::string &filename, bool quiet);
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
 
      protected:
       void collect_impl(const std::vector<graph_generator::Graph> &graphs) override;
-      void refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                  Embedding &colours,
-                  int iteration);
+      void collect_impl(data::ProblemSource &source) override;
+      void collect_graph(const graph_generator::Graph &graph, const int data_index);
+
+      // Colours of all nodes after each iteration without individualisation. If cover is not
+      // empty, it is the number of individualised nodes within each number of iterations of each
+      // node, and colours of nodes covered by every node are never read and are not hashed. Other
+      // colours are counted once for every individualisation that keeps them, as in embed_impl.
+      void compute_base_colours(const graph_generator::Graph &graph,
+                                const std::vector<std::vector<int>> &cover,
+                                std::vector<Colouring> &base_colours,
+                                NeighbourContainer &container,
+                                const int data_index);
+      // Refines the colours of the ball around its individualised node, and calls
+      // f(iteration, u, colour) for the nodes u of the ball within iteration edges.
+      template <typename F>
+      void refine_ball(const graph_generator::Graph &graph,
+                       const IndividualisationBall &ball,
+                       const std::vector<Colouring> &base_colours,
+                       Colouring &colours,
+                       Colouring &new_colours,
+                       NeighbourContainer &container,
+                       const int data_index,
+                       const F &f);
+      // hashes node u with its colour and the colours colour_of(v) of its neighbours v
+      template <typename F>
+      int refine_node(const graph_generator::Graph &graph,
+                      const int u,
+                      const int colour,
+                      const F &colour_of,
+                      const int iteration,
+                      NeighbourContainer &container,
+                      const int data_index,
+                      const int count = 1);
     };
   }  // namespace feature_generator
 }  // namespace wlplan
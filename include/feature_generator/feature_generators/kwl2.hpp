@@ -3,6 +3,7 @@
 
 #include "../features.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -12,6 +13,13 @@
 
 namespace wlplan {
   namespace feature_generator {
+    // Sorts colour pairs packed as (colour1 << 32) | colour0 and appends each distinct pair to key
+    // as colour1, colour0 and its count, or 1 if multiset_hash is false. This is the layout of
+    // KWL2NeighbourContainer with colour0 inserted as the node colour and colour1 as the label.
+    void append_pair_counts(std::vector<uint64_t> &pairs,
+                            const bool multiset_hash,
+                            std::vector<int> &key);
+
     class KWL2Features : public Features {
      public:
       KWL2Features(const std::string wl_name,
@@ -33,19 +41,30 @@ namespace wlplan {
 
       int get_n_features() const override;
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
-      void collect_impl(const std::vector<data::ProblemDataset> &data) override {std::cout << "COLLECT METHOD NOT IMPLEMENTED!!!" << std::endl;};
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
+      void collect_impl(data::ProblemSource &source) override;
 
      protected:
       inline int get_initial_colour(int index,
                                     int u,
                                     int v,
                                     const std::shared_ptr<graph_generator::Graph> &graph,
-                                    const std::vector<int> &pair_to_edge_label);
+                                    const std::vector<int> &pair_to_edge_label,
+                                    int data_index);
+      void initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                              Colouring &colours,
+                              int data_index = -99);
       void collect_impl(const std::vector<graph_generator::Graph> &graphs) override;
-      void refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                  Embedding &colours,
-                  int iteration);
+      // Refines the n_nodes x n_nodes row major matrix of pair colours. Rows are refined with
+      // get_n_threads() threads when collecting, where new colours are then hashed in the same
+      // order as in a sequential pass.
+      void refine(const int n_nodes,
+                  Colouring &colours,
+                  const int iteration,
+                  const int data_index = -99);
+      // runs the remaining iterations on the initial colours of all graphs with layer pruning
+      void refine_all(ColouringStore &graph_colours, const std::vector<int> &graph_n_nodes);
     };
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -1,10 +1,10 @@
 #ifndef FEATURE_GENERATOR_FEATURE_GENERATORS_LWL2_HPP
 #define FEATURE_GENERATOR_FEATURE_GENERATORS_LWL2_HPP
 
+#include "../lwl2_pair_neighbours.hpp"
 #include "kwl2.hpp"
 
 #include <memory>
-#include <set>
 #include <string>
 #include <vector>
 
@@ -14,6 +14,13 @@ namespace wlplan {
   namespace feature_generator {
     class LWL2Features : public KWL2Features {
      public:
+      LWL2Features(const std::string wl_name,
+                   const planning::Domain &domain,
+                   std::string graph_representation,
+                   int iterations,
+                   std::string pruning,
+                   bool multiset_hash);
+
       LWL2Features(const planning::Domain &domain,
                    std::string graph_representation,
                    int iterations,
@@ -24,19 +31,38 @@ namespace wlplan {
 
       LWL2Features(const std::string &filename, bool quiet);
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
+      void collect_impl(data::ProblemSource &source) override;
+
+      // Pair neighbourhoods of a graph are stored if they take at most this many pair entries,
+      // and are otherwise generated from node neighbours whenever they are visited.
+      long get_max_pair_entries() const { return max_pair_entries; }
+      void set_max_pair_entries(const long max_pair_entries);
 
      protected:
+      static constexpr long DEFAULT_MAX_PAIR_ENTRIES = 1 << 24;
+      long max_pair_entries;
+
       inline int get_initial_colour(int index,
                                     int u,
                                     int v,
                                     const std::shared_ptr<graph_generator::Graph> &graph,
-                                    const std::vector<int> &pair_to_edge_label);
+                                    const std::vector<int> &pair_to_edge_label,
+                                    int data_index);
       void collect_impl(const std::vector<graph_generator::Graph> &graphs) override;
-      void refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                  std::vector<std::set<int>> &pair_to_neighbours,
-                  Embedding &colours,
-                  int iteration);
+
+      // Encodes the pairs of a graph and their neighbours, which are kept with the colours of the
+      // graph during collection and passed to the functions below.
+      virtual void encode_pairs(const graph_generator::Graph &graph, std::vector<int> &pairs);
+      virtual void initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                                      const int *pairs,
+                                      Colouring &colours,
+                                      int data_index = -99);
+      virtual void
+      refine(const int *pairs, Colouring &colours, int iteration, int data_index = -99);
+      // runs the remaining iterations on the initial colours of all graphs with layer pruning
+      void refine_all(ColouringStore &graph_colours, ColouringStore &graph_pairs);
     };
   }  // namespace feature_generator
 }  // namespace wlplan
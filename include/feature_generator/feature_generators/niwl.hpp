@@ -21,7 +21,8 @@ namespace wlplan {
 
       NIWLFeatures(const std::string &filename, bool quiet);
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
     };
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -0,0 +1,46 @@
+#ifndef FEATURE_GENERATOR_FEATURE_GENERATORS_SLWL2_HPP
+#define FEATURE_GENERATOR_FEATURE_GENERATORS_SLWL2_HPP
+
+#include "lwl2.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Sparse 2-LWL, which only colours pairs of nodes within radius edges of each other. All other
+    // pairs share FAR_PAIR_COLOUR, which is never refined and is not a feature, so that time and
+    // memory grow with the number of nearby pairs instead of quadratically in the nodes.
+    class SLWL2Features : public LWL2Features {
+     public:
+      SLWL2Features(const planning::Domain &domain,
+                    std::string graph_representation,
+                    int iterations,
+                    std::string pruning,
+                    bool multiset_hash,
+                    int radius);
+
+      SLWL2Features(const std::string &filename);
+
+      SLWL2Features(const std::string &filename, bool quiet);
+
+      int get_radius() const { return radius; }
+
+     protected:
+      // pairs of nodes with a path of more than radius edges between them are not coloured [saved]
+      int radius;
+
+      void save_config(json &config) const override;
+      void encode_pairs(const graph_generator::Graph &graph, std::vector<int> &pairs) override;
+      void initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                              const int *pairs,
+                              Colouring &colours,
+                              int data_index = -99) override;
+      void
+      refine(const int *pairs, Colouring &colours, int iteration, int data_index = -99) override;
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_FEATURE_GENERATORS_SLWL2_HPP
@@ -1,14 +1,65 @@
 #ifndef FEATURE_GENERATOR_FEATURE_GENERATORS_WL_HPP
 #define FEATURE_GENERATOR_FEATURE_GENERATORS_WL_HPP
 
+#include "../../graph_generator/dynamic_graph.hpp"
+#include "../concurrent_colour_hash.hpp"
 #include "../features.hpp"
+#include "../stored_graph.hpp"
 
+#include <climits>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wlplan {
   namespace feature_generator {
+    struct WLContextState;
+
+    // WL colouring of a state for computing the embeddings of successor states by only recolouring
+    // nodes close to the atoms that changed. Contexts form a tree whose roots are made by
+    // init_context() and whose other nodes are made by successor_context(). Only the context that
+    // a feature generator is currently at has its graph and colours in memory, in a WLContextState
+    // shared by all its contexts. Every other context keeps the changes of its transition from its
+    // parent, which are undone and redone to move the state between contexts, so making a
+    // successor context costs the size of the changed neighbourhood and not of the graph. Contexts
+    // are only valid for the problem that was set when their root was made, and using them after
+    // set_problem() is called again throws.
+    struct WLContext {
+      // colour of removed nodes, which are not counted
+      static constexpr int NO_NODE = INT_MIN;
+
+      struct ColourChange {
+        int iteration;
+        int node;
+        int old_colour;
+        int new_colour;
+      };
+
+      // nullptr for roots, which keep the atoms of their state instead of changes
+      std::shared_ptr<WLContext> parent;
+      const WLContext *root;
+      // the problem that was set when the root was made, only stored on roots
+      std::shared_ptr<const planning::Problem> problem;
+      int depth;
+      std::vector<planning::Atom> atoms;
+      graph_generator::DynamicGraphLog graph_changes;
+      std::vector<ColourChange> colour_changes;
+      // dot product of colour counts with the weights, if they were set when the context was made
+      double h;
+      std::weak_ptr<WLContextState> state;
+    };
+
+    struct WLContextState {
+      std::shared_ptr<graph_generator::DynamicGraph> graph;
+      // colours[itr][u] is the colour of node u at iteration itr
+      std::vector<Colouring> colours;
+      // counts of seen colours over all iterations
+      std::unordered_map<int, int> counts;
+      // the context whose colouring this is, which keeps it and its ancestors alive
+      std::shared_ptr<WLContext> context;
+    };
+
     class WLFeatures : public Features {
      public:
       WLFeatures(const std::string wl_name,
@@ -30,20 +81,68 @@ namespace wlplan {
 
       int get_n_features() const override;
 
-      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) override;
+      Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                           EmbeddingWorkspace &workspace) override;
+
+      /* Incremental embedding functions */
+
+      // Colouring of a state of the problem that is set, which is only supported for the wl
+      // feature generator with ILG graphs. Unseen colour statistics are not updated.
+      std::shared_ptr<WLContext> init_context(const planning::State &state);
+      // Context of a successor state given the context of its parent and the atoms added and
+      // deleted by the transition, where deletes are applied before adds. Adding an atom that is
+      // already true or deleting an atom that is already false does nothing, so the add and delete
+      // effects of an action can be passed directly. Nodes are only recoloured at an iteration if
+      // they or one of their neighbours changed colour at the previous iteration.
+      std::shared_ptr<WLContext> successor_context(const std::shared_ptr<WLContext> &parent,
+                                                   const std::vector<planning::Atom> &add_atoms,
+                                                   const std::vector<planning::Atom> &del_atoms);
+      // moves the context state to the context, which is cheap for contexts near the last one used
+      Embedding embed_context(const std::shared_ptr<WLContext> &context);
+      double predict_context(const WLContext &context) const;
 
      protected:
       void collect_impl(const std::vector<graph_generator::Graph> &graphs) override;
-      void collect_impl(const std::vector<data::ProblemDataset> &data) override;
+      void collect_impl(data::ProblemSource &source) override;
       void refine(const std::shared_ptr<graph_generator::Graph> &graph,
                   std::set<int> &nodes,
-                  Embedding &colours,
+                  Colouring &colours,
+                  int iteration,
+                  NeighbourContainer &container,
+                  int data_index = -99);
+      // G is graph_generator::Graph or StoredGraph
+      template <typename G>
+      void refine(const G &graph,
+                  std::set<int> &nodes,
+                  Colouring &colours,
                   int iteration,
-				          int data_index=-99);
+                  NeighbourContainer &container,
+                  int data_index);
+      // for collecting with several threads, where iteration 0 computes the initial colours
+      template <typename G>
+      void refine_concurrent(const G &graph,
+                             Colouring &colours,
+                             int iteration,
+                             NeighbourContainer &container,
+                             ConcurrentColourHash &hash,
+                             size_t data_index);
+      void collect_impl_parallel(const std::vector<graph_generator::Graph> &graphs);
+      void collect_impl_parallel(data::ProblemSource &source);
+      std::shared_ptr<WLContextState> context_state;
+      // colours the graph of the state of a root context from scratch and returns its h
+      double rebuild_context_state(const WLContext &root);
+      // moves the context state to the context by undoing and redoing changes between them
+      void move_context_state(const std::shared_ptr<WLContext> &context);
+      // recolours the given nodes and nodes whose neighbourhood changed colour, and updates counts,
+      // h and the changes of the context if it is not nullptr
+      void recolour_context(const std::vector<int> &changed_nodes, double &h, WLContext *context);
+      int context_colour(const int u, const int iteration);
+      void update_context_count(const int colour, const int delta);
       // for when we know that there are no unseen colours
       void refine_fast(const std::shared_ptr<graph_generator::Graph> &graph,
-                     Embedding &colours,
-                       int iteration);
+                       Colouring &colours,
+                       int iteration,
+                       NeighbourContainer &container);
     };
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -2,13 +2,20 @@
 #define FEATURE_GENERATOR_FEATURES_HPP
 
 #include "../data/dataset.hpp"
+#include "../data/problem_source.hpp"
 #include "../graph_generator/graph.hpp"
 #include "../graph_generator/graph_generator.hpp"
 #include "../planning/domain.hpp"
 #include "../planning/state.hpp"
+#include "colour_hash.hpp"
+#include "colour_statistics.hpp"
+#include "colouring_store.hpp"
+#include "frozen_colour_hash.hpp"
+#include "embedding.hpp"
 #include "neighbour_container.hpp"
 #include "pruning_options.hpp"
 #include <fstream>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -31,26 +38,35 @@
   }                                                                                                \
   std::cout << std::endl;
 
-class int_vector_hasher {
- public:
-  // https://stackoverflow.com/a/27216842
-  std::size_t operator()(std::vector<int> const &vec) const {
-    std::size_t seed = vec.size();
-    for (auto &i : vec) {
-      seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    }
-    return seed;
-  }
-};
-
 namespace wlplan {
   namespace feature_generator {
-    using Embedding = std::map<int, int>;
-	  using EmbeddingVec = std::vector<int>;
-    using ColourHash = std::unordered_map<std::vector<int>, int, int_vector_hasher>;
     using VecColourHash = std::vector<ColourHash>;
     using StrColourHash = std::vector<std::unordered_map<std::string, int>>;
 
+    class ConcurrentColourHash;
+
+    // Memory that a feature generator keeps in a workspace between the graphs it embeds.
+    struct EmbeddingScratch {
+      virtual ~EmbeddingScratch() = default;
+    };
+
+    // Mutable memory for embedding a single graph. Each embedding thread owns a workspace, so that
+    // the members of Features are only read when embedding graphs in parallel.
+    struct EmbeddingWorkspace {
+      std::shared_ptr<NeighbourContainer> neighbour_container;
+      EmbeddingCounter x;
+      // same layout as Features::seen_colour_statistics, and added to it after embedding
+      std::vector<std::vector<long>> seen_colour_statistics;
+      // reused for building the graphs of states
+      graph_generator::GraphOverlay graph_overlay;
+      // threads that embed_impl may use within a graph, which is only more than one for graphs that
+      // are embedded one at a time instead of in parallel with other graphs
+      int n_threads = 1;
+      // workspaces of those threads, which embed_impl merges into this one
+      std::vector<EmbeddingWorkspace> thread_workspaces;
+      std::unique_ptr<EmbeddingScratch> scratch;
+    };
+
     class Features {
      protected:
       // configurations [saved]
@@ -60,11 +76,19 @@ namespace wlplan {
       int iterations;  // equivalently, layers
       std::string pruning;
       bool multiset_hash;
+      // configurations of subclasses, which are made by save_config() when saving and kept after
+      // loading for their load constructors to read [saved]
+      json extra_config;
 
       // colouring [saved]
       VecColourHash colour_hash;
       std::unordered_map<int, int> colour_to_layer;
       std::vector<std::set<int>> layer_to_colours;
+      int n_colours;  // cached size of colour_hash over all layers
+
+      // read-only copy of colour_hash for embedding, which is emptied while frozen
+      std::vector<FrozenColourHash> frozen_colour_hash;
+      bool frozen;
 
       // unseen colouring [optinally saved]
       VecColourHash colour_hash_unseen;
@@ -83,6 +107,14 @@ namespace wlplan {
       std::shared_ptr<planning::Domain> domain;
       std::shared_ptr<graph_generator::GraphGenerator> graph_generator;
       std::shared_ptr<NeighbourContainer> neighbour_container;
+      EmbeddingWorkspace workspace;
+      int n_threads;
+      // intermediate colourings, graphs and colour statistics are spilled to this directory during
+      // collection if not empty, otherwise they are kept in memory
+      std::string spill_directory;
+      // MaxSAT solver for pruning, see new_maxsat_solver(), and its time limit in seconds
+      std::string maxsat_solver;
+      double maxsat_time_limit;
       bool collected;
       bool collecting;
       bool pruned;
@@ -96,30 +128,83 @@ namespace wlplan {
       // for iteration j = 0, ..., iterations - 1
       std::vector<std::vector<long>> seen_colour_statistics;
 	  
-      // For computing equivalent features
-      // [i][j] denotes count for color i in state j
-      std::vector<std::map<int, int>> colour_statistics;
-
-      // get hashed colour if it exists, and constructs it if it doesn't
-      int get_colour_hash(const std::vector<int> &colour, const int iteration, int data_index=-99);
+      // For computing equivalent features, sealed before pruning
+      ColourStatistics colour_statistics;
+
+      // get hashed colour if it exists, and constructs it if it doesn't, where count occurrences of
+      // the colour are counted at once
+      int get_colour_hash(const ColourKey colour,
+                          const int iteration,
+                          int data_index = -99,
+                          int count = 1);
       // fast ver. that assumes no unseen colours (e.g. collecting), and does not store itr info
-      int get_colour_hash_fast(const std::vector<int> &colour, const int iteration);
+      int get_colour_hash_fast(const ColourKey colour, const int iteration);
+      // counts another occurrence of a colour found in the colour hash, as get_colour_hash does
+      void count_colour(const int colour, const int data_index = -99) {
+        colour_statistics.add(colour, data_index);
+      }
+
+      // adds new colours from collecting an iteration in parallel to the colour hash in order of
+      // first occurrence, so that colours are numbered as in sequential collection, and replaces
+      // provisional colours in graph_colours[i] which belongs to data index i
+      void add_concurrent_colours(const ConcurrentColourHash &hash,
+                                  const int iteration,
+                                  ColouringStore &graph_colours);
 
       // reformat colour hash based on colours to throw out
       VecColourHash new_colour_hash() const;
+      void set_colour_hash(VecColourHash &&colour_hash);
+      // copy of the colour hash whether or not it is frozen
+      VecColourHash get_colour_hash_layers() const;
       std::vector<std::set<int>> new_layer_to_colours() const;
       std::map<int, int> remap_colour_hash(std::set<int> &to_prune);
 
       // check if configuration is valid
       void check_valid_configuration();
 
+      // adds configurations that only a subclass has to config
+      virtual void save_config(json &) const {}
+      json get_extra_config() const;
+
+      // loading saved models for the constructor, where binary models are memory mapped
+      void load_json(const std::string &filename);
+      void load_binary(const std::string &filename);
+      static void create_parent_directory(const std::string &filename);
+
       // common init for initialisation and loading from file
       void initialise_variables();
+      std::shared_ptr<NeighbourContainer> new_neighbour_container() const;
+
+      // workspaces for embedding, with statistics added back to Features once done
+      EmbeddingWorkspace new_workspace() const;
+      void merge_workspace(EmbeddingWorkspace &workspace);
+      // adds the colour counts and statistics of a thread workspace to the workspace it helps
+      void merge_workspace(EmbeddingWorkspace &thread_workspace, EmbeddingWorkspace &target) const;
+      // the first n workspaces of workspace.thread_workspaces, which are made when first needed
+      void reserve_thread_workspaces(EmbeddingWorkspace &workspace, const int n) const;
+
+      // number of threads to use when embedding multiple graphs
+      int get_n_embedding_threads() const;
+
+      // embed graphs in parallel and pass each (row index, embedding) to write_row, which may be
+      // called concurrently for different rows
+      void embed_dataset_rows(const data::DomainDataset &dataset,
+                              const std::function<void(size_t, Embedding &&)> &write_row);
+      void embed_graph_rows(const std::vector<graph_generator::Graph> &graphs,
+                            const std::function<void(size_t, Embedding &&)> &write_row);
+      // states are of the problem that is set
+      void embed_state_rows(const std::vector<planning::State> &states,
+                            const std::function<void(size_t, Embedding &&)> &write_row);
+      void write_dense_row(Embedding &&x, double *row, const size_t n_cols) const;
+
+      // embeds a single graph on the calling thread
+      Embedding embed_single(const std::shared_ptr<graph_generator::Graph> &graph);
 
       // main virtual functions
       virtual void collect_impl(const std::vector<graph_generator::Graph> &graphs) = 0;
-	    virtual void collect_impl(const std::vector<data::ProblemDataset> &data) = 0;
-      virtual Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) = 0;
+      virtual void collect_impl(data::ProblemSource &source) = 0;
+      virtual Embedding embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                   EmbeddingWorkspace &workspace) = 0;
 
      public:
       Features(const std::string feature_name,
@@ -138,10 +223,15 @@ namespace wlplan {
       /* Feature generation functions */
 
       // convert states to graphs
-      std::vector<graph_generator::Graph> to_graphs(const data::DomainDataset dataset);
+      std::vector<graph_generator::Graph> to_graphs(const data::DomainDataset &dataset);
 
       // collect training colours
-      void collect_from_dataset(const data::DomainDataset dataset);
+      void collect_from_dataset(const data::DomainDataset &dataset);
+      // streams problems from the source, which is read once, so that generated graphs are kept in
+      // a ColouringStore between iterations instead of all datasets being held in memory; the
+      // store holds every graph and colouring in memory unless a spill directory is set, so
+      // memory is only bounded with set_spill_directory
+      void collect_from_source(data::ProblemSource &source);
       void collect(const std::vector<graph_generator::Graph> &graphs);
       // for novelty heuristics
       void layer_redundancy_check();
@@ -149,11 +239,26 @@ namespace wlplan {
       // embedding assumes training is done, and returns a feature matrix X
       std::vector<Embedding> embed_dataset(const data::DomainDataset &dataset);
       std::vector<Embedding> embed_graphs(const std::vector<graph_generator::Graph> &graphs);
+      // feature matrix with get_n_features() columns as CSR buffers
+      CSRMatrix embed_dataset_csr(const data::DomainDataset &dataset);
+      CSRMatrix embed_graphs_csr(const std::vector<graph_generator::Graph> &graphs);
+      // writes the feature matrix into a caller owned row-major n_rows x n_cols array
+      void embed_dataset_dense(const data::DomainDataset &dataset,
+                               double *X,
+                               const size_t n_rows,
+                               const size_t n_cols);
+      void embed_graphs_dense(const std::vector<graph_generator::Graph> &graphs,
+                              double *X,
+                              const size_t n_rows,
+                              const size_t n_cols);
       Embedding embed_graph(const graph_generator::Graph &graph);
       Embedding embed_state(const planning::State &state);
+      Embedding embed_state(const planning::InternedState &state);
       Embedding embed(const std::shared_ptr<graph_generator::Graph> &graph);
 
-      void add_colour_to_x(int colour, int iteration, Embedding &x);
+      void add_colour_to_x(int colour, int iteration, EmbeddingWorkspace &workspace);
+      // adds count occurrences of the colour at once
+      void add_colour_to_x(int colour, int iteration, EmbeddingWorkspace &workspace, int count);
 
       EmbeddingVec convert_embedding_to_vector(const Embedding &embedding) const {
       EmbeddingVec vec(get_n_features(), 0);
@@ -166,11 +271,10 @@ namespace wlplan {
 
       // output maps equivalent features to the same group
       std::map<int, int> get_equivalence_groups();
-      void prune_this_iteration(int iteration,
-                                std::vector<Embedding> &cur_colours);
+      void prune_this_iteration(int iteration, ColouringStore &cur_colours);
       void prune_bulk();
 
-      std::set<int> prune_collapse_layer(int iteration, std::vector<Embedding> &cur_colours);
+      std::set<int> prune_collapse_layer(int iteration, std::vector<Colouring> &cur_colours);
       std::set<int> prune_collapse_layer_greedy(int iteration);
       std::set<int> prune_collapse_layer_maxsat(int iteration);
       std::set<int>
@@ -183,6 +287,13 @@ namespace wlplan {
       double predict(const std::shared_ptr<graph_generator::Graph> &graph);
       double predict(const graph_generator::Graph &graph);
       double predict(const planning::State &state);
+      double predict(const planning::InternedState &state);
+      // heuristic values of several states of the problem that is set, or of several graphs, which
+      // are computed with get_n_threads() threads
+      std::vector<double> predict_batch(const std::vector<planning::State> &states);
+      std::vector<double> predict_batch(const std::vector<graph_generator::Graph> &graphs);
+      // dot product of the weights with a sparse embedding
+      double predict_embedding(const Embedding &embedding) const;
 
       void set_weights(const std::vector<double> &weights);
       std::vector<double> get_weights() const;
@@ -198,9 +309,25 @@ namespace wlplan {
       std::set<int> get_iteration_colours(int iteration) const {
         return layer_to_colours.at(iteration);
       }
-      StrColourHash get_colour_hash_list() { return int_to_str_colour_hash(colour_hash); }
+      StrColourHash get_colour_hash_list() {
+        return int_to_str_colour_hash(get_colour_hash_layers());
+      }
       int get_n_relation() { return domain->get_predicate_arity(); }
       bool get_multiset_hash() const { return multiset_hash; }
+      int get_n_threads() const { return n_threads; }
+      void set_n_threads(const int n_threads);
+      std::string get_spill_directory() const { return spill_directory; }
+      void set_spill_directory(const std::string &spill_directory) {
+        this->spill_directory = spill_directory;
+      }
+      std::string get_maxsat_solver() const { return maxsat_solver; }
+      void set_maxsat_solver(const std::string &maxsat_solver) {
+        this->maxsat_solver = maxsat_solver;
+      }
+      double get_maxsat_time_limit() const { return maxsat_time_limit; }
+      void set_maxsat_time_limit(const double maxsat_time_limit) {
+        this->maxsat_time_limit = maxsat_time_limit;
+      }
 
       /* Util functions */
 
@@ -208,6 +335,12 @@ namespace wlplan {
       void be_quiet();
       void set_save_unseen_colours(const std::string &filename);
 
+      // Replaces the colour hash with a compact read-only version for faster embedding and
+      // prediction, after which colours can no longer be collected until unfreeze() is called.
+      void freeze();
+      void unfreeze();
+      bool is_frozen() const { return frozen; }
+
       // get string representation of WL colours agnostic to the number of collected colours
       std::string get_string_representation(const Embedding &embedding);
       std::string get_string_representation(const planning::State &state);
@@ -220,7 +353,7 @@ namespace wlplan {
       StrColourHash int_to_str_colour_hash(VecColourHash int_colour_hash) const;
 
       // statistics functions
-      int get_n_colours() const;
+      int get_n_colours() const { return n_colours; }
       int get_n_colours_unseen() const;
       virtual int get_n_features() const = 0;
       std::vector<long> get_seen_counts() const { return seen_colour_statistics[1]; };
@@ -232,8 +365,18 @@ namespace wlplan {
       std::vector<std::set<int>> get_layer_to_colours() const;
       std::unordered_map<int, int> get_colour_to_layer() const { return colour_to_layer; };
 
+      // saves as JSON, which any version can load; the binary format is opt-in by save_binary
       void save(const std::string &filename);
       void save(const std::string &filename, const std::vector<double> &weights);
+      void save_json(const std::string &filename);
+      // versioned binary format that is loaded from a memory mapped file by inserting its table
+      // arrays into new colour hashes without parsing text, where compress_keys delta and varint
+      // encodes the tables to reduce file size
+      void save_binary(const std::string &filename, const bool compress_keys = false);
+
+      // helpers for loading either format
+      static bool is_binary_model(const std::string &filename);
+      static std::string read_feature_name(const std::string &filename);
 
       void save_unseen_to_file(const std::string &filename);
       void load_unseen_from_file(const std::string &filename);
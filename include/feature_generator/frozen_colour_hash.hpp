@@ -0,0 +1,77 @@
+#ifndef FEATURE_GENERATOR_FROZEN_COLOUR_HASH_HPP
+#define FEATURE_GENERATOR_FROZEN_COLOUR_HASH_HPP
+
+#include "colour_hash.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Read-only version of a ColourHash for embedding after features are collected. Entries are
+    // sorted by fingerprint with keys in a contiguous arena, and a directory indexed by the top
+    // fingerprint bits gives the range of entries to check, so there are no empty slots. A small
+    // bit filter on the fingerprint rejects most unseen keys before the directory is accessed.
+    class FrozenColourHash {
+     public:
+      FrozenColourHash() : FrozenColourHash(ColourHash()) {}
+
+      explicit FrozenColourHash(const ColourHash &colour_hash);
+
+      size_t size() const { return values.size(); }
+
+      inline int find(const ColourKey key) const {
+        const uint64_t fingerprint = colour_fingerprint(key);
+        if (!filter_contains(fingerprint)) {
+          return ColourHash::NOT_FOUND;
+        }
+        const size_t bucket = fingerprint >> shift;
+        for (uint32_t i = directory[bucket]; i < directory[bucket + 1]; i++) {
+          if (fingerprints[i] == fingerprint && key_equals(i, key)) {
+            return values[i];
+          }
+        }
+        return ColourHash::NOT_FOUND;
+      }
+
+      // converts back to a ColourHash with entries inserted in order of colour
+      ColourHash to_colour_hash() const;
+
+     private:
+      std::vector<uint64_t> fingerprints;
+      std::vector<int> values;
+      // keys of entry i are arena[key_offsets[i]:key_offsets[i + 1]]
+      std::vector<int> arena;
+      std::vector<uint32_t> key_offsets;
+
+      // entries with fingerprint >> shift == b are in [directory[b], directory[b + 1])
+      std::vector<uint32_t> directory;
+      int shift;
+
+      // two bits per key with about 8 bits per key
+      std::vector<uint64_t> filter;
+      uint64_t filter_mask;
+
+      inline bool filter_contains(const uint64_t fingerprint) const {
+        const uint64_t i = fingerprint & filter_mask;
+        const uint64_t j = (fingerprint >> 24) & filter_mask;
+        return ((filter[i >> 6] >> (i & 63)) & (filter[j >> 6] >> (j & 63)) & 1) != 0;
+      }
+
+      inline bool key_equals(const size_t entry, const ColourKey key) const {
+        const uint32_t begin = key_offsets[entry];
+        if (key_offsets[entry + 1] - begin != key.size()) {
+          return false;
+        }
+        for (size_t i = 0; i < key.size(); i++) {
+          if (arena[begin + i] != key[i]) {
+            return false;
+          }
+        }
+        return true;
+      }
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_FROZEN_COLOUR_HASH_HPP
@@ -0,0 +1,132 @@
+#ifndef FEATURE_GENERATOR_LWL2_PAIR_NEIGHBOURS_HPP
+#define FEATURE_GENERATOR_LWL2_PAIR_NEIGHBOURS_HPP
+
+#include "../graph_generator/graph.hpp"
+
+#include <vector>
+
+#define NO_EDGE_COLOUR -1
+
+namespace wlplan {
+  namespace feature_generator {
+    // map pair where 0 <= i < j < n to vec index
+    inline int lwl2_pair_to_index_map(const int n, const int i, const int j) {
+      return j - i - 1 + (i * n) - (i * (i + 1)) / 2;
+    }
+
+    inline int get_n_lwl2_pairs(const int n_nodes) { return (n_nodes * (n_nodes - 1)) / 2; }
+
+    // Neighbours of the pairs {u, v} with u < v of a graph for 2-LWL, which are the nodes w other
+    // than u and v with an edge from u or v. Neighbourhoods are encoded in one flat int array so
+    // that they can be built once per graph and kept in a ColouringStore across iterations:
+    //   [n_nodes, n_pair_entries, node offsets, sorted neighbours of nodes, pair offsets, entries]
+    // where each neighbour w of a pair is stored as the indices of the pairs {u, w} and {v, w}.
+    // If that takes more than a given number of ints, n_pair_entries is -1 and pair neighbourhoods
+    // are instead merged from the sorted neighbours of u and v whenever they are visited.
+    class LWL2PairNeighbours {
+     public:
+      static constexpr int ON_THE_FLY = -1;
+
+      // appends the encoding of the graph to data, storing at most max_entries pair entries
+      static void encode(const graph_generator::Graph &graph,
+                         const long max_entries,
+                         std::vector<int> &data);
+
+      // view of an encoding, which must outlive this object
+      explicit LWL2PairNeighbours(const int *data);
+
+      int get_n_nodes() const { return n_nodes; }
+      bool is_stored() const { return pair_offsets != nullptr; }
+
+      // Calls f(pair_uw, pair_vw) for each neighbour w of the pair {u, v} with u < v at the given
+      // pair index, and stops early and returns false once f returns false.
+      template <typename F>
+      bool for_each(const int u, const int v, const int index, F &&f) const {
+        if (is_stored()) {
+          for (int j = pair_offsets[index]; j < pair_offsets[index + 1]; j += 2) {
+            if (!f(pair_entries[j], pair_entries[j + 1])) {
+              return false;
+            }
+          }
+          return true;
+        }
+
+        const int *a = node_neighbours + node_offsets[u];
+        const int *a_end = node_neighbours + node_offsets[u + 1];
+        const int *b = node_neighbours + node_offsets[v];
+        const int *b_end = node_neighbours + node_offsets[v + 1];
+        while (a != a_end || b != b_end) {
+          int w;
+          if (b == b_end || (a != a_end && *a < *b)) {
+            w = *a++;
+          } else if (a == a_end || *b < *a) {
+            w = *b++;
+          } else {
+            w = *a++;
+            b++;
+          }
+          if (w == u || w == v) {
+            continue;
+          }
+          const int pair_uw = u < w ? lwl2_pair_to_index_map(n_nodes, u, w)
+                                    : lwl2_pair_to_index_map(n_nodes, w, u);
+          const int pair_vw = v < w ? lwl2_pair_to_index_map(n_nodes, v, w)
+                                    : lwl2_pair_to_index_map(n_nodes, w, v);
+          if (!f(pair_uw, pair_vw)) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+     private:
+      int n_nodes;
+      const int *node_offsets;
+      const int *node_neighbours;
+      const int *pair_offsets;
+      const int *pair_entries;
+    };
+
+    // Pairs {u, v} with u < v of a graph for sparse 2-LWL, which are the pairs with a path of at
+    // most radius edges from u to v or from v to u, and their neighbours as for 2-LWL. All other
+    // pairs are far and are not stored. The flat int array is encoded as
+    //   [n_nodes, n_pairs, (u, v, edge label) of each pair, pair offsets, entries]
+    // where entries are the indices of the pairs {u, w} and {v, w} of each neighbour w, with
+    // FAR_PAIR for far pairs. Pairs are ordered as in lwl2_pair_to_index_map.
+    class SparseLWL2PairNeighbours {
+     public:
+      static constexpr int FAR_PAIR = -1;
+
+      // appends the encoding of the graph to data
+      static void
+      encode(const graph_generator::Graph &graph, const int radius, std::vector<int> &data);
+
+      // view of an encoding, which must outlive this object
+      explicit SparseLWL2PairNeighbours(const int *data);
+
+      int get_n_pairs() const { return n_pairs; }
+      int get_u(const int pair) const { return pairs[3 * pair]; }
+      int get_v(const int pair) const { return pairs[3 * pair + 1]; }
+      int get_edge_label(const int pair) const { return pairs[3 * pair + 2]; }
+
+      // calls f(pair_uw, pair_vw) for each neighbour w of the pair, where far pairs are FAR_PAIR,
+      // and stops early and returns false once f returns false
+      template <typename F> bool for_each(const int pair, F &&f) const {
+        for (int j = pair_offsets[pair]; j < pair_offsets[pair + 1]; j += 2) {
+          if (!f(pair_entries[j], pair_entries[j + 1])) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+     private:
+      int n_pairs;
+      const int *pairs;
+      const int *pair_offsets;
+      const int *pair_entries;
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_LWL2_PAIR_NEIGHBOURS_HPP
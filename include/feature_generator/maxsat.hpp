@@ -1,44 +1,122 @@
 #ifndef FEATURE_GENERATOR_MAXSAT_HPP
 #define FEATURE_GENERATOR_MAXSAT_HPP
 
-#include <map>
-#include <set>
+#include <initializer_list>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace wlplan {
   namespace feature_generator {
-    struct MaxSatClause {
-      std::vector<int> variables;
-      std::vector<bool> negated;
-      int weight;
-      bool hard;
+    // Weighted partial MaxSAT problem. Clauses are stored back to back as DIMACS literals over
+    // variables 1, ..., get_n_variables(), and hard clauses have weight 0.
+    class MaxSatProblem {
+     public:
+      MaxSatProblem();
+
+      void add_hard(std::span<const int> literals);
+      void add_hard(std::initializer_list<int> literals) { add_hard(std::span(literals)); }
+      void add_soft(std::span<const int> literals, const long weight);
+      void add_soft(std::initializer_list<int> literals, const long weight) {
+        add_soft(std::span(literals), weight);
+      }
+
+      int get_n_variables() const { return n_variables; }
+      int get_n_clauses() const { return weights.size(); }
+      std::span<const int> get_clause(const int i) const {
+        return std::span(literals.data() + offsets[i], offsets[i + 1] - offsets[i]);
+      }
+      long get_weight(const int i) const { return weights[i]; }
+      bool is_hard(const int i) const { return weights[i] == 0; }
+
+      // sum of weights of violated soft clauses, or -1 if a hard clause is violated, where
+      // values[v] is the value of variable v
+      long get_cost(const std::vector<bool> &values) const;
 
-      MaxSatClause(const std::vector<int> &variables,
-                   const std::vector<bool> &negated,
-                   const int weight,
-                   const bool hard);
+      // WCNF in the format of the MaxSAT evaluations before 2022
+      std::string to_string() const;
 
-      int size() const { return variables.size(); }
+     private:
+      int n_variables;
+      std::vector<int> literals;
+      std::vector<size_t> offsets;
+      std::vector<long> weights;
 
-      std::string to_string(std::string hard_header) const;
+      void add_clause(std::span<const int> literals, const long weight);
     };
 
-    class MaxSatProblem {
-      std::set<int> variables;
-      std::vector<MaxSatClause> clauses;
+    struct MaxSatSolution {
+      // whether an assignment satisfying the hard clauses was found, and if it is optimal
+      bool found;
+      bool optimal;
+      long cost;
+      long lower_bound;
+      // values[v] is the value of variable v, and values[0] is unused
+      std::vector<bool> values;
+    };
+
+    class MaxSatSolver {
+     public:
+      virtual ~MaxSatSolver() = default;
+
+      // returns the best assignment found within time_limit seconds, or without a limit if
+      // time_limit <= 0
+      virtual MaxSatSolution solve(const MaxSatProblem &problem, const double time_limit) = 0;
+    };
+
+    // In-process core-guided solver using the OLL algorithm with totalizers on top of SatSolver.
+    // Lower bounds come from unsatisfiable cores, and models are also computed after exponentially
+    // spaced numbers of cores so that the best assignment so far can be returned on a time out.
+    class CoreGuidedMaxSatSolver : public MaxSatSolver {
+     public:
+      MaxSatSolution solve(const MaxSatProblem &problem, const double time_limit) override;
+    };
+
+    // Runs an external solver binary on a WCNF file, such as uwrmaxsat. The solver is stopped once
+    // the time limit is reached, and the last assignment it printed is returned.
+    class ExternalMaxSatSolver : public MaxSatSolver {
+     public:
+      explicit ExternalMaxSatSolver(const std::string &command);
+
+      MaxSatSolution solve(const MaxSatProblem &problem, const double time_limit) override;
 
-      std::map<int, int> call_solver();
+     private:
+      std::string command;
+    };
 
+    // "embedded" for the in-process solver, and otherwise the command of an external solver
+    std::shared_ptr<MaxSatSolver> new_maxsat_solver(const std::string &name);
+
+    // Fixes variables by unit propagation of the hard clauses, splits the remaining clauses into
+    // components that share no variables, and solves the components with up to n_threads threads.
+    // Large components go to the solver named as in new_maxsat_solver, and small ones are always
+    // solved in process since starting an external solver would cost more than solving them.
+    // Components without a solution, e.g. after a time out, take their values from the fallback
+    // assignment if one is set, and otherwise no assignment is found.
+    class DecomposingMaxSatSolver : public MaxSatSolver {
      public:
-      MaxSatProblem(const std::vector<MaxSatClause> &clauses);
+      DecomposingMaxSatSolver(const std::string &solver_name, const int n_threads);
+
+      MaxSatSolution solve(const MaxSatProblem &problem, const double time_limit) override;
 
-      int get_n_variables() const { return variables.size(); }
-      int get_n_clauses() const { return clauses.size(); }
+      // values[v] for each variable v of the problem, which must satisfy the hard clauses
+      void set_fallback(const std::vector<bool> &values) { fallback = values; }
 
-      std::map<int, int> solve();
+      // statistics of the last call to solve
+      int get_n_fixed_variables() const { return n_fixed_variables; }
+      int get_n_components() const { return n_components; }
+      int get_largest_component() const { return largest_component; }
+      int get_n_unsolved_components() const { return n_unsolved_components; }
 
-      std::string to_string();
+     private:
+      std::string solver_name;
+      int n_threads;
+      std::vector<bool> fallback;
+      int n_fixed_variables;
+      int n_components;
+      int largest_component;
+      int n_unsolved_components;
     };
   }  // namespace feature_generator
 }  // namespace wlplan
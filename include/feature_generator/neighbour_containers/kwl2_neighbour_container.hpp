@@ -22,6 +22,10 @@ namespace wlplan {
       std::vector<int> get_neighbour_colours(const std::vector<int> &colours) override;
       std::vector<int> remap(const std::vector<int> &input,
                              const std::map<int, int> &remap) override;
+
+     protected:
+      // 2-WL keys start with the colour of the pair instead of ending with it as WL keys do
+      std::vector<std::tuple<int, int, int>> deconstruct_pairs(const std::vector<int> &colours);
     };
   }  // namespace feature_generator
 }  // namespace wlplan
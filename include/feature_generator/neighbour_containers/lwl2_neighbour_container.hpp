@@ -3,16 +3,22 @@
 
 #include "kwl2_neighbour_container.hpp"
 
+#include <climits>
 #include <map>
 #include <set>
 #include <utility>
 
+// colour of all pairs that sparse 2-LWL does not colour, which is largest so that it is always
+// the second colour of a neighbour in keys
+#define FAR_PAIR_COLOUR INT_MAX
+
 namespace wlplan {
   namespace feature_generator {
     class LWL2NeighbourContainer : public KWL2NeighbourContainer {
      public:
       LWL2NeighbourContainer(bool multiset_hash);
 
+      std::vector<int> get_neighbour_colours(const std::vector<int> &colours) override;
       std::vector<int> remap(const std::vector<int> &input,
                              const std::map<int, int> &remap) override;
     };
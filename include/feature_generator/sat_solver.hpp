@@ -0,0 +1,121 @@
+#ifndef FEATURE_GENERATOR_SAT_SOLVER_HPP
+#define FEATURE_GENERATOR_SAT_SOLVER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    // Incremental CDCL SAT solver in the style of MiniSat, with two watched literals, first UIP
+    // clause learning, VSIDS branching with phase saving, Luby restarts and learnt clause deletion.
+    // Literals are DIMACS style: variable v > 0 is true in literal v and false in literal -v.
+    // Solving under assumptions returns a subset of the assumptions that cannot hold together if
+    // the formula is unsatisfiable under them, which is used by core-guided MaxSAT.
+    class SatSolver {
+     public:
+      enum class Result { SAT, UNSAT, UNKNOWN };
+
+      SatSolver();
+
+      // returns the new variable, which is get_n_variables()
+      int new_variable();
+      int get_n_variables() const { return (int)assigns.size(); }
+
+      // returns false if the formula has become unsatisfiable, variables must already exist
+      bool add_clause(std::span<const int> literals);
+
+      // value a variable is first branched on
+      void set_polarity(const int variable, const bool value);
+
+      // returns UNKNOWN if the deadline or the number of conflicts given by a nonzero
+      // conflict_budget is reached first
+      Result solve(const std::vector<int> &assumptions,
+                   const Deadline deadline,
+                   const uint64_t conflict_budget = 0);
+
+      // value of a variable in the model found by the last satisfiable solve()
+      bool get_value(const int variable) const { return model[variable - 1]; }
+
+      // assumptions that are unsatisfiable together after an unsatisfiable solve(), which is empty
+      // if the formula is unsatisfiable without assumptions
+      const std::vector<int> &get_core() const { return core; }
+
+     private:
+      // literal 2 * var + 1 is the negation of literal 2 * var, for variables from 0
+      static int to_literal(const int dimacs) {
+        return dimacs > 0 ? 2 * (dimacs - 1) : 2 * (-dimacs - 1) + 1;
+      }
+      static int to_dimacs(const int lit) { return lit & 1 ? -((lit >> 1) + 1) : (lit >> 1) + 1; }
+
+      struct Clause {
+        std::vector<int> lits;
+        double activity;
+        bool learnt;
+        bool deleted;
+      };
+
+      struct Watcher {
+        int cref;
+        int blocker;
+      };
+
+      // 1 if true, 0 if false, -1 if unassigned
+      int8_t value(const int lit) const {
+        const int8_t v = assigns[lit >> 1];
+        return v < 0 ? v : v ^ (lit & 1);
+      }
+      int decision_level() const { return (int)trail_lim.size(); }
+
+      bool ok;
+      std::vector<Clause> clauses;
+      std::vector<std::vector<Watcher>> watches;  // clauses watching each literal
+      std::vector<int8_t> assigns;
+      std::vector<bool> polarity;
+      std::vector<int> level;
+      std::vector<int> reason;
+      std::vector<int> trail;
+      std::vector<int> trail_lim;
+      size_t qhead;
+
+      std::vector<double> activity;
+      double var_inc;
+      double clause_inc;
+      // binary max heap of unassigned variables by activity, where heap_index is -1 if not in it
+      std::vector<int> heap;
+      std::vector<int> heap_index;
+
+      std::vector<char> seen;
+      size_t n_learnts;
+      double max_learnts;
+      uint64_t n_conflicts;
+
+      std::vector<bool> model;
+      std::vector<int> core;
+
+      void heap_up(int i);
+      void heap_down(int i);
+      void heap_insert(const int var);
+      int heap_pop();
+
+      void bump_variable(const int var);
+      void bump_clause(Clause &clause);
+
+      void enqueue(const int lit, const int cref);
+      int propagate();
+      void attach(const int cref);
+      void analyse(int confl, std::vector<int> &learnt, int &backtrack_level);
+      void analyse_final(const int failed);
+      void cancel_until(const int target_level);
+      void reduce_learnts();
+      Result search(const std::vector<int> &assumptions,
+                    const uint64_t max_conflicts,
+                    const Deadline deadline);
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_SAT_SOLVER_HPP
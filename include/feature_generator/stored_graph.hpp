@@ -0,0 +1,40 @@
+#ifndef FEATURE_GENERATOR_STORED_GRAPH_HPP
+#define FEATURE_GENERATOR_STORED_GRAPH_HPP
+
+#include "../graph_generator/graph.hpp"
+
+#include <set>
+#include <vector>
+
+namespace wlplan {
+  namespace feature_generator {
+    // Graph encoded in one flat int array, so that graphs generated from a problem source can be
+    // built once and kept in a ColouringStore across iterations instead of being regenerated. The
+    // encoding is
+    //   [n_nodes, node colours, offsets, edge labels, neighbours]
+    // with the same compressed sparse row layout as graph_generator::Graph. Node values and names
+    // are not stored.
+    class StoredGraph {
+     public:
+      // appends the encoding of the graph to data
+      static void encode(const graph_generator::Graph &graph, std::vector<int> &data);
+
+      // view of an encoding, which must outlive this object
+      explicit StoredGraph(const int *data);
+
+      const int *nodes;
+      const int *offsets;
+      const int *edge_labels;
+      const int *neighbours;
+
+      int get_n_nodes() const { return n_nodes; }
+      int get_degree(const int u) const { return offsets[u + 1] - offsets[u]; }
+      std::set<int> get_nodes_set() const;
+
+     private:
+      int n_nodes;
+    };
+  }  // namespace feature_generator
+}  // namespace wlplan
+
+#endif  // FEATURE_GENERATOR_STORED_GRAPH_HPP
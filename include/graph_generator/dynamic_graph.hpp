@@ -0,0 +1,136 @@
+#ifndef GRAPH_GENERATOR_DYNAMIC_GRAPH_HPP
+#define GRAPH_GENERATOR_DYNAMIC_GRAPH_HPP
+
+#include "graph.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wlplan::graph_generator {
+  // Changes made to a DynamicGraph while it was recording, which can be undone and redone.
+  class DynamicGraphLog {
+   public:
+    enum class ChangeType { ADD_NODE, REMOVE_NODE, CHANGE_COLOUR };
+
+    struct Change {
+      ChangeType type;
+      int node;
+      int64_t key;
+      int old_colour;
+      int new_colour;
+      // edges of an added or removed node are edges[edges_start, edges_start + n_edges)
+      int edges_start;
+      int n_edges;
+      // where the node and its edges were stored, so that undoing restores the exact layout
+      int block;
+      bool new_index;
+      bool new_block;
+    };
+
+    std::vector<Change> changes;
+    std::vector<std::pair<int, int>> edges;
+
+    void clear();
+    size_t size() const { return changes.size(); }
+  };
+
+  // Graph that is changed in place with stable node indices, used for turning the graph of a state
+  // into the graph of a successor state without rebuilding it. The nodes of an immutable CSR base
+  // graph, which is shared between copies, can only change colour. Nodes added on top of it are
+  // identified by a key and store their edges as one contiguous block in a flat pool, where each
+  // edge is also linked into a list of edges into its target. Edges of added nodes are undirected,
+  // so removing a node only touches its own edges. Indices and blocks of removed nodes are reused
+  // by nodes that are added later.
+  //
+  // Changes are recorded into a log while one is set. Undoing them in reverse order restores the
+  // exact layout of the graph, so redoing a log on the graph it was recorded from gives the same
+  // node indices again.
+  class DynamicGraph {
+   public:
+    explicit DynamicGraph(const std::shared_ptr<const Graph> &base);
+
+    // adds a node with edges (r, v) in both directions, where the nodes v must exist
+    int add_node(const int64_t key, const int colour, const std::vector<std::pair<int, int>> &edges);
+    void change_node_colour(const int u, const int new_colour);
+    // removes an added node and its edges, and returns its neighbours, which fails if a node that
+    // was added after it has an edge to it
+    std::vector<int> remove_node(const int64_t key);
+
+    // returns -1 if there is no added node with this key
+    int get_node_index(const int64_t key) const;
+
+    int get_node_colour(const int u) const { return nodes[u]; }
+    bool is_removed(const int u) const { return removed[u]; }
+    // upper bound on node indices, including removed nodes
+    int get_n_indices() const { return nodes.size(); }
+    int get_n_nodes() const { return nodes.size() - free_nodes.size(); }
+
+    // calls f(r, v) for every edge (r, v) from u
+    template <typename F>
+    void for_each_edge(const int u, F &&f) const;
+
+    // CSR graph of the nodes that are not removed, in order of their index
+    std::shared_ptr<Graph> to_graph() const;
+
+    // changes are appended to the log until it is set to nullptr
+    void set_log(DynamicGraphLog *log) { this->log = log; }
+    // the graph must be as it was after the log was recorded
+    void undo(const DynamicGraphLog &log);
+    // the graph must be as it was before the log was recorded
+    void redo(const DynamicGraphLog &log);
+
+   private:
+    std::shared_ptr<const Graph> base;
+    int n_base_nodes;
+
+    std::vector<int> nodes;
+    std::vector<char> removed;
+    std::vector<int> free_nodes;
+    std::unordered_map<int64_t, int> key_to_node;
+
+    // for added nodes u, their edges are pool entries [blocks[j], blocks[j] + degrees[j]) where
+    // j = u - n_base_nodes, and pool entry e is the edge (edge_labels[e], edge_targets[e]) from
+    // edge_sources[e]
+    std::vector<int> blocks;
+    std::vector<int> degrees;
+    std::vector<int> edge_sources;
+    std::vector<int> edge_labels;
+    std::vector<int> edge_targets;
+    std::vector<int> next_in;
+    std::vector<int> prev_in;
+    // first pool entry of the list of edges into each node, or -1
+    std::vector<int> first_in;
+    // free_blocks[d] are unused blocks of d pool entries
+    std::vector<std::vector<int>> free_blocks;
+
+    DynamicGraphLog *log;
+
+    void insert_node(const DynamicGraphLog::Change &node, const std::pair<int, int> *edges);
+    void erase_node(const DynamicGraphLog::Change &node);
+    void apply(const DynamicGraphLog::Change &change, const DynamicGraphLog &log, bool forward);
+    void link_block(const int u);
+    void unlink_block(const int u);
+  };
+
+  template <typename F>
+  inline void DynamicGraph::for_each_edge(const int u, F &&f) const {
+    if (u < n_base_nodes) {
+      for (int j = base->offsets[u]; j < base->offsets[u + 1]; j++) {
+        f(base->edge_labels[j], base->neighbours[j]);
+      }
+    } else {
+      const int block = blocks[u - n_base_nodes];
+      for (int e = block; e < block + degrees[u - n_base_nodes]; e++) {
+        f(edge_labels[e], edge_targets[e]);
+      }
+    }
+    for (int e = first_in[u]; e != -1; e = next_in[e]) {
+      f(edge_labels[e], edge_sources[e]);
+    }
+  }
+}  // namespace wlplan::graph_generator
+
+#endif  // GRAPH_GENERATOR_DYNAMIC_GRAPH_HPP
@@ -0,0 +1,69 @@
+#ifndef GRAPH_GENERATOR_GRAPH_BUILDER_HPP
+#define GRAPH_GENERATOR_GRAPH_BUILDER_HPP
+
+#include "graph.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wlplan::graph_generator {
+  // Mutable graph used by graph generators for constructing graphs. Edges are stored as a flat
+  // list of (u, r, v) triples in insertion order, so that the modifications made for a state can be
+  // undone by truncating the node and edge lists, and converted into a CSR Graph in linear time.
+  class GraphBuilder {
+   public:
+    GraphBuilder(bool store_node_names);
+    // copy that only keeps the node names if store_node_names is true
+    GraphBuilder(const GraphBuilder &other, bool store_node_names);
+    GraphBuilder(const GraphBuilder &other) = default;
+
+    // returns the node index
+    int add_node(const std::string &node_name, int colour, double value);
+    int add_node(const std::string &node_name, int colour);
+
+    // does not assume undirected graph, so this is called twice for adding undirected edges
+    void add_edge(const int u, const int r, const int v);
+    void add_edge(const std::string &u_name, const int r, const std::string &v_name);
+
+    void change_node_colour(const int u, const int new_colour);
+    void change_node_colour(const std::string &node_name, const int new_colour);
+    void change_node_value(const int u, const double new_value);
+    void change_node_value(const std::string &node_name, const double new_value);
+
+    int get_node_colour(const int u) const { return nodes[u]; }
+
+    // assumes we checked that the node exists
+    int get_node_index(const std::string &node_name) const;
+
+    int get_n_nodes() const { return nodes.size(); }
+    int get_n_edges() const { return edge_sources.size(); }
+
+    // removes all nodes and edges added after the builder had n_nodes nodes and n_edges edges
+    void truncate(const int n_nodes, const int n_edges);
+
+    // set to false when directly modifying the base graph to prevent excessive memory usage
+    void set_store_node_names(bool store_node_names) { this->store_node_names = store_node_names; }
+    bool get_store_node_names() const { return store_node_names; }
+
+    // converts to a CSR graph, optionally reusing the memory of an existing graph
+    std::shared_ptr<Graph> to_graph() const;
+    void to_graph(Graph &graph) const;
+
+   private:
+    friend class GraphOverlay;
+
+    std::vector<int> nodes;
+    std::vector<double> node_values;
+    std::vector<int> edge_sources;
+    std::vector<int> edge_labels;
+    std::vector<int> edge_targets;
+
+    bool store_node_names;
+    std::unordered_map<std::string, int> node_to_index_;
+    std::vector<std::string> index_to_node_;
+  };
+}  // namespace wlplan::graph_generator
+
+#endif  // GRAPH_GENERATOR_GRAPH_BUILDER_HPP
@@ -7,7 +7,10 @@
 #include "../planning/domain.hpp"
 #include "../planning/problem.hpp"
 #include "../planning/state.hpp"
+#include "dynamic_graph.hpp"
 #include "graph.hpp"
+#include "graph_builder.hpp"
+#include "graph_overlay.hpp"
 
 #include <map>
 #include <memory>
@@ -30,20 +33,48 @@ namespace wlplan::graph_generator {
     virtual void set_problem(const planning::Problem &problem) = 0;
 
     // Makes a copy of the base graph and makes the necessary modifications. Assumes the state is
-    // from the problem that is set but does not check this.
+    // from the problem that is set but does not check this. Only reads the generator's variables,
+    // so it may be called concurrently from multiple threads between calls to set_problem().
     virtual std::shared_ptr<Graph> to_graph(const planning::State &state) = 0;
     virtual std::shared_ptr<Graph> to_graph(const planning::State &state,
                                             const planning::ActionPointers &actions) = 0;
-    std::shared_ptr<Graph> to_graph(const planning::State &state, const planning::Actions &actions);
-    std::vector<graph_generator::Graph> to_graphs(const data::DomainDataset dataset);
+    // By default converts the actions to pointers, which action graphs can avoid by overriding it
+    virtual std::shared_ptr<Graph> to_graph(const planning::State &state,
+                                            const planning::Actions &actions);
+    // Variant of to_graph(state) that builds the graph on top of the base graph in a caller owned
+    // overlay, e.g. one per thread, whose memory is reused between states. The returned graph has
+    // no node names and is only valid until the overlay is used again. By default this calls
+    // to_graph(state).
+    virtual std::shared_ptr<Graph> to_graph(const planning::State &state, GraphOverlay &overlay);
+    // Graph of a state given by atom ids of the problem that is set. By default this converts the
+    // state back to atoms, and generators that work on ids directly override it.
+    virtual std::shared_ptr<Graph> to_graph(const planning::InternedState &state);
+    std::vector<graph_generator::Graph> to_graphs(const data::DomainDataset &dataset);
 
     // Optimised variant of to_graph() but requires calling reset_graph() after. Does not make a
     // copy of the base graph and instead modifies it directly, and undoing the modifications with
-    // reset_graph(). Only supported for state-based graphs. Not yet supported for action graphs.
-    // To skip this implementation, you can use to_graph(state) and make reset_graph() blank.
+    // reset_graph(). The returned graph reuses the memory of the previously returned graph, so it
+    // is only valid until the next call. To skip this implementation, you can use to_graph(state)
+    // and make reset_graph() blank.
     virtual std::shared_ptr<Graph> to_graph_opt(const planning::State &state) = 0;
+    // Variant of to_graph_opt() for action graphs, which is to_graph_opt(state) by default for
+    // graphs that do not depend on actions.
+    virtual std::shared_ptr<Graph> to_graph_opt(const planning::State &state,
+                                                const planning::ActionPointers &actions);
     virtual void reset_graph() const = 0;
 
+    // Graph of a state with stable node indices for updating embeddings incrementally, which
+    // apply_transition() changes in place into the graph of a successor state. Returns the nodes
+    // whose colour or edges changed, including removed nodes. Like to_graph(), these only read the
+    // generator's variables. Not supported by default.
+    virtual std::shared_ptr<DynamicGraph> to_dynamic_graph(const planning::State &state) const;
+    virtual std::vector<int> apply_transition(DynamicGraph &graph,
+                                              const std::vector<planning::Atom> &add_atoms,
+                                              const std::vector<planning::Atom> &del_atoms) const;
+
+    // the problem that is set, which is a new object after every call to set_problem()
+    std::shared_ptr<const planning::Problem> get_problem() const { return problem; }
+
     // Used for converting to GNN inputs in Python.
     virtual int get_n_features() const = 0;
     virtual int get_n_relations() const = 0;
@@ -62,10 +93,13 @@ namespace wlplan::graph_generator {
     std::map<int, std::string> colour_to_description;
 
     // Problem specific variables
-    std::shared_ptr<Graph> base_graph;
+    std::shared_ptr<GraphBuilder> base_graph;
     std::shared_ptr<planning::Problem> problem;
     std::unordered_set<std::string> positive_goal_names;
     std::unordered_set<std::string> negative_goal_names;
+
+    // Output memory reused by to_graph_opt()
+    std::shared_ptr<Graph> opt_graph;
   };
 }  // namespace wlplan::graph_generator
 
@@ -26,9 +26,14 @@ namespace wlplan::graph_generator {
     // Graph generation
     std::shared_ptr<Graph> to_graph(const planning::State &state) override;
     std::shared_ptr<Graph> to_graph(const planning::State &state,
-                                    const planning::ActionPointers &actions);
-    std::shared_ptr<Graph> to_graph_opt(const planning::State &state) override;
-    void reset_graph() const override;
+                                    const planning::ActionPointers &actions) override;
+    std::shared_ptr<Graph> to_graph(const planning::State &state,
+                                    const planning::Actions &actions) override;
+    // action nodes and edges are added after those of the state, so ILGGenerator::reset_graph()
+    // also undoes them
+    std::shared_ptr<Graph> to_graph_opt(const planning::State &state,
+                                        const planning::ActionPointers &actions) override;
+    std::shared_ptr<DynamicGraph> to_dynamic_graph(const planning::State &state) const override;
 
     // Graph features
     int get_n_features() const override { return colour_to_description.size(); };
@@ -38,6 +43,9 @@ namespace wlplan::graph_generator {
 
    private:
     std::unordered_map<std::string, int> schema_to_graph_colour;
+
+    // A is a container of actions or of pointers to actions
+    template <typename A> void add_actions(GraphBuilder &graph, const A &actions) const;
   };
 }  // namespace wlplan::graph_generator
 
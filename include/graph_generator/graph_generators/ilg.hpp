@@ -15,6 +15,7 @@
 #include "../graph.hpp"
 #include "../graph_generator.hpp"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -47,8 +48,14 @@ namespace wlplan::graph_generator {
     std::shared_ptr<Graph> to_graph(const planning::State &state) override;
     std::shared_ptr<Graph> to_graph(const planning::State &state,
                                     const planning::ActionPointers &actions) override;
+    std::shared_ptr<Graph> to_graph(const planning::State &state, GraphOverlay &overlay) override;
+    std::shared_ptr<Graph> to_graph(const planning::InternedState &state) override;
     std::shared_ptr<Graph> to_graph_opt(const planning::State &state) override;
     void reset_graph() const override;
+    std::shared_ptr<DynamicGraph> to_dynamic_graph(const planning::State &state) const override;
+    std::vector<int> apply_transition(DynamicGraph &graph,
+                                      const std::vector<planning::Atom> &add_atoms,
+                                      const std::vector<planning::Atom> &del_atoms) const override;
 
     // Graph features
     int get_n_features() const override { return colour_to_description.size(); };
@@ -58,16 +65,48 @@ namespace wlplan::graph_generator {
     int fact_colour(const int predicate_idx, const ILGFactDescription &fact_description) const;
     int fact_colour(const planning::Atom &atom, const ILGFactDescription &fact_description) const;
 
+    /* Tables built by set_problem() so that graphs are built without hashing names. Objects are
+       the first nodes of the base graph, so the node of an object is its id, and positive goal
+       nodes come before negative goal nodes. Goal atom nodes are looked up by atom id in a table
+       over all atom ids if the problem has few enough of them, and otherwise by binary search. */
+    static const planning::AtomId MAX_DENSE_GOAL_TABLE = 1 << 20;
+    bool dense_goal_table;
+    std::vector<int> goal_node_table;
+    std::vector<planning::AtomId> sorted_goal_ids;
+    std::vector<int> sorted_goal_nodes;
+    int first_neg_goal_node;
+    // returns -1 if the atom is not a goal
+    int get_goal_node(const planning::AtomId atom_id) const;
+
+    // base graph of the graphs returned by to_dynamic_graph()
+    std::shared_ptr<const Graph> dynamic_base_graph;
+
     /* For modifying the base graph and redoing its changes */
-    int n_nodes_added;
-    std::vector<int> n_edges_added;
+    int n_base_nodes;
+    int n_base_edges;
     std::vector<int> pos_goal_changed;
     std::vector<int> neg_goal_changed;
     std::vector<int> pos_goal_changed_pred;
     std::vector<int> neg_goal_changed_pred;
-    std::shared_ptr<Graph> modify_graph_from_state(const planning::State &state,
-                                                   const std::shared_ptr<Graph> graph,
-                                                   bool store_changes);
+    std::shared_ptr<GraphBuilder>
+    modify_graph_from_state(const planning::State &state,
+                            const std::shared_ptr<GraphBuilder> graph,
+                            bool store_changes);
+    std::shared_ptr<GraphBuilder>
+    modify_graph_from_state(const planning::InternedState &state,
+                            const std::shared_ptr<GraphBuilder> graph,
+                            bool store_changes);
+    void modify_graph_from_state(const planning::State &state, GraphOverlay &overlay);
+
+   private:
+    void start_changes(GraphBuilder &graph, bool store_changes);
+    // atom_name is only used if the graph stores node names, and object_ids is scratch memory
+    template <typename G>
+    void add_atom(G &graph,
+                  const planning::AtomId atom_id,
+                  const std::string &atom_name,
+                  bool store_changes,
+                  std::vector<int> &object_ids);
   };
 
   inline int ILGGenerator::fact_colour(const int predicate_idx,
@@ -76,6 +115,17 @@ namespace wlplan::graph_generator {
     return domain.types.size() + pred_idx + (int)fact_description;
   }
 
+  inline int ILGGenerator::get_goal_node(const planning::AtomId atom_id) const {
+    if (dense_goal_table) {
+      return goal_node_table[atom_id];
+    }
+    auto it = std::lower_bound(sorted_goal_ids.begin(), sorted_goal_ids.end(), atom_id);
+    if (it == sorted_goal_ids.end() || *it != atom_id) {
+      return -1;
+    }
+    return sorted_goal_nodes[it - sorted_goal_ids.begin()];
+  }
+
   inline int ILGGenerator::fact_colour(const planning::Atom &atom,
                                        const ILGFactDescription &fact_description) const {
     return fact_colour(domain.predicate_to_colour.at(atom.predicate->name), fact_description);
@@ -24,7 +24,10 @@ namespace wlplan::graph_generator {
     // Graph generation
     void set_problem(const planning::Problem &problem) override;
     std::shared_ptr<Graph> to_graph(const planning::State &state) override;
+    std::shared_ptr<Graph> to_graph(const planning::State &state, GraphOverlay &overlay) override;
+    std::shared_ptr<Graph> to_graph(const planning::InternedState &state) override;
     std::shared_ptr<Graph> to_graph_opt(const planning::State &state) override;
+    std::shared_ptr<DynamicGraph> to_dynamic_graph(const planning::State &state) const override;
 
     // Graph features
     int get_n_features() const override {
@@ -37,6 +40,10 @@ namespace wlplan::graph_generator {
 
    protected:
     std::unordered_map<std::string, int> fluent_to_colour;
+
+    // nodes of the base graph by fluent id and numeric goal index
+    std::vector<int> fluent_nodes;
+    std::vector<int> numeric_goal_nodes;
     int UNACHIEVED_GT_GOAL;
     int UNACHIEVED_GTEQ_GOAL;
     int UNACHIEVED_EQ_GOAL;
@@ -45,8 +52,13 @@ namespace wlplan::graph_generator {
     int ACHIEVED_EQ_GOAL;
 
     // Fluent values are given in every state.
-    std::shared_ptr<Graph> modify_graph_from_numerics(const planning::State &state,
-                                                      const std::shared_ptr<Graph> graph);
+    std::shared_ptr<GraphBuilder>
+    modify_graph_from_numerics(const std::vector<double> &fluent_values,
+                               const std::shared_ptr<GraphBuilder> graph);
+
+   private:
+    template <typename G>
+    void set_numeric_nodes(const std::vector<double> &fluent_values, G &graph) const;
   };
 }  // namespace wlplan::graph_generator
 
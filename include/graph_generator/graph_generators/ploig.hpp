@@ -33,7 +33,7 @@ namespace wlplan::graph_generator {
     std::shared_ptr<Graph> to_graph(const planning::State &state) override;
     std::shared_ptr<Graph> to_graph(const planning::State &state,
                                     const planning::ActionPointers &actions) override;
-    // TODO implement optimised variant
+    std::shared_ptr<Graph> to_graph(const planning::State &state, GraphOverlay &overlay) override;
     std::shared_ptr<Graph> to_graph_opt(const planning::State &state) override;
     void reset_graph() const override;
 
@@ -48,8 +48,13 @@ namespace wlplan::graph_generator {
     std::unordered_map<std::string, std::map<std::pair<int, int>, int>> ap_to_e_col;
 
     /* For modifying the base graph and redoing its changes */
-    std::shared_ptr<Graph> modify_graph_from_state(const planning::State &state,
-                                                   const std::shared_ptr<Graph> graph);
+    int n_base_edges;
+    std::shared_ptr<GraphBuilder>
+    modify_graph_from_state(const planning::State &state,
+                            const std::shared_ptr<GraphBuilder> graph);
+
+   private:
+    template <typename G> void add_state_edges(const planning::State &state, G &graph) const;
   };
 }  // namespace wlplan::graph_generator
 
@@ -0,0 +1,49 @@
+#ifndef GRAPH_GENERATOR_GRAPH_OVERLAY_HPP
+#define GRAPH_GENERATOR_GRAPH_OVERLAY_HPP
+
+#include "graph.hpp"
+#include "graph_builder.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wlplan::graph_generator {
+  // Changes of a graph on top of an immutable base graph, for building the graph of each state
+  // without copying the base graph. Only node colours and values are copied from the base graph,
+  // and added nodes and edges are stored separately. All memory, including the returned graph, is
+  // kept between calls to reset(), so an overlay reused for many states stops allocating once it
+  // has grown. It has the same methods as a GraphBuilder that does not store node names.
+  class GraphOverlay {
+   public:
+    GraphOverlay();
+
+    // the base graph must not change or be freed while the overlay is used
+    void reset(const GraphBuilder &base);
+
+    // node names are ignored
+    int add_node(const std::string &node_name, int colour, double value);
+    int add_node(const std::string &node_name, int colour);
+    void add_edge(const int u, const int r, const int v);
+    void change_node_colour(const int u, const int new_colour) { nodes[u] = new_colour; }
+    void change_node_value(const int u, const double new_value) { node_values[u] = new_value; }
+
+    int get_node_colour(const int u) const { return nodes[u]; }
+    int get_n_nodes() const { return nodes.size(); }
+    bool get_store_node_names() const { return false; }
+
+    // the returned graph is only valid until the next call to reset()
+    std::shared_ptr<Graph> to_graph();
+
+   private:
+    const GraphBuilder *base;
+    std::vector<int> nodes;
+    std::vector<double> node_values;
+    std::vector<int> edge_sources;
+    std::vector<int> edge_labels;
+    std::vector<int> edge_targets;
+    std::shared_ptr<Graph> graph;
+  };
+}  // namespace wlplan::graph_generator
+
+#endif  // GRAPH_GENERATOR_GRAPH_OVERLAY_HPP
@@ -4,12 +4,16 @@
 #include "object.hpp"
 #include "predicate.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace wlplan {
   namespace planning {
+    // dense integer id of a ground atom within a problem, see Problem::get_atom_id()
+    using AtomId = int64_t;
+
     class Atom {
      public:
       const std::shared_ptr<Predicate> predicate;
@@ -23,7 +27,9 @@ namespace wlplan {
       std::string to_pddl() const;
       std::string to_string() const;
 
-      bool operator==(const Atom &other) const { return to_string() == other.to_string(); }
+      bool operator==(const Atom &other) const {
+        return predicate->name == other.predicate->name && objects == other.objects;
+      }
     };
 
   }  // namespace planning
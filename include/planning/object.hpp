@@ -17,10 +17,11 @@ class Object {
     std::string get_type() const {return object_type; };
     std::string get_name() const {return object_name; };
 
-    bool operator==(const Object &other) const { return to_string() == other.to_string(); }
-    bool operator< (const Object &other) const { return to_string() < other.to_string(); }
-    bool operator> (const Object &other) const { return to_string() > other.to_string(); }
-    std::size_t hash() const { return std::hash<std::string>()(to_string()); }
+    // objects are identified by their name, which to_string() returns
+    bool operator==(const Object &other) const { return object_name == other.object_name; }
+    bool operator< (const Object &other) const { return object_name < other.object_name; }
+    bool operator> (const Object &other) const { return object_name > other.object_name; }
+    std::size_t hash() const { return std::hash<std::string>()(object_name); }
   };
 
 }  // namespace planning
@@ -32,7 +33,7 @@ struct std::hash<wlplan::planning::Object>
 {
   std::size_t operator()(const wlplan::planning::Object& k) const
   {
-    return std::hash<std::string>()(k.to_string());
+    return k.hash();
   }
 };
 
@@ -5,7 +5,9 @@
 #include "domain.hpp"
 #include "fluent.hpp"
 #include "numeric_condition.hpp"
+#include "state.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -17,6 +19,9 @@ namespace wlplan {
   namespace planning {
     using Assignment = std::vector<int>;
 
+    // interns atoms whose ids do not fit into 64 bits, see Problem::get_atom_id()
+    class AtomTable;
+
     class Problem {
      private:
       std::shared_ptr<Domain> domain;
@@ -26,6 +31,12 @@ namespace wlplan {
       std::unordered_set<Object> constant_objects_set;
       std::vector<Object> problem_objects;
       std::vector<Object> constant_objects;
+      std::vector<Object> id_to_object;
+
+      // atoms of predicate i have ids in [atom_id_offsets[i], atom_id_offsets[i + 1])
+      std::vector<AtomId> atom_id_offsets;
+      // nullptr unless atom ids overflow, and shared by copies so that they give the same ids
+      std::shared_ptr<AtomTable> atom_table;
 
       std::vector<Atom> statics;
       std::vector<Fluent> fluents;
@@ -94,6 +105,33 @@ namespace wlplan {
         return constant_objects_set.count(object);
       }
 
+      /* Dense integer ids of objects and ground atoms. Objects are numbered with constant objects
+         first. The id of an atom is an offset for its predicate plus its object ids read as digits
+         in base get_n_objects(), so atoms are interned and decoded by arithmetic alone and ids are
+         the same for every copy of the problem. Predicates are indexed as in Domain::predicates
+         and Domain::predicate_to_colour.
+
+         If there are too many objects for the ids of high arity predicates to fit into 64 bits,
+         atoms are instead numbered in a hash table in the order they are first seen, starting with
+         the goals. States that are embedded repeatedly should be interned once by intern_state(),
+         so that their atoms are not looked up by name again. */
+      int get_n_objects() const { return id_to_object.size(); }
+      int get_object_id(const Object &object) const { return object_to_id.at(object); }
+      const Object &get_object(const int object_id) const { return id_to_object.at(object_id); }
+
+      // all atom ids are less than this, which is the largest AtomId if atoms are in a table
+      AtomId get_n_atom_ids() const;
+      bool has_atom_table() const { return atom_table != nullptr; }
+      AtomId get_atom_id(const Atom &atom) const;
+      AtomId get_atom_id(const int predicate_idx, const std::vector<int> &object_ids) const;
+      int get_atom_predicate(const AtomId atom_id) const;
+      // overwrites object_ids so that callers can reuse its memory
+      void get_atom_object_ids(const AtomId atom_id, std::vector<int> &object_ids) const;
+      Atom get_atom(const AtomId atom_id) const;
+
+      InternedState intern_state(const State &state) const;
+      State get_state(const InternedState &state) const;
+
       std::string to_string() const;
 
       bool operator==(const Problem &other) const;
@@ -26,6 +26,23 @@ namespace wlplan {
 
       std::size_t hash() const;
     };
+
+    // State given by the ids of its atoms in the problem it belongs to, which avoids hashing and
+    // comparing atom and object names when generating graphs. Atom ids are kept sorted.
+    class InternedState {
+     public:
+      std::vector<AtomId> atom_ids;
+      std::vector<double> values;
+
+      InternedState(const std::vector<AtomId> &atom_ids, const std::vector<double> &values);
+      InternedState(const std::vector<AtomId> &atom_ids);
+
+      bool operator==(const InternedState &other) const {
+        return atom_ids == other.atom_ids && values == other.values;
+      }
+
+      std::size_t hash() const;
+    };
   }  // namespace planning
 }  // namespace wlplan
 
@@ -0,0 +1,223 @@
+#ifndef UTILS_BINARY_IO_HPP
+#define UTILS_BINARY_IO_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WLPLAN_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wlplan {
+  namespace utils {
+    // Read-only view of a whole file, which is memory mapped where supported and read into a
+    // buffer otherwise.
+    class MappedFile {
+     public:
+      explicit MappedFile(const std::string &filename) {
+#ifdef WLPLAN_HAS_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+          throw std::runtime_error("Cannot open file " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+          ::close(fd);
+          throw std::runtime_error("Cannot read file " + filename);
+        }
+        n_bytes = st.st_size;
+        if (n_bytes > 0) {
+          void *ptr = ::mmap(nullptr, n_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (ptr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot memory map file " + filename);
+          }
+          mapped = static_cast<const char *>(ptr);
+        }
+        ::close(fd);
+#else
+        std::ifstream i(filename, std::ios::binary);
+        if (!i) {
+          throw std::runtime_error("Cannot open file " + filename);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(i), std::istreambuf_iterator<char>());
+        n_bytes = buffer.size();
+#endif
+      }
+
+      ~MappedFile() {
+#ifdef WLPLAN_HAS_MMAP
+        if (mapped != nullptr) {
+          ::munmap(const_cast<char *>(mapped), n_bytes);
+        }
+#endif
+      }
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      const char *data() const {
+#ifdef WLPLAN_HAS_MMAP
+        return mapped;
+#else
+        return buffer.data();
+#endif
+      }
+      size_t size() const { return n_bytes; }
+
+     private:
+      size_t n_bytes = 0;
+#ifdef WLPLAN_HAS_MMAP
+      const char *mapped = nullptr;
+#else
+      std::vector<char> buffer;
+#endif
+    };
+
+    // maps signed integers to unsigned so that small magnitudes give short varints
+    inline uint64_t zigzag_encode(const int64_t x) {
+      return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63);
+    }
+    inline int64_t zigzag_decode(const uint64_t x) {
+      return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+    }
+
+    // Appends values in native byte order to a buffer, with varints in LEB128.
+    class BinaryWriter {
+     public:
+      template <typename T> void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+      }
+
+      template <typename T> void write_array(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write_bytes(reinterpret_cast<const char *>(values.data()), sizeof(T) * values.size());
+      }
+
+      void write_bytes(const char *bytes, const size_t n) {
+        buffer.insert(buffer.end(), bytes, bytes + n);
+      }
+
+      void write_string(const std::string &str) {
+        write<uint32_t>(str.size());
+        buffer.insert(buffer.end(), str.begin(), str.end());
+      }
+
+      void write_varint(uint64_t value) {
+        while (value >= 0x80) {
+          buffer.push_back((char)((value & 0x7f) | 0x80));
+          value >>= 7;
+        }
+        buffer.push_back((char)value);
+      }
+
+      // pads with zeros so that the next value starts at a multiple of alignment
+      void align(const size_t alignment) {
+        buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, 0);
+      }
+
+      size_t size() const { return buffer.size(); }
+      const char *data() const { return buffer.data(); }
+
+      void save(const std::string &filename) const {
+        std::ofstream o(filename, std::ios::binary);
+        if (!o) {
+          throw std::runtime_error("Cannot open file " + filename);
+        }
+        // closing flushes the buffer, so that failed writes such as to a full disk are seen
+        o.write(buffer.data(), buffer.size());
+        o.close();
+        if (!o) {
+          throw std::runtime_error("Cannot write file " + filename);
+        }
+      }
+
+     private:
+      std::vector<char> buffer;
+    };
+
+    // Reads values written by BinaryWriter, and throws if reading past the end of the data.
+    class BinaryReader {
+     public:
+      BinaryReader(const char *data, const size_t size) : data(data), n_bytes(size), pos(0) {}
+
+      template <typename T> T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T ret;
+        std::memcpy(&ret, take(sizeof(T)), sizeof(T));
+        return ret;
+      }
+
+      template <typename T> std::vector<T> read_array(const size_t n) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (n > (n_bytes - pos) / sizeof(T)) {
+          throw std::runtime_error("Unexpected end of binary data");
+        }
+        std::vector<T> ret(n);
+        std::memcpy(ret.data(), take(sizeof(T) * n), sizeof(T) * n);
+        return ret;
+      }
+
+      // pointer to n values in place, which requires the data to be aligned for T
+      template <typename T> const T *view_array(const size_t n) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (n > (n_bytes - pos) / sizeof(T)) {
+          throw std::runtime_error("Unexpected end of binary data");
+        }
+        const char *ret = take(sizeof(T) * n);
+        if (reinterpret_cast<uintptr_t>(ret) % alignof(T) != 0) {
+          throw std::runtime_error("Misaligned binary data");
+        }
+        return reinterpret_cast<const T *>(ret);
+      }
+
+      std::string read_string() {
+        const uint32_t n = read<uint32_t>();
+        return std::string(take(n), n);
+      }
+
+      uint64_t read_varint() {
+        uint64_t ret = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+          const uint8_t byte = *take(1);
+          ret |= (uint64_t)(byte & 0x7f) << shift;
+          if (byte < 0x80) {
+            return ret;
+          }
+        }
+        throw std::runtime_error("Invalid varint in binary data");
+      }
+
+      void align(const size_t alignment) { take((alignment - pos % alignment) % alignment); }
+
+      bool at_end() const { return pos == n_bytes; }
+
+      const char *take(const size_t n) {
+        if (n > n_bytes - pos) {
+          throw std::runtime_error("Unexpected end of binary data");
+        }
+        const char *ret = data + pos;
+        pos += n;
+        return ret;
+      }
+
+     private:
+      const char *data;
+      size_t n_bytes;
+      size_t pos;
+    };
+  }  // namespace utils
+}  // namespace wlplan
+
+#endif  // UTILS_BINARY_IO_HPP
@@ -0,0 +1,62 @@
+#ifndef UTILS_PARALLEL_HPP
+#define UTILS_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wlplan {
+  namespace utils {
+    // Calls f(thread_id, i) for i = 0, ..., n - 1 with up to n_threads threads, where
+    // 0 <= thread_id < n_threads can be used to index per-thread memory. Indices are handed out one
+    // at a time from a shared counter so that a few expensive items do not hold up other threads.
+    // The first exception thrown by f is rethrown on the calling thread.
+    template <typename F>
+    void parallel_for(const size_t n, const int n_threads, F &&f) {
+      int n_workers = (int)std::min<size_t>(std::max(n_threads, 1), n);
+      if (n_workers <= 1) {
+        for (size_t i = 0; i < n; i++) {
+          f(0, i);
+        }
+        return;
+      }
+
+      std::atomic<size_t> next(0);
+      std::exception_ptr error = nullptr;
+      std::mutex error_mutex;
+      auto worker = [&](const int thread_id) {
+        size_t i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) < n) {
+          try {
+            f(thread_id, i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error == nullptr) {
+              error = std::current_exception();
+            }
+            next.store(n, std::memory_order_relaxed);
+          }
+        }
+      };
+
+      std::vector<std::thread> threads;
+      threads.reserve(n_workers - 1);
+      for (int thread_id = 1; thread_id < n_workers; thread_id++) {
+        threads.emplace_back(worker, thread_id);
+      }
+      worker(0);
+      for (auto &thread : threads) {
+        thread.join();
+      }
+
+      if (error != nullptr) {
+        std::rethrow_exception(error);
+      }
+    }
+  }  // namespace utils
+}  // namespace wlplan
+
+#endif  // UTILS_PARALLEL_HPP
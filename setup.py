@@ -23,6 +23,7 @@ def main():
         "_wlplan",
         source_files,
         define_macros=[("WLPLAN_VERSION", __version__)],
+        cxx_std=20,
     )
     if os.getenv(key="DEBUG", default="").upper() in ["ON", "1", "YES", "TRUE", "Y"]:
         ext_module._add_cflags(["-DDEBUGMODE", "-O0", "-g"])
@@ -0,0 +1,19 @@
+#include "../../include/data/problem_source.hpp"
+
+namespace wlplan {
+  namespace data {
+    DomainDatasetSource::DomainDatasetSource(const DomainDataset &dataset)
+        : dataset(dataset), index(0) {}
+
+    void DomainDatasetSource::reset() { index = 0; }
+
+    std::shared_ptr<const ProblemDataset> DomainDatasetSource::next() {
+      if (index >= dataset.data.size()) {
+        return nullptr;
+      }
+      // non-owning pointer as the dataset outlives the source
+      return std::shared_ptr<const ProblemDataset>(std::shared_ptr<const ProblemDataset>(),
+                                                   &dataset.data[index++]);
+    }
+  }  // namespace data
+}  // namespace wlplan
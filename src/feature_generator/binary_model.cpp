@@ -0,0 +1,275 @@
+#include "../../include/feature_generator/features.hpp"
+#include "../../include/utils/binary_io.hpp"
+#include "../../include/utils/nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using json = nlohmann::json;
+
+/* Binary model format, with values in native byte order and arrays aligned to their element size
+
+  char[8]   magic "WLPLANB"
+  uint32    format version
+  uint32    0x01020304 to check byte order
+  uint32    flags, with bit 0 set if colour tables are compressed
+  string    package_version, feature_name, graph_representation, pruning
+  int32     iterations
+  uint8     multiset_hash
+  string    configurations of subclasses as JSON text
+  string    domain as JSON text
+  uint32    number of layers, followed by a colour table for each layer
+  uint64    number of colour_to_layer entries
+  int32[]   colours, followed by int32[] layers
+  uint64    number of weights
+  double[]  weights
+
+  Strings are a uint32 length followed by the characters. An uncompressed colour table is
+
+  uint64    number of entries n
+  uint64    total length of keys
+  int32[n]  colour of each entry
+  uint32[n] key length of each entry
+  int32[]   concatenated keys
+
+  and a compressed table replaces the arrays by a uint64 number of bytes followed by, for each
+  entry, the colour minus the previous colour, the key length, and each key element minus the
+  previous element of the key, all as zigzag varints. Tables are stored in insertion order, so
+  colours are mostly increasing and neighbouring key elements are often close.
+*/
+
+namespace wlplan {
+  namespace feature_generator {
+    const char BINARY_MODEL_MAGIC[8] = {'W', 'L', 'P', 'L', 'A', 'N', 'B', '\0'};
+    const uint32_t BINARY_MODEL_VERSION = 1;
+    const uint32_t BINARY_MODEL_BYTE_ORDER = 0x01020304;
+    const uint32_t BINARY_MODEL_COMPRESSED = 1;
+
+    std::shared_ptr<planning::Domain> domain_from_json(const json &j);
+
+    // reads the header up to and including the flags
+    uint32_t read_binary_model_header(utils::BinaryReader &reader) {
+      if (std::memcmp(reader.take(sizeof(BINARY_MODEL_MAGIC)),
+                      BINARY_MODEL_MAGIC,
+                      sizeof(BINARY_MODEL_MAGIC)) != 0) {
+        throw std::runtime_error("File is not a binary WLPlan model.");
+      }
+      const uint32_t version = reader.read<uint32_t>();
+      if (version != BINARY_MODEL_VERSION) {
+        throw std::runtime_error("Binary model format version " + std::to_string(version) +
+                                 " is not supported by this version of WLPlan.");
+      }
+      if (reader.read<uint32_t>() != BINARY_MODEL_BYTE_ORDER) {
+        throw std::runtime_error("Binary model was saved on a machine with another byte order.");
+      }
+      return reader.read<uint32_t>();
+    }
+
+    void write_colour_table(utils::BinaryWriter &writer,
+                            const ColourHash &colour_hash,
+                            const bool compress_keys) {
+      std::vector<int> values;
+      std::vector<uint32_t> key_lengths;
+      std::vector<int> keys;
+      values.reserve(colour_hash.size());
+      key_lengths.reserve(colour_hash.size());
+      for (const auto &[key, value] : colour_hash) {
+        values.push_back(value);
+        key_lengths.push_back(key.size());
+        keys.insert(keys.end(), key.begin(), key.end());
+      }
+      writer.write<uint64_t>(values.size());
+      writer.write<uint64_t>(keys.size());
+
+      if (!compress_keys) {
+        writer.align(4);
+        writer.write_array(values);
+        writer.write_array(key_lengths);
+        writer.write_array(keys);
+        return;
+      }
+
+      utils::BinaryWriter table;
+      int prev_value = 0;
+      size_t key_i = 0;
+      for (size_t i = 0; i < values.size(); i++) {
+        table.write_varint(utils::zigzag_encode((int64_t)values[i] - prev_value));
+        prev_value = values[i];
+        table.write_varint(key_lengths[i]);
+        int prev_element = 0;
+        for (uint32_t k = 0; k < key_lengths[i]; k++, key_i++) {
+          table.write_varint(utils::zigzag_encode((int64_t)keys[key_i] - prev_element));
+          prev_element = keys[key_i];
+        }
+      }
+      writer.write<uint64_t>(table.size());
+      writer.write_bytes(table.data(), table.size());
+    }
+
+    ColourHash read_colour_table(utils::BinaryReader &reader, const bool compressed) {
+      const uint64_t n_entries = reader.read<uint64_t>();
+      const uint64_t n_key_ints = reader.read<uint64_t>();
+      ColourHash ret;
+      ret.reserve(n_entries);
+
+      if (!compressed) {
+        // keys are inserted from the mapped arrays, which are not copied into vectors first
+        reader.align(4);
+        const int *values = reader.view_array<int>(n_entries);
+        const uint32_t *key_lengths = reader.view_array<uint32_t>(n_entries);
+        const int *keys = reader.view_array<int>(n_key_ints);
+        uint64_t offset = 0;
+        for (uint64_t i = 0; i < n_entries; i++) {
+          if (key_lengths[i] > n_key_ints - offset) {
+            throw std::runtime_error("Invalid colour table in binary model.");
+          }
+          ret.insert(ColourKey(keys + offset, key_lengths[i]), values[i]);
+          offset += key_lengths[i];
+        }
+        if (offset != n_key_ints) {
+          throw std::runtime_error("Invalid colour table in binary model.");
+        }
+        return ret;
+      }
+
+      const uint64_t n_bytes = reader.read<uint64_t>();
+      utils::BinaryReader table(reader.take(n_bytes), n_bytes);
+      std::vector<int> key;
+      int64_t value = 0;
+      uint64_t offset = 0;
+      for (uint64_t i = 0; i < n_entries; i++) {
+        value += utils::zigzag_decode(table.read_varint());
+        const uint64_t key_length = table.read_varint();
+        if (key_length > n_key_ints - offset) {
+          throw std::runtime_error("Invalid colour table in binary model.");
+        }
+        offset += key_length;
+        key.clear();
+        int64_t element = 0;
+        for (uint64_t k = 0; k < key_length; k++) {
+          element += utils::zigzag_decode(table.read_varint());
+          key.push_back(element);
+        }
+        ret.insert(key, value);
+      }
+      // the table must decode to exactly its stated number of bytes and key elements
+      if (offset != n_key_ints || !table.at_end()) {
+        throw std::runtime_error("Invalid colour table in binary model.");
+      }
+      return ret;
+    }
+
+    bool Features::is_binary_model(const std::string &filename) {
+      std::ifstream i(filename, std::ios::binary);
+      char magic[sizeof(BINARY_MODEL_MAGIC)];
+      if (!i.read(magic, sizeof(magic))) {
+        return false;
+      }
+      return std::memcmp(magic, BINARY_MODEL_MAGIC, sizeof(magic)) == 0;
+    }
+
+    std::string Features::read_feature_name(const std::string &filename) {
+      if (!is_binary_model(filename)) {
+        std::ifstream i(filename);
+        json j;
+        i >> j;
+        return j.at("feature_name").get<std::string>();
+      }
+      utils::MappedFile file(filename);
+      utils::BinaryReader reader(file.data(), file.size());
+      read_binary_model_header(reader);
+      reader.read_string();  // package_version
+      return reader.read_string();
+    }
+
+    void Features::save_binary(const std::string &filename, const bool compress_keys) {
+      utils::BinaryWriter writer;
+      writer.write_bytes(BINARY_MODEL_MAGIC, sizeof(BINARY_MODEL_MAGIC));
+      writer.write<uint32_t>(BINARY_MODEL_VERSION);
+      writer.write<uint32_t>(BINARY_MODEL_BYTE_ORDER);
+      writer.write<uint32_t>(compress_keys ? BINARY_MODEL_COMPRESSED : 0);
+
+      writer.write_string(package_version);
+      writer.write_string(feature_name);
+      writer.write_string(graph_representation);
+      writer.write_string(pruning);
+      writer.write<int32_t>(iterations);
+      writer.write<uint8_t>(multiset_hash);
+      writer.write_string(get_extra_config().dump());
+      writer.write_string(domain->to_json().dump());
+
+      // colour_hash may have more layers if iterations were lowered after collecting
+      const VecColourHash layers = get_colour_hash_layers();
+      writer.write<uint32_t>(iterations + 1);
+      for (int itr = 0; itr < iterations + 1; itr++) {
+        write_colour_table(writer, layers[itr], compress_keys);
+      }
+
+      std::vector<std::pair<int, int>> colour_layers(colour_to_layer.begin(),
+                                                     colour_to_layer.end());
+      std::sort(colour_layers.begin(), colour_layers.end());
+      std::vector<int> colours, colour_layer_indices;
+      for (const auto &[colour, layer] : colour_layers) {
+        colours.push_back(colour);
+        colour_layer_indices.push_back(layer);
+      }
+      writer.write<uint64_t>(colours.size());
+      writer.align(4);
+      writer.write_array(colours);
+      writer.write_array(colour_layer_indices);
+
+      writer.write<uint64_t>(weights.size());
+      writer.align(8);
+      writer.write_array(weights);
+
+      create_parent_directory(filename);
+      writer.save(filename);
+    }
+
+    void Features::load_binary(const std::string &filename) {
+      utils::MappedFile file(filename);
+      utils::BinaryReader reader(file.data(), file.size());
+      const uint32_t flags = read_binary_model_header(reader);
+
+      // load configurations
+      package_version = reader.read_string();
+      feature_name = reader.read_string();
+      graph_representation = reader.read_string();
+      pruning = reader.read_string();
+      iterations = reader.read<int32_t>();
+      multiset_hash = reader.read<uint8_t>();
+      extra_config = json::parse(reader.read_string());
+
+      // initialise domain object
+      domain = domain_from_json(json::parse(reader.read_string()));
+
+      // load colours
+      const uint32_t n_layers = reader.read<uint32_t>();
+      if ((int)n_layers != iterations + 1) {
+        throw std::runtime_error("Number of colour tables in binary model does not match the "
+                                 "number of iterations.");
+      }
+      VecColourHash layers;
+      for (uint32_t itr = 0; itr < n_layers; itr++) {
+        layers.push_back(read_colour_table(reader, flags & BINARY_MODEL_COMPRESSED));
+      }
+      set_colour_hash(std::move(layers));
+
+      const uint64_t n_colours_to_layer = reader.read<uint64_t>();
+      reader.align(4);
+      const int *colours = reader.view_array<int>(n_colours_to_layer);
+      const int *colour_layer_indices = reader.view_array<int>(n_colours_to_layer);
+      colour_to_layer.clear();
+      colour_to_layer.reserve(n_colours_to_layer);
+      for (uint64_t i = 0; i < n_colours_to_layer; i++) {
+        colour_to_layer[colours[i]] = colour_layer_indices[i];
+      }
+
+      // load weights if they exist
+      const uint64_t n_weights = reader.read<uint64_t>();
+      reader.align(8);
+      weights = reader.read_array<double>(n_weights);
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -0,0 +1,83 @@
+#include "../../include/feature_generator/colour_hash.hpp"
+
+#include <stdexcept>
+
+namespace wlplan {
+  namespace feature_generator {
+    ColourHash::ColourHash() : key_offsets({0}), slots(8, Slot{0, EMPTY}), mask(7) {}
+
+    void ColourHash::reserve(size_t n_entries) {
+      values.reserve(n_entries);
+      fingerprints.reserve(n_entries);
+      key_offsets.reserve(n_entries + 1);
+      size_t n_slots = slots.size();
+      while (n_entries * 4 > n_slots * 3) {
+        n_slots *= 2;
+      }
+      if (n_slots != slots.size()) {
+        rehash(n_slots);
+      }
+    }
+
+    int ColourHash::at(const ColourKey key) const {
+      int ret = find(key);
+      if (ret == NOT_FOUND) {
+        throw std::out_of_range("Colour key does not exist in ColourHash");
+      }
+      return ret;
+    }
+
+    size_t ColourHash::find_slot(const ColourKey key, const uint64_t fingerprint) const {
+      for (size_t i = fingerprint & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.entry == EMPTY ||
+            (slot.fingerprint == fingerprint && key_equals(slot.entry, key))) {
+          return i;
+        }
+      }
+    }
+
+    std::pair<int, bool>
+    ColourHash::insert(const ColourKey key, const int value, const uint64_t fingerprint) {
+      size_t i = find_slot(key, fingerprint);
+      if (slots[i].entry != EMPTY) {
+        return {values[slots[i].entry], false};
+      }
+
+      // keep the load factor at most 3/4
+      if ((size() + 1) * 4 > slots.size() * 3) {
+        rehash(slots.size() * 2);
+        i = find_slot(key, fingerprint);
+      }
+
+      slots[i] = Slot{fingerprint, (int)size()};
+      arena.insert(arena.end(), key.begin(), key.end());
+      key_offsets.push_back(arena.size());
+      values.push_back(value);
+      fingerprints.push_back(fingerprint);
+      return {value, true};
+    }
+
+    void ColourHash::insert_or_assign(const ColourKey key, const int value) {
+      uint64_t fingerprint = colour_fingerprint(key);
+      size_t i = find_slot(key, fingerprint);
+      if (slots[i].entry != EMPTY) {
+        values[slots[i].entry] = value;
+      } else {
+        insert(key, value, fingerprint);
+      }
+    }
+
+    void ColourHash::rehash(size_t n_slots) {
+      slots.assign(n_slots, Slot{0, EMPTY});
+      mask = n_slots - 1;
+      for (size_t entry = 0; entry < size(); entry++) {
+        size_t i = fingerprints[entry] & mask;
+        while (slots[i].entry != EMPTY) {
+          i = (i + 1) & mask;
+        }
+        slots[i] = Slot{fingerprints[entry], (int)entry};
+      }
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -0,0 +1,95 @@
+#include "../../include/feature_generator/colour_statistics.hpp"
+
+#include "../../include/feature_generator/colour_hash.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace wlplan {
+  namespace feature_generator {
+    ColourStatistics::ColourStatistics(const std::string &spill_directory)
+        : spill_directory(spill_directory), n_sealed(0), runs(spill_directory) {}
+
+    void ColourStatistics::reset(const int n_colours, const std::string &spill_directory) {
+      this->spill_directory = spill_directory;
+      n_sealed = 0;
+      runs = ColouringStore(spill_directory);
+      signatures.clear();
+      open.clear();
+      const std::vector<int> no_runs;
+      for (int i = 0; i < n_colours; i++) {
+        append_runs(no_runs);
+      }
+      n_sealed = n_colours;
+    }
+
+    void ColourStatistics::resize(const int n_colours) {
+      if (n_colours > size()) {
+        open.resize(n_colours - n_sealed);
+      }
+    }
+
+    void ColourStatistics::append_runs(const std::vector<int> &colour_runs) {
+      uint64_t h = mix64(colour_runs.size() / RUN_SIZE);
+      for (const int value : colour_runs) {
+        h = mix64(h ^ (uint32_t)value);
+      }
+      runs.push_back(colour_runs);
+      signatures.push_back(h);
+    }
+
+    void ColourStatistics::seal() {
+      std::vector<int> colour_runs;
+      for (const auto &counts : open) {
+        colour_runs.clear();
+        for (const auto &[data_index, count] : counts) {
+          // extend the last run if this index continues it with the same count
+          if (!colour_runs.empty()) {
+            int *last = colour_runs.data() + colour_runs.size() - RUN_SIZE;
+            if (last[2] == count && last[0] + last[1] == data_index) {
+              last[1]++;
+              continue;
+            }
+          }
+          colour_runs.insert(colour_runs.end(), {data_index, 1, count});
+        }
+        append_runs(colour_runs);
+      }
+      n_sealed += open.size();
+      open = std::vector<std::vector<std::pair<int, int>>>();
+      runs.release();
+    }
+
+    long ColourStatistics::get_total_count(const int colour) const {
+      long total = 0;
+      for (const int *run = runs.begin(colour); run != runs.end(colour); run += RUN_SIZE) {
+        total += (long)run[1] * run[2];
+      }
+      return total;
+    }
+
+    bool ColourStatistics::equal(const int colour1, const int colour2) const {
+      if (signatures[colour1] != signatures[colour2]) {
+        return false;
+      }
+      return std::equal(
+          runs.begin(colour1), runs.end(colour1), runs.begin(colour2), runs.end(colour2));
+    }
+
+    ColourStatistics ColourStatistics::select(const std::vector<int> &colours) const {
+      if (!open.empty()) {
+        throw std::runtime_error("Colour statistics must be sealed before selecting colours");
+      }
+      ColourStatistics ret(spill_directory);
+      std::vector<int> colour_runs;
+      for (const int colour : colours) {
+        runs.load(colour, colour_runs);
+        ret.runs.push_back(colour_runs);
+        ret.signatures.push_back(signatures[colour]);
+      }
+      ret.n_sealed = colours.size();
+      ret.runs.release();
+      return ret;
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -0,0 +1,110 @@
+#include "../../include/feature_generator/colouring_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace wlplan {
+  namespace feature_generator {
+    ColouringStore::ColouringStore(const std::string &spill_directory)
+        : offsets({0}), data(nullptr), capacity(0), fd(-1) {
+      if (spill_directory.empty()) {
+        return;
+      }
+      std::string path = spill_directory + "/wlplan_colours_XXXXXX";
+      fd = mkstemp(path.data());
+      if (fd == -1) {
+        throw std::runtime_error("Could not create spill file in " + spill_directory + ": " +
+                                 std::strerror(errno));
+      }
+      unlink(path.c_str());
+    }
+
+    ColouringStore::ColouringStore(ColouringStore &&other) noexcept
+        : offsets({0}), data(nullptr), capacity(0), fd(-1) {
+      *this = std::move(other);
+    }
+
+    ColouringStore &ColouringStore::operator=(ColouringStore &&other) noexcept {
+      // the buffer of a moved vector is kept, so data stays valid when not spilled
+      std::swap(offsets, other.offsets);
+      std::swap(data, other.data);
+      std::swap(capacity, other.capacity);
+      std::swap(memory, other.memory);
+      std::swap(fd, other.fd);
+      return *this;
+    }
+
+    ColouringStore::~ColouringStore() {
+      if (fd != -1) {
+        if (data != nullptr) {
+          munmap(data, capacity * sizeof(int));
+        }
+        close(fd);
+      }
+    }
+
+    void ColouringStore::reserve(const size_t new_capacity) {
+      if (fd == -1) {
+        memory.resize(new_capacity);
+        data = memory.data();
+        capacity = new_capacity;
+        return;
+      }
+
+      if (ftruncate(fd, new_capacity * sizeof(int)) != 0) {
+        throw std::runtime_error(std::string("Could not grow spill file: ") + std::strerror(errno));
+      }
+      if (data != nullptr) {
+        munmap(data, capacity * sizeof(int));
+      }
+      void *mapped =
+          mmap(nullptr, new_capacity * sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (mapped == MAP_FAILED) {
+        data = nullptr;
+        capacity = 0;
+        throw std::runtime_error(std::string("Could not map spill file: ") + std::strerror(errno));
+      }
+      data = static_cast<int *>(mapped);
+      capacity = new_capacity;
+    }
+
+    void ColouringStore::push_back(const Colouring &colours) {
+      size_t start = offsets.back();
+      size_t required = start + colours.size();
+      if (required > capacity) {
+        reserve(std::max(required, 2 * capacity));
+      }
+      std::copy(colours.begin(), colours.end(), data + start);
+      offsets.push_back(required);
+    }
+
+    void ColouringStore::load(const size_t i, Colouring &colours) const {
+      colours.assign(data + offsets[i], data + offsets[i + 1]);
+    }
+
+    void ColouringStore::store(const size_t i, const Colouring &colours) {
+      if (colours.size() != offsets[i + 1] - offsets[i]) {
+        throw std::runtime_error("Colouring size changed during collection");
+      }
+      std::copy(colours.begin(), colours.end(), data + offsets[i]);
+    }
+
+    void ColouringStore::release() {
+      if (fd == -1 || data == nullptr) {
+        return;
+      }
+      size_t bytes = capacity * sizeof(int);
+      if (msync(data, bytes, MS_SYNC) == 0) {
+        madvise(data, bytes, MADV_DONTNEED);
+      }
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
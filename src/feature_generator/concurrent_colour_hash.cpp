@@ -0,0 +1,77 @@
+#include "../../include/feature_generator/concurrent_colour_hash.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace wlplan {
+  namespace feature_generator {
+    ConcurrentColourHash::ConcurrentColourHash(const ColourHash &existing, const int n_threads)
+        : existing(existing) {
+      // a few shards per thread keeps contention low without too many small maps
+      int n_shards = 1;
+      while (n_shards < 8 * n_threads) {
+        n_shards *= 2;
+      }
+      for (int i = 0; i < n_shards; i++) {
+        shards.push_back(std::make_unique<Shard>());
+      }
+    }
+
+    int ConcurrentColourHash::get(const ColourKey colour, const uint64_t occurrence) {
+      const uint64_t fingerprint = colour_fingerprint(colour);
+
+      // existing colours are not modified while collecting an iteration, so no lock is needed
+      const int ret = existing.find(colour, fingerprint);
+      if (ret != ColourHash::NOT_FOUND) {
+        return ret;
+      }
+
+      // use the high bits for the shard as the low bits pick the slot within a shard
+      const size_t n_shards = shards.size();
+      const size_t shard_i = (fingerprint >> 32) & (n_shards - 1);
+      Shard &shard = *shards[shard_i];
+
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      const auto [index, inserted] =
+          shard.colours.insert(colour, shard.first_occurrence.size(), fingerprint);
+      if (inserted) {
+        shard.first_occurrence.push_back(occurrence);
+      } else if (occurrence < shard.first_occurrence[index]) {
+        shard.first_occurrence[index] = occurrence;
+      }
+      return to_provisional(n_shards * index + shard_i);
+    }
+
+    size_t ConcurrentColourHash::get_n_provisional() const {
+      size_t max_shard_size = 0;
+      for (const auto &shard : shards) {
+        max_shard_size = std::max(max_shard_size, shard->colours.size());
+      }
+      return shards.size() * max_shard_size;
+    }
+
+    std::vector<std::pair<std::vector<int>, int>> ConcurrentColourHash::get_new_colours() const {
+      // (first occurrence, provisional id, key)
+      std::vector<std::tuple<uint64_t, int, ColourKey>> order;
+      const size_t n_shards = shards.size();
+      for (size_t shard_i = 0; shard_i < n_shards; shard_i++) {
+        const Shard &shard = *shards[shard_i];
+        for (const auto &[key, index] : shard.colours) {
+          order.emplace_back(
+              shard.first_occurrence[index], to_provisional(n_shards * index + shard_i), key);
+        }
+      }
+      // each occurrence hashes exactly one colour, so first occurrences are unique
+      std::sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+        return std::get<0>(a) < std::get<0>(b);
+      });
+
+      std::vector<std::pair<std::vector<int>, int>> ret;
+      ret.reserve(order.size());
+      for (const auto &[_, provisional, key] : order) {
+        ret.emplace_back(std::vector<int>(key.begin(), key.end()), provisional);
+      }
+      return ret;
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
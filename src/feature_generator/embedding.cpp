@@ -0,0 +1,77 @@
+#include "../../include/feature_generator/embedding.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace wlplan {
+  namespace feature_generator {
+    Embedding EmbeddingCounter::to_embedding() {
+      for (const auto &[colour, _] : x) {
+        position[colour] = -1;
+      }
+      std::sort(x.begin(), x.end());
+      Embedding ret = std::move(x);
+      x = Embedding();
+      return ret;
+    }
+
+    CSRWriter::CSRWriter(const size_t n_rows, const int n_cols) {
+      matrix.n_rows = n_rows;
+      matrix.n_cols = n_cols;
+      matrix.indptr.reserve(n_rows + 1);
+      matrix.indptr.push_back(0);
+    }
+
+    void CSRWriter::write_row(const size_t i, Embedding &&x) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (i + 1 != matrix.indptr.size()) {
+        pending_rows.emplace(i, std::move(x));
+        return;
+      }
+      append_row(x);
+      for (auto it = pending_rows.find(matrix.indptr.size() - 1); it != pending_rows.end();
+           it = pending_rows.find(matrix.indptr.size() - 1)) {
+        append_row(it->second);
+        pending_rows.erase(it);
+      }
+    }
+
+    void CSRWriter::append_row(const Embedding &x) {
+      // reserve for the rows to come at the average size of the rows so far, so that the buffers
+      // are not reallocated repeatedly or left with up to twice the capacity they need
+      const size_t nnz = matrix.indices.size() + x.size();
+      if (nnz > matrix.indices.capacity()) {
+        const size_t n_written = matrix.indptr.size();
+        size_t capacity = nnz + nnz / 8;
+        if ((int64_t)n_written < matrix.n_rows) {
+          capacity = std::max(capacity, (size_t)(nnz / (double)n_written * matrix.n_rows * 1.125));
+        }
+        matrix.indices.reserve(capacity);
+        matrix.data.reserve(capacity);
+      }
+      for (const auto &[colour, count] : x) {
+        matrix.indices.push_back(colour);
+        matrix.data.push_back(count);
+      }
+      matrix.indptr.push_back(matrix.indices.size());
+    }
+
+    CSRMatrix CSRWriter::finish() {
+      if ((int64_t)matrix.indptr.size() != matrix.n_rows + 1) {
+        throw std::runtime_error("Error: only " + std::to_string(matrix.indptr.size() - 1) +
+                                 " of " + std::to_string(matrix.n_rows) +
+                                 " rows of the CSR matrix were written");
+      }
+      return std::move(matrix);
+    }
+
+    std::map<int, int> embedding_to_map(const Embedding &embedding) {
+      return std::map<int, int>(embedding.begin(), embedding.end());
+    }
+
+    Embedding map_to_embedding(const std::map<int, int> &embedding) {
+      return Embedding(embedding.begin(), embedding.end());
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
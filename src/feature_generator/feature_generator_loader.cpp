@@ -3,8 +3,10 @@
 #include "../../include/feature_generator/feature_generators/ccwl.hpp"
 #include "../../include/feature_generator/feature_generators/ccwla.hpp"
 #include "../../include/feature_generator/feature_generators/iwl.hpp"
+#include "../../include/feature_generator/feature_generators/kwl2.hpp"
 #include "../../include/feature_generator/feature_generators/lwl2.hpp"
 #include "../../include/feature_generator/feature_generators/niwl.hpp"
+#include "../../include/feature_generator/feature_generators/slwl2.hpp"
 #include "../../include/feature_generator/feature_generators/wl.hpp"
 #include "../../include/utils/nlohmann/json.hpp"
 
@@ -13,16 +15,17 @@
 
 std::shared_ptr<wlplan::feature_generator::Features>
 load_feature_generator(const std::string save_file) {
-  std::ifstream i(save_file);
-  json j;
-  i >> j;
   std::cout << "Loading feature generator from file " << save_file << std::endl;
-  std::string feature_name = j["feature_name"];
+  std::string feature_name = wlplan::feature_generator::Features::read_feature_name(save_file);
   std::shared_ptr<wlplan::feature_generator::Features> feature_generator;
   if (feature_name == "wl") {
     feature_generator = std::make_shared<wlplan::feature_generator::WLFeatures>(save_file);
+  } else if (feature_name == "2-kwl") {
+    feature_generator = std::make_shared<wlplan::feature_generator::KWL2Features>(save_file);
   } else if (feature_name == "2-lwl") {
     feature_generator = std::make_shared<wlplan::feature_generator::LWL2Features>(save_file);
+  } else if (feature_name == "2-slwl") {
+    feature_generator = std::make_shared<wlplan::feature_generator::SLWL2Features>(save_file);
   } else if (feature_name == "ccwl") {
     feature_generator = std::make_shared<wlplan::feature_generator::CCWLFeatures>(save_file);
   } else if (feature_name == "ccwl-a") {
@@ -37,50 +37,47 @@ namespace wlplan {
 
     int CCWLFeatures::get_n_features() const { return get_n_colours() * 2; }
 
-    Embedding CCWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
+    Embedding CCWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                       EmbeddingWorkspace &workspace) {
       // New additions to the WL algorithm are indicated with the [NUMERIC] comments.
       // We use a sum function for the pool operator as described in the ccWL algorithm.
       // To change this to max, we just need to replace += occurrences with std::max.
 
       /* 1. Initialise embedding before pruning, and set up memory */
       int categorical_size = get_n_colours();
-      Embedding x0;
       int n_nodes = graph->nodes.size();
-      Embedding colours;
-      for (int i = 0; i < n_nodes; i++) {
-        colours.insert({i, 0});
-      }
+      Colouring colours(n_nodes, 0);
       std::set<int> nodes = graph->get_nodes_set();
 
       /* 2. Compute initial colours */
       int col;
       int is_seen_colour;
       for (int node_i = 0; node_i < n_nodes; node_i++) {
-        col = get_colour_hash({graph->nodes[node_i]}, 0);
+        col = get_colour_hash(ColourKey(&graph->nodes[node_i], 1), 0);
         colours[node_i] = col;
         is_seen_colour = (col != UNSEEN_COLOUR);  // prevent branch prediction
-        seen_colour_statistics[is_seen_colour][0]++;
+        workspace.seen_colour_statistics[is_seen_colour][0]++;
         if (is_seen_colour) {
-          x0[col]++;
-          x0[col + categorical_size] += graph->node_values[node_i];  // [NUMERIC]
+          workspace.x.add(col);
+          workspace.x.add(col + categorical_size, graph->node_values[node_i]);  // [NUMERIC]
         }
       }
 
       /* 3. Main WL loop */
       for (int itr = 1; itr < iterations + 1; itr++) {
-        refine(graph, nodes, colours, itr);
+        refine(graph, nodes, colours, itr, *workspace.neighbour_container);
         for (int node_i = 0; node_i < n_nodes; node_i++) {
           col = colours[node_i];
           is_seen_colour = (col != UNSEEN_COLOUR);  // prevent branch prediction
-          seen_colour_statistics[is_seen_colour][itr]++;
+          workspace.seen_colour_statistics[is_seen_colour][itr]++;
           if (is_seen_colour) {
-            x0[col]++;
-            x0[col + categorical_size] += graph->node_values[node_i];  // [NUMERIC]
+            workspace.x.add(col);
+            workspace.x.add(col + categorical_size, graph->node_values[node_i]);  // [NUMERIC]
           }
         }
       }
 
-      return x0;
+      return workspace.x.to_embedding();
     }
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -31,14 +31,28 @@ namespace wlplan {
       return n_cat_features + n_con_features + n_sub_features;
     }
 
-    Embedding CCWLaFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
-      Embedding ccwl_embedding = CCWLFeatures::embed_impl(graph);
+    Embedding CCWLaFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                        EmbeddingWorkspace &workspace) {
+      Embedding ccwl_embedding = CCWLFeatures::embed_impl(graph, workspace);
       int n_con_features = get_n_colours();  // = n_cat_features
+      EmbeddingVec counts(n_con_features, 0);
+      for (const auto &[col, count] : ccwl_embedding) {
+        if (col < n_con_features) {
+          counts[col] = count;
+        }
+      }
+
+      // subtraction features are placed after the categorical and continuous features
+      int sub_feature = 2 * n_con_features;
       for (int i = 0; i < n_con_features; i++) {
         for (int j = 0; j < n_con_features; j++) {
           if (i == j)
             continue;
-          ccwl_embedding[ccwl_embedding.size()] = (std::max(ccwl_embedding[i] - ccwl_embedding[j], 0));
+          int val = std::max(counts[i] - counts[j], 0);
+          if (val != 0) {
+            ccwl_embedding.push_back(std::make_pair(sub_feature, val));
+          }
+          sub_feature++;
         }
       }
 
@@ -3,7 +3,10 @@
 #include "../../../include/graph_generator/graph_generator_factory.hpp"
 #include "../../../include/utils/exceptions.hpp"
 #include "../../../include/utils/nlohmann/json.hpp"
+#include "../../../include/utils/parallel.hpp"
 
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <sstream>
 
@@ -36,118 +39,286 @@ namespace wlplan {
     IWLFeatures::IWLFeatures(const std::string &filename, bool quiet)
         : WLFeatures(filename, quiet) {}
 
-    void IWLFeatures::refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                             Embedding &colours,
-                             int iteration) {
-      // memory for storing string and hashed int representation of colours
-      std::vector<int> new_colour;
-      std::vector<int> neighbour_vector;
-      int new_colour_compressed;
+    void PredecessorLists::build(const graph_generator::Graph &graph) {
+      const int n_nodes = graph.nodes.size();
+      offsets.assign(n_nodes + 1, 0);
+      predecessors.resize(graph.neighbours.size());
+      for (const int v : graph.neighbours) {
+        offsets[v + 1]++;
+      }
+      for (int v = 0; v < n_nodes; v++) {
+        offsets[v + 1] += offsets[v];
+      }
+      next.assign(offsets.begin(), offsets.end() - 1);
+      for (int u = 0; u < n_nodes; u++) {
+        for (int j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
+          predecessors[next[graph.neighbours[j]]++] = u;
+        }
+      }
+    }
+
+    void IndividualisationBall::reset(const int n_nodes) {
+      nodes.clear();
+      depths.clear();
+      positions.assign(n_nodes, -1);
+    }
 
-      Embedding new_colours;
-      for (int i = 0; i < (int) colours.size(); i++) {
-        new_colours.insert({i, UNSEEN_COLOUR});
+    void IndividualisationBall::build(const PredecessorLists &predecessors,
+                                      const int node,
+                                      const int radius) {
+      for (const int u : nodes) {
+        positions[u] = -1;
       }
+      nodes = {node};
+      depths = {0};
+      positions[node] = 0;
 
-      for (size_t u = 0; u < graph->nodes.size(); u++) {
-        // skip unseen colours
-        if (colours[u] == UNSEEN_COLOUR) {
-          new_colour_compressed = UNSEEN_COLOUR;
-          goto end_of_iteration;
+      // breadth first search backwards along edges
+      for (size_t k = 0; k < nodes.size(); k++) {
+        if (depths[k] == radius) {
+          continue;
         }
-        neighbour_container->clear();
-
-        for (const auto &edge : graph->edges[u]) {
-          // skip unseen colours
-          if (colours[edge.second] == UNSEEN_COLOUR) {
-            new_colour_compressed = UNSEEN_COLOUR;
-            goto end_of_iteration;
+        const int v = nodes[k];
+        for (int j = predecessors.begin(v); j < predecessors.end(v); j++) {
+          const int u = predecessors.get_predecessor(j);
+          if (positions[u] == -1) {
+            positions[u] = nodes.size();
+            nodes.push_back(u);
+            depths.push_back(depths[k] + 1);
           }
+        }
+      }
+    }
 
-          // add sorted neighbour (colour, edge_label) pair
-          neighbour_container->insert(colours[edge.second], edge.first);
+    template <typename F>
+    int IWLFeatures::refine_node(const graph_generator::Graph &graph,
+                                 const int u,
+                                 const int colour,
+                                 const F &colour_of,
+                                 const int iteration,
+                                 NeighbourContainer &container,
+                                 const int data_index,
+                                 const int count) {
+      // skip unseen colours
+      if (colour == UNSEEN_COLOUR) {
+        return UNSEEN_COLOUR;
+      }
+      container.clear();
+
+      for (int j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
+        const int neighbour_colour = colour_of(graph.neighbours[j]);
+        if (neighbour_colour == UNSEEN_COLOUR) {
+          return UNSEEN_COLOUR;
         }
 
-        // add current colour and sorted neighbours into sorted colour key
-        new_colour = {colours[u]};
-        neighbour_vector = neighbour_container->to_vector();
+        // add sorted neighbour (colour, edge_label) pair
+        container.insert(neighbour_colour, graph.edge_labels[j]);
+      }
+
+      // add sorted neighbours and current colour into sorted colour key, laid out as WL keys so
+      // that the neighbour container can read the ancestors of colours for pruning
+      std::vector<int> new_colour = container.to_vector();
+      new_colour.push_back(colour);
 
-        new_colour.insert(new_colour.end(), neighbour_vector.begin(), neighbour_vector.end());
+      return get_colour_hash(new_colour, iteration, data_index, count);
+    }
 
-        // hash seen colours
-        new_colour_compressed = get_colour_hash(new_colour, iteration);
+    void IWLFeatures::compute_base_colours(const graph_generator::Graph &graph,
+                                           const std::vector<std::vector<int>> &cover,
+                                           std::vector<Colouring> &base_colours,
+                                           NeighbourContainer &container,
+                                           const int data_index) {
+      const int n_nodes = graph.nodes.size();
+      base_colours.assign(iterations + 1, Colouring(n_nodes, UNSEEN_COLOUR));
+      // number of individualisations in which the colour of a node is its base colour
+      const auto n_kept = [&](const int iteration, const int u) {
+        return cover.empty() ? 1 : n_nodes - cover[iteration][u];
+      };
 
-      end_of_iteration:
-        new_colours[u] = new_colour_compressed;
+      for (int u = 0; u < n_nodes; u++) {
+        if (n_kept(0, u) > 0) {
+          const std::array<int, 1> colour_key = {graph.nodes[u]};
+          base_colours[0][u] = get_colour_hash(colour_key, 0, data_index, n_kept(0, u));
+        }
       }
 
-      colours = new_colours;
+      // nodes that are read only have neighbours that are read in the previous iteration
+      for (int itr = 1; itr < iterations + 1; itr++) {
+        const Colouring &colours = base_colours[itr - 1];
+        for (int u = 0; u < n_nodes; u++) {
+          if (n_kept(itr, u) > 0) {
+            base_colours[itr][u] = refine_node(
+                graph, u, colours[u], [&](const int v) { return colours[v]; }, itr, container,
+                data_index, n_kept(itr, u));
+          }
+        }
+      }
     }
 
-    void IWLFeatures::collect_impl(const std::vector<graph_generator::Graph> &graphs) {
-      // intermediate graph colours during WL
+    template <typename F>
+    void IWLFeatures::refine_ball(const graph_generator::Graph &graph,
+                                  const IndividualisationBall &ball,
+                                  const std::vector<Colouring> &base_colours,
+                                  Colouring &colours,
+                                  Colouring &new_colours,
+                                  NeighbourContainer &container,
+                                  const int data_index,
+                                  const F &f) {
+      const int node_i = ball.get_node(0);
+      const std::array<int, 2> colour_key = {graph.nodes[node_i], INDIVIDUALISE_COLOUR};
+      colours.resize(ball.size());
+      colours[0] = get_colour_hash(colour_key, 0, data_index);
+      f(0, node_i, colours[0]);
+      for (int k = 1; k < ball.size(); k++) {
+        colours[k] = base_colours[0][ball.get_node(k)];
+      }
 
-      // init colours
-      for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
-        const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
-        int n_nodes = graph->nodes.size();
-
-        // individualisation for each node
-        for (int node_i = 0; node_i < n_nodes; node_i++) {
-          Embedding colours;
-          for (int i = 0; i < n_nodes; i++) {
-            colours.insert({i, 0});
+      // colours of nodes in the ball are those of the previous iteration
+      new_colours.resize(ball.size());
+      for (int itr = 1; itr < iterations + 1; itr++) {
+        const Colouring &base = base_colours[itr - 1];
+        const auto colour_of = [&](const int v) {
+          const int k = ball.get_position(v);
+          return k == -1 ? base[v] : colours[k];
+        };
+        for (int k = 0; k < ball.size(); k++) {
+          const int u = ball.get_node(k);
+          if (ball.get_depth(k) > itr) {
+            new_colours[k] = base_colours[itr][u];
+            continue;
           }
+          new_colours[k] =
+              refine_node(graph, u, colours[k], colour_of, itr, container, data_index);
+          f(itr, u, new_colours[k]);
+        }
+        std::swap(colours, new_colours);
+      }
+    }
 
-          for (int u = 0; u < n_nodes; u++) {
-            std::vector<int> colour_key = {graph->nodes[u]};
-            if (u == node_i) {
-              colour_key.push_back(INDIVIDUALISE_COLOUR);
-            }
-            int col = get_colour_hash(colour_key, 0);
-            colours[u] = col;
-          }
+    void IWLFeatures::collect_graph(const graph_generator::Graph &graph, const int data_index) {
+      const int n_nodes = graph.nodes.size();
+      PredecessorLists predecessors;
+      predecessors.build(graph);
+      IndividualisationBall ball;
+      ball.reset(n_nodes);
 
-          // main WL loop
-          for (int iteration = 1; iteration < iterations + 1; iteration++) {
-            refine(graph, colours, iteration);
-          }
+      // number of individualised nodes within each number of iterations of each node
+      std::vector<std::vector<int>> cover(iterations + 1, std::vector<int>(n_nodes, 0));
+      for (int node_i = 0; node_i < n_nodes; node_i++) {
+        ball.build(predecessors, node_i, iterations);
+        for (int k = 0; k < ball.size(); k++) {
+          cover[ball.get_depth(k)][ball.get_node(k)]++;
         }
       }
+      for (int itr = 1; itr < iterations + 1; itr++) {
+        for (int u = 0; u < n_nodes; u++) {
+          cover[itr][u] += cover[itr - 1][u];
+        }
+      }
+
+      std::vector<Colouring> base_colours;
+      compute_base_colours(graph, cover, base_colours, *neighbour_container, data_index);
+
+      // individualisation for each node
+      Colouring colours, new_colours;
+      for (int node_i = 0; node_i < n_nodes; node_i++) {
+        ball.build(predecessors, node_i, iterations);
+        refine_ball(graph,
+                    ball,
+                    base_colours,
+                    colours,
+                    new_colours,
+                    *neighbour_container,
+                    data_index,
+                    [](const int, const int, const int) {});
+      }
+    }
+
+    void IWLFeatures::collect_impl(const std::vector<graph_generator::Graph> &graphs) {
+      for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
+        collect_graph(graphs[graph_i], graph_i);
+      }
     }
 
-    Embedding IWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
-      /* 1. Initialise embedding */
-      Embedding x0;
+    void IWLFeatures::collect_impl(data::ProblemSource &source) {
+      int data_index = 0;
+      source.reset();
+      while (const auto problem_states = source.next()) {
+        graph_generator->set_problem(problem_states->problem);
+        for (const planning::State &state : problem_states->states) {
+          collect_graph(*graph_generator->to_graph(state, workspace.graph_overlay), data_index);
+          data_index++;
+        }
+      }
+    }
+
+    Embedding IWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                      EmbeddingWorkspace &workspace) {
+      if (dynamic_cast<IWLScratch *>(workspace.scratch.get()) == nullptr) {
+        workspace.scratch = std::make_unique<IWLScratch>();
+      }
+      IWLScratch &scratch = static_cast<IWLScratch &>(*workspace.scratch);
+
+      /* 1. Compute colours without individualisation */
       int n_nodes = graph->nodes.size();
+      std::vector<Colouring> &base_colours = scratch.base_colours;
+      compute_base_colours(*graph, {}, base_colours, *workspace.neighbour_container, -99);
 
-      /* Individualisation */
-      for (int node_i = 0; node_i < n_nodes; node_i++) {
-        Embedding colours;
-        for (int i = 0; i < n_nodes; i++) {
-          colours.insert({i, 0});
+      /* 2. Refine the ball around each individualised node, in parallel for single graphs */
+      const int n_workers = std::max(std::min(workspace.n_threads, n_nodes), 1);
+      if (n_workers > 1) {
+        reserve_thread_workspaces(workspace, n_workers);
+      }
+      scratch.predecessors.build(*graph);
+      scratch.balls.resize(n_workers);
+      scratch.colours.resize(n_workers);
+      scratch.new_colours.resize(n_workers);
+      scratch.depth_counts.resize(n_workers);
+      for (int thread_id = 0; thread_id < n_workers; thread_id++) {
+        scratch.balls[thread_id].reset(n_nodes);
+        scratch.depth_counts[thread_id].assign((iterations + 1) * n_nodes, 0);
+      }
+      utils::parallel_for(n_nodes, n_workers, [&](const int thread_id, const size_t node_i) {
+        EmbeddingWorkspace &thread_workspace =
+            n_workers > 1 ? workspace.thread_workspaces[thread_id] : workspace;
+        IndividualisationBall &ball = scratch.balls[thread_id];
+        ball.build(scratch.predecessors, node_i, iterations);
+        refine_ball(*graph,
+                    ball,
+                    base_colours,
+                    scratch.colours[thread_id],
+                    scratch.new_colours[thread_id],
+                    *thread_workspace.neighbour_container,
+                    -99,
+                    [&](const int itr, const int, const int col) {
+                      add_colour_to_x(col, itr, thread_workspace);
+                    });
+        std::vector<int> &depth_count = scratch.depth_counts[thread_id];
+        for (int k = 0; k < ball.size(); k++) {
+          depth_count[ball.get_depth(k) * n_nodes + ball.get_node(k)]++;
+        }
+      });
+      if (n_workers > 1) {
+        for (int thread_id = 0; thread_id < n_workers; thread_id++) {
+          merge_workspace(workspace.thread_workspaces[thread_id], workspace);
         }
+      }
 
-        /* 2. Compute initial colours */
+      /* 3. Nodes outside of the balls keep their colours without individualisation */
+      std::vector<int> &cover = scratch.cover;
+      cover.assign(n_nodes, 0);
+      for (int itr = 0; itr < iterations + 1; itr++) {
         for (int u = 0; u < n_nodes; u++) {
-          std::vector<int> colour_key = {graph->nodes[u]};
-          if (u == node_i) {
-            colour_key.push_back(INDIVIDUALISE_COLOUR);
+          for (int thread_id = 0; thread_id < n_workers; thread_id++) {
+            cover[u] += scratch.depth_counts[thread_id][itr * n_nodes + u];
           }
-          int col = get_colour_hash(colour_key, 0);
-          add_colour_to_x(col, 0, x0);
-        }
-
-        /* 3. Main WL loop */
-        for (int itr = 1; itr < iterations + 1; itr++) {
-          refine(graph, colours, itr);
-          for (auto pair : colours) {
-            add_colour_to_x(pair.second, itr, x0);
+          if (cover[u] < n_nodes) {
+            add_colour_to_x(base_colours[itr][u], itr, workspace, n_nodes - cover[u]);
           }
         }
       }
 
-      return x0;
+      return workspace.x.to_embedding();
     }
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -1,11 +1,20 @@
 #include "../../../include/feature_generator/feature_generators/kwl2.hpp"
 
+#include "../../../include/feature_generator/concurrent_colour_hash.hpp"
 #include "../../../include/graph_generator/graph_generator_factory.hpp"
 #include "../../../include/utils/nlohmann/json.hpp"
+#include "../../../include/utils/parallel.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using json = nlohmann::json;
 
 namespace wlplan {
@@ -39,58 +48,154 @@ namespace wlplan {
 
     int get_n_kwl2_pairs(int n_nodes) { return static_cast<int>(n_nodes * n_nodes); }
 
-    void KWL2Features::refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                              Embedding &colours,
-                              int iteration) {
-      // memory for storing string and hashed int representation of colours
-      std::vector<int> new_colour;
-      std::vector<int> neighbour_vector;
-      int new_colour_compressed, pair1, pair2, pair1_col, pair2_col;
-      int n_nodes = graph->nodes.size();
-
-      Embedding new_colours;
-      for (int i = 0; i < (int) colours.size(); i++) {
-        new_colours.insert({i, UNSEEN_COLOUR});
+    void append_pair_counts(std::vector<uint64_t> &pairs,
+                            const bool multiset_hash,
+                            std::vector<int> &key) {
+      std::sort(pairs.begin(), pairs.end());
+      const size_t n = pairs.size();
+      for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && pairs[j] == pairs[i]) {
+          j++;
+        }
+        key.push_back((int)(pairs[i] >> 32));
+        key.push_back((int)(uint32_t)pairs[i]);
+        key.push_back(multiset_hash ? (int)(j - i) : 1);
+        i = j;
       }
+    }
+
+    namespace {
+      // pairs of colours of a pair key, with the colour of (u, w) in the low half and the colour of
+      // (w, v) in the high half, so that sorting them orders them as KWL2NeighbourContainer does
+      class PairKeyBuffer {
+       public:
+        explicit PairKeyBuffer(const int n_nodes) : pairs(n_nodes) {}
+
+        // Writes the colour key of pair (u, v) into key given row u of the colours and row v of
+        // their transpose, or returns false if any colour involved is UNSEEN_COLOUR.
+        bool build(const int colour,
+                   const int *row,
+                   const int *column,
+                   const bool multiset_hash,
+                   std::vector<int> &key) {
+          if (colour < 0) {
+            return false;
+          }
+          const size_t n = pairs.size();
+          size_t w = 0;
+          // sign bits of all colours read, as UNSEEN_COLOUR is the only negative colour
+          int sse_signs = 0;
+          int signs = 0;
+#if defined(__SSE2__)
+          // interleaving colour(u, w) and colour(w, v) gives the 64-bit pairs on little endian x86
+          __m128i any = _mm_setzero_si128();
+          for (; w + 4 <= n; w += 4) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + w));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + w));
+            any = _mm_or_si128(any, _mm_or_si128(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[w]), _mm_unpacklo_epi32(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[w + 2]), _mm_unpackhi_epi32(a, b));
+          }
+          sse_signs = _mm_movemask_ps(_mm_castsi128_ps(any));
+#endif
+          for (; w < n; w++) {
+            signs |= row[w] | column[w];
+            pairs[w] = ((uint64_t)(uint32_t)column[w] << 32) | (uint32_t)row[w];
+          }
+          if (sse_signs != 0 || signs < 0) {
+            return false;
+          }
+          key.clear();
+          key.push_back(colour);
+          append_pair_counts(pairs, multiset_hash, key);
+          return true;
+        }
 
+       private:
+        std::vector<uint64_t> pairs;
+      };
+    }  // namespace
+
+    void KWL2Features::refine(const int n_nodes,
+                              Colouring &colours,
+                              const int iteration,
+                              const int data_index) {
+      // colours of (w, v) for all w are read from row v of the transpose
+      Colouring transposed(colours.size());
       for (int u = 0; u < n_nodes; u++) {
         for (int v = 0; v < n_nodes; v++) {
-          int index = kwl2_pair_to_index_map(n_nodes, u, v);
-          if (colours[index] == UNSEEN_COLOUR) {
-            new_colour_compressed = UNSEEN_COLOUR;
-            goto end_of_iteration;
-          }
+          transposed[kwl2_pair_to_index_map(n_nodes, v, u)] =
+              colours[kwl2_pair_to_index_map(n_nodes, u, v)];
+        }
+      }
+
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
 
-          neighbour_container->clear();
-
-          // original kWL iterates over all nodes for neighbours
-          for (int w = 0; w < n_nodes; w++) {
-            pair1 = kwl2_pair_to_index_map(n_nodes, u, w);
-            pair2 = kwl2_pair_to_index_map(n_nodes, w, v);
-            pair1_col = colours[pair1];
-            pair2_col = colours[pair2];
-            if (pair1_col == UNSEEN_COLOUR || pair2_col == UNSEEN_COLOUR) {
-              new_colour_compressed = UNSEEN_COLOUR;
-              goto end_of_iteration;
+      if (!collecting || n_threads <= 1 || n_nodes <= 1) {
+        PairKeyBuffer buffer(n_nodes);
+        std::vector<int> key;
+        for (int u = 0; u < n_nodes; u++) {
+          const int *row = &colours[kwl2_pair_to_index_map(n_nodes, u, 0)];
+          for (int v = 0; v < n_nodes; v++) {
+            const int index = kwl2_pair_to_index_map(n_nodes, u, v);
+            const int *column = &transposed[kwl2_pair_to_index_map(n_nodes, v, 0)];
+            if (buffer.build(colours[index], row, column, multiset_hash, key)) {
+              new_colours[index] = get_colour_hash(key, iteration, data_index);
             }
-            neighbour_container->insert(pair1_col, pair2_col);
           }
+        }
+        colours = std::move(new_colours);
+        return;
+      }
 
-          // add current colour and sorted neighbours into sorted colour key
-          new_colour = {colours[index]};
-          neighbour_vector = neighbour_container->to_vector();
-
-          new_colour.insert(new_colour.end(), neighbour_vector.begin(), neighbour_vector.end());
-
-          // hash seen colours
-          new_colour_compressed = get_colour_hash(new_colour, iteration);
+      // Rows are refined in parallel with lookups only. Keys that are not in the colour hash yet
+      // are kept in a dictionary of the thread, and given provisional colours that index into it.
+      // New keys are then hashed in order of their pair index as in a sequential pass.
+      const ColourHash &hash = colour_hash[iteration];
+      std::vector<ColourHash> new_keys(n_threads);
+      std::vector<int> row_thread(n_nodes);
+      utils::parallel_for(n_nodes, n_threads, [&](const int thread_id, const size_t u) {
+        PairKeyBuffer buffer(n_nodes);
+        std::vector<int> key;
+        row_thread[u] = thread_id;
+        const int *row = &colours[kwl2_pair_to_index_map(n_nodes, u, 0)];
+        for (int v = 0; v < n_nodes; v++) {
+          const int index = kwl2_pair_to_index_map(n_nodes, u, v);
+          const int *column = &transposed[kwl2_pair_to_index_map(n_nodes, v, 0)];
+          if (!buffer.build(colours[index], row, column, multiset_hash, key)) {
+            continue;
+          }
+          int colour = hash.find(key);
+          if (colour == ColourHash::NOT_FOUND) {
+            ColourHash &thread_keys = new_keys[thread_id];
+            colour = ConcurrentColourHash::to_provisional(
+                thread_keys.insert(key, thread_keys.size()).first);
+          }
+          new_colours[index] = colour;
+        }
+      });
 
-        end_of_iteration:
-          new_colours[index] = new_colour_compressed;
+      std::vector<std::vector<ColourKey>> thread_keys(n_threads);
+      for (int thread_id = 0; thread_id < n_threads; thread_id++) {
+        for (const auto &[key, provisional] : new_keys[thread_id]) {
+          thread_keys[thread_id].push_back(key);
+        }
+      }
+      for (int index = 0; index < (int)new_colours.size(); index++) {
+        int &colour = new_colours[index];
+        if (ConcurrentColourHash::is_provisional(colour)) {
+          const int thread_id = row_thread[index / n_nodes];
+          colour = get_colour_hash(
+              thread_keys[thread_id][ConcurrentColourHash::from_provisional(colour)],
+              iteration,
+              data_index);
+        } else if (colour != UNSEEN_COLOUR) {
+          count_colour(colour, data_index);
         }
       }
 
-      colours = new_colours;
+      colours = std::move(new_colours);
     }
 
     std::vector<int> get_kwl2_pair_to_edge_label(std::shared_ptr<graph_generator::Graph> graph) {
@@ -98,7 +203,9 @@ namespace wlplan {
       int n_pairs = get_n_kwl2_pairs(n_nodes);
       std::vector<int> pair_to_edge_label(n_pairs, NO_EDGE_COLOUR);
       for (int u = 0; u < n_nodes; u++) {
-        for (const auto &[edge_label, v] : graph->edges[u]) {
+        for (int j = graph->offsets[u]; j < graph->offsets[u + 1]; j++) {
+          int edge_label = graph->edge_labels[j];
+          int v = graph->neighbours[j];
           pair_to_edge_label[kwl2_pair_to_index_map(n_nodes, u, v)] = edge_label;
           pair_to_edge_label[kwl2_pair_to_index_map(n_nodes, v, u)] = edge_label;
         }
@@ -110,79 +217,111 @@ namespace wlplan {
                                          int u,
                                          int v,
                                          const std::shared_ptr<graph_generator::Graph> &graph,
-                                         const std::vector<int> &pair_to_edge_label) {
+                                         const std::vector<int> &pair_to_edge_label,
+                                         int data_index) {
       int u_col = graph->nodes[u];
       int v_col = graph->nodes[v];
       int e_col = pair_to_edge_label[index];
-      int col = get_colour_hash({u_col, v_col, e_col}, 0);
+      const std::array<int, 3> colour_key = {u_col, v_col, e_col};
+      int col = get_colour_hash(colour_key, 0, data_index);
       return col;
     }
 
+    void KWL2Features::initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                                          Colouring &colours,
+                                          int data_index) {
+      int n_nodes = graph->nodes.size();
+      std::vector<int> pair_to_edge_label = get_kwl2_pair_to_edge_label(graph);
+      colours.assign(get_n_kwl2_pairs(n_nodes), 0);
+      for (int u = 0; u < n_nodes; u++) {
+        for (int v = 0; v < n_nodes; v++) {
+          int index = kwl2_pair_to_index_map(n_nodes, u, v);
+          colours[index] = get_initial_colour(index, u, v, graph, pair_to_edge_label, data_index);
+        }
+      }
+    }
+
+    void KWL2Features::refine_all(ColouringStore &graph_colours,
+                                  const std::vector<int> &graph_n_nodes) {
+      Colouring colours;
+      for (int itr = 1; itr < iterations + 1; itr++) {
+        log_iteration(itr);
+        for (size_t graph_i = 0; graph_i < graph_colours.size(); graph_i++) {
+          graph_colours.load(graph_i, colours);
+          refine(graph_n_nodes[graph_i], colours, itr, graph_i);
+          graph_colours.store(graph_i, colours);
+        }
+
+        // layer pruning
+        prune_this_iteration(itr, graph_colours);
+        graph_colours.release();
+      }
+    }
+
     void KWL2Features::collect_impl(const std::vector<graph_generator::Graph> &graphs) {
       // intermediate graph colours during WL
+      ColouringStore graph_colours(spill_directory);
+      std::vector<int> graph_n_nodes;
+      Colouring colours;
 
+      // init colours
+      log_iteration(0);
       for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
         const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
-        auto edges = graph->edges;
-        int n_nodes = graph->nodes.size();
-
-        int n_pairs = get_n_kwl2_pairs(n_nodes);
-
-        // intermediate colours
-        Embedding colours;
-        for (int i = 0; i < n_pairs; i++) {
-          colours.insert({i, 0});
-        }
-
-        std::vector<int> pair_to_edge_label = get_kwl2_pair_to_edge_label(graph);
+        initialise_colours(graph, colours, graph_i);
+        graph_colours.push_back(colours);
+        graph_n_nodes.push_back(graph->nodes.size());
+      }
+      graph_colours.release();
 
-        // init colours
-        for (int u = 0; u < n_nodes; u++) {
-          for (int v = 0; v < n_nodes; v++) {
-            int index = kwl2_pair_to_index_map(n_nodes, u, v);
-            int col = get_initial_colour(index, u, v, graph, pair_to_edge_label);
-            colours[index] = col;
-          }
-        }
+      // main WL loop
+      refine_all(graph_colours, graph_n_nodes);
+    }
 
-        // main WL loop
-        for (int iteration = 1; iteration < iterations + 1; iteration++) {
-          refine(graph, colours, iteration);
+    void KWL2Features::collect_impl(data::ProblemSource &source) {
+      // Pair colours determine the next pair colours without the graph, so each graph is only
+      // generated once. Intermediate graph colours are kept in a store that can be spilled to disk.
+      ColouringStore graph_colours(spill_directory);
+      std::vector<int> graph_n_nodes;
+      Colouring colours;
+
+      // init colours
+      log_iteration(0);
+      source.reset();
+      while (const auto problem_states = source.next()) {
+        graph_generator->set_problem(problem_states->problem);
+        for (const planning::State &state : problem_states->states) {
+          const auto graph = graph_generator->to_graph(state, workspace.graph_overlay);
+          initialise_colours(graph, colours, graph_colours.size());
+          graph_colours.push_back(colours);
+          graph_n_nodes.push_back(graph->nodes.size());
         }
       }
+      graph_colours.release();
+
+      // main WL loop
+      refine_all(graph_colours, graph_n_nodes);
     }
 
-    Embedding KWL2Features::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
-      /* 1. Initialise embedding before pruning */
-      Embedding x0;
+    Embedding KWL2Features::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                       EmbeddingWorkspace &workspace) {
+      /* 1. Compute initial colours */
       int n_nodes = graph->nodes.size();
-      int n_pairs = get_n_kwl2_pairs(n_nodes);
-      Embedding colours;
-      for (int i = 0; i < n_pairs; i++) {
-        colours.insert({i, 0});
-      }
-
-      std::vector<int> pair_to_edge_label = get_kwl2_pair_to_edge_label(graph);
-
-      /* 2. Compute initial colours */
-      for (int u = 0; u < n_nodes; u++) {
-        for (int v = 0; v < n_nodes; v++) {
-          int index = kwl2_pair_to_index_map(n_nodes, u, v);
-          int col = get_initial_colour(index, u, v, graph, pair_to_edge_label);
-          colours[index] = col;
-          add_colour_to_x(col, 0, x0);
-        }
+      Colouring colours;
+      initialise_colours(graph, colours);
+      for (const int col : colours) {
+        add_colour_to_x(col, 0, workspace);
       }
 
-      /* 3. Main WL loop */
+      /* 2. Main WL loop */
       for (int itr = 1; itr < iterations + 1; itr++) {
-        refine(graph, colours, itr);
-        for (auto pair : colours) {
-          add_colour_to_x(pair.second, itr, x0);
+        refine(n_nodes, colours, itr);
+        for (const int col : colours) {
+          add_colour_to_x(col, itr, workspace);
         }
       }
 
-      return x0;
+      return workspace.x.to_embedding();
     }
   }  // namespace feature_generator
 }  // namespace wlplan
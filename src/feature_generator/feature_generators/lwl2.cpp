@@ -4,6 +4,8 @@
 #include "../../../include/utils/exceptions.hpp"
 #include "../../../include/utils/nlohmann/json.hpp"
 
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <sstream>
 
@@ -11,86 +13,82 @@ using json = nlohmann::json;
 
 namespace wlplan {
   namespace feature_generator {
+    LWL2Features::LWL2Features(const std::string wl_name,
+                               const planning::Domain &domain,
+                               std::string graph_representation,
+                               int iterations,
+                               std::string pruning,
+                               bool multiset_hash)
+        : KWL2Features(wl_name, domain, graph_representation, iterations, pruning, multiset_hash),
+          max_pair_entries(DEFAULT_MAX_PAIR_ENTRIES) {}
+
     LWL2Features::LWL2Features(const planning::Domain &domain,
                                std::string graph_representation,
                                int iterations,
                                std::string pruning,
                                bool multiset_hash)
-        : KWL2Features("2-lwl", domain, graph_representation, iterations, pruning, multiset_hash) {}
+        : LWL2Features("2-lwl", domain, graph_representation, iterations, pruning, multiset_hash) {}
 
-    LWL2Features::LWL2Features(const std::string &filename) : KWL2Features(filename) {}
+    LWL2Features::LWL2Features(const std::string &filename)
+        : KWL2Features(filename), max_pair_entries(DEFAULT_MAX_PAIR_ENTRIES) {}
 
     LWL2Features::LWL2Features(const std::string &filename, bool quiet)
-        : KWL2Features(filename, quiet) {}
+        : KWL2Features(filename, quiet), max_pair_entries(DEFAULT_MAX_PAIR_ENTRIES) {}
+
+    void LWL2Features::set_max_pair_entries(const long max_pair_entries) {
+      if (max_pair_entries < 0) {
+        throw std::runtime_error("max_pair_entries must be nonnegative, got " +
+                                 std::to_string(max_pair_entries));
+      }
+      this->max_pair_entries = max_pair_entries;
+    }
 
-    int lwl2_pair_to_index_map(int n, int i, int j) {
-      // map pair where 0 <= i < j < n to vec index
-      return j - i - 1 + (i * n) - (i * (i + 1)) / 2;
+    void LWL2Features::encode_pairs(const graph_generator::Graph &graph, std::vector<int> &pairs) {
+      LWL2PairNeighbours::encode(graph, max_pair_entries, pairs);
     }
 
-    int get_n_lwl2_pairs(int n_nodes) { return static_cast<int>((n_nodes * (n_nodes - 1)) / 2); }
+    void LWL2Features::refine(const int *pairs, Colouring &colours, int iteration, int data_index) {
+      const LWL2PairNeighbours pair_neighbours(pairs);
 
-    void LWL2Features::refine(const std::shared_ptr<graph_generator::Graph> &graph,
-                              std::vector<std::set<int>> &pair_to_neighbours,
-                              Embedding &colours,
-                              int iteration) {
-      // memory for storing string and hashed int representation of colours
+      // memory for the colour key and the colour pairs of neighbours
       std::vector<int> new_colour;
-      std::vector<int> neighbour_vector;
-      int new_colour_compressed, pair1, pair2, pair1_col, pair2_col;
-      int n_nodes = graph->nodes.size();
+      std::vector<uint64_t> colour_pairs;
+      int n_nodes = pair_neighbours.get_n_nodes();
 
-      Embedding new_colours;
-      for (int i = 0; i < (int) colours.size(); i++) {
-        new_colours.insert({i, UNSEEN_COLOUR});
-      }
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
       for (int u = 0; u < n_nodes; u++) {
         for (int v = u + 1; v < n_nodes; v++) {
           int index = lwl2_pair_to_index_map(n_nodes, u, v);
           if (colours[index] == UNSEEN_COLOUR) {
-            new_colour_compressed = UNSEEN_COLOUR;
-            goto end_of_iteration;
+            continue;
           }
 
-          neighbour_container->clear();
-
-          for (const int w : pair_to_neighbours[index]) {
-            if (u < w) {
-              pair1 = lwl2_pair_to_index_map(n_nodes, u, w);
-            } else {
-              pair1 = lwl2_pair_to_index_map(n_nodes, w, u);
-            }
-            if (v < w) {
-              pair2 = lwl2_pair_to_index_map(n_nodes, v, w);
-            } else {
-              pair2 = lwl2_pair_to_index_map(n_nodes, w, v);
-            }
-            pair1_col = colours[pair1];
-            pair2_col = colours[pair2];
+          colour_pairs.clear();
+          bool seen = pair_neighbours.for_each(u, v, index, [&](const int pair1, const int pair2) {
+            int pair1_col = colours[pair1];
+            int pair2_col = colours[pair2];
             if (pair1_col == UNSEEN_COLOUR || pair2_col == UNSEEN_COLOUR) {
-              new_colour_compressed = UNSEEN_COLOUR;
-              goto end_of_iteration;
+              return false;
             }
             // min max used because of sets
-            neighbour_container->insert(std::min(pair1_col, pair2_col),
-                                        std::max(pair1_col, pair2_col));
+            colour_pairs.push_back(((uint64_t)std::max(pair1_col, pair2_col) << 32) |
+                                   (uint64_t)std::min(pair1_col, pair2_col));
+            return true;
+          });
+          if (!seen) {
+            continue;
           }
 
           // add current colour and sorted neighbours into sorted colour key
           new_colour = {colours[index]};
-          neighbour_vector = neighbour_container->to_vector();
-
-          new_colour.insert(new_colour.end(), neighbour_vector.begin(), neighbour_vector.end());
+          append_pair_counts(colour_pairs, multiset_hash, new_colour);
 
           // hash seen colours
-          new_colour_compressed = get_colour_hash(new_colour, iteration);
-
-        end_of_iteration:
-          new_colours[index] = new_colour_compressed;
+          new_colours[index] = get_colour_hash(new_colour, iteration, data_index);
         }
       }
 
-      colours = new_colours;
+      colours = std::move(new_colours);
     }
 
     std::vector<int> get_lwl2_pair_to_edge_label(std::shared_ptr<graph_generator::Graph> graph) {
@@ -98,7 +96,9 @@ namespace wlplan {
       int n_pairs = get_n_lwl2_pairs(n_nodes);
       std::vector<int> pair_to_edge_label(n_pairs, NO_EDGE_COLOUR);
       for (int u = 0; u < n_nodes; u++) {
-        for (const auto &[edge_label, v] : graph->edges[u]) {
+        for (int j = graph->offsets[u]; j < graph->offsets[u + 1]; j++) {
+          int edge_label = graph->edge_labels[j];
+          int v = graph->neighbours[j];
           if (u < v) {
             pair_to_edge_label[lwl2_pair_to_index_map(n_nodes, u, v)] = edge_label;
           }
@@ -107,116 +107,125 @@ namespace wlplan {
       return pair_to_edge_label;
     }
 
-    std::vector<std::set<int>>
-    get_lwl2_pair_to_neighbours(std::shared_ptr<graph_generator::Graph> graph) {
-      int n_nodes = graph->nodes.size();
-      int n_pairs = get_n_lwl2_pairs(n_nodes);
-      std::vector<std::set<int>> node_to_neighbours = graph->get_node_to_neighbours();
-      std::vector<std::set<int>> pair_to_neighbours(n_pairs, std::set<int>());
-      for (int u = 0; u < n_nodes; u++) {
-        for (int v = u + 1; v < n_nodes; v++) {
-          int index = lwl2_pair_to_index_map(n_nodes, u, v);
-          pair_to_neighbours[index] = node_to_neighbours[u];
-          pair_to_neighbours[index].insert(node_to_neighbours[v].cbegin(),
-                                           node_to_neighbours[v].cend());
-          pair_to_neighbours[index].erase(u);
-          pair_to_neighbours[index].erase(v);
-        }
-      }
-      return pair_to_neighbours;
-    }
-
     int LWL2Features::get_initial_colour(int index,
                                          int u,
                                          int v,
                                          const std::shared_ptr<graph_generator::Graph> &graph,
-                                         const std::vector<int> &pair_to_edge_label) {
+                                         const std::vector<int> &pair_to_edge_label,
+                                         int data_index) {
       int u_col = graph->nodes[u];
       int v_col = graph->nodes[v];
       int e_col = pair_to_edge_label[index];
-      int col = get_colour_hash({std::min(u_col, v_col), std::max(u_col, v_col), e_col}, 0);
+      const std::array<int, 3> colour_key = {std::min(u_col, v_col), std::max(u_col, v_col), e_col};
+      int col = get_colour_hash(colour_key, 0, data_index);
       return col;
     }
 
+    void LWL2Features::initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                                          const int *pairs,
+                                          Colouring &colours,
+                                          int data_index) {
+      (void)pairs;
+      int n_nodes = graph->nodes.size();
+      std::vector<int> pair_to_edge_label = get_lwl2_pair_to_edge_label(graph);
+      colours.assign(get_n_lwl2_pairs(n_nodes), 0);
+      for (int u = 0; u < n_nodes; u++) {
+        for (int v = u + 1; v < n_nodes; v++) {
+          int index = lwl2_pair_to_index_map(n_nodes, u, v);
+          colours[index] = get_initial_colour(index, u, v, graph, pair_to_edge_label, data_index);
+        }
+      }
+    }
+
     void LWL2Features::collect_impl(const std::vector<graph_generator::Graph> &graphs) {
-      // intermediate graph colours during WL
-      std::vector<Embedding> graph_colours;
-      graph_colours.reserve(graphs.size());
+      // intermediate graph colours and pairs during WL
+      ColouringStore graph_colours(spill_directory);
+      ColouringStore graph_pairs(spill_directory);
+      Colouring colours;
+      std::vector<int> pairs;
 
       // init colours
       log_iteration(0);
       for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
         const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
-        int n_nodes = graph->nodes.size();
-        int n_pairs = get_n_lwl2_pairs(n_nodes);
+        pairs.clear();
+        encode_pairs(*graph, pairs);
+        graph_pairs.push_back(pairs);
+        initialise_colours(graph, pairs.data(), colours, graph_i);
+        graph_colours.push_back(colours);
+      }
+      graph_colours.release();
+      graph_pairs.release();
 
-        Embedding colours;
-        for (int i = 0; i < n_pairs; i++) {
-          colours.insert({i, 0});
-        }
+      // main WL loop
+      refine_all(graph_colours, graph_pairs);
+    }
 
-        std::vector<int> pair_to_edge_label = get_lwl2_pair_to_edge_label(graph);
-        std::vector<std::set<int>> pair_to_neighbours = get_lwl2_pair_to_neighbours(graph);
+    void LWL2Features::collect_impl(data::ProblemSource &source) {
+      // Pairs are kept with the colours, so each graph is only generated once.
+      ColouringStore graph_colours(spill_directory);
+      ColouringStore graph_pairs(spill_directory);
+      Colouring colours;
+      std::vector<int> pairs;
 
-        // init colours
-        for (int u = 0; u < n_nodes; u++) {
-          for (int v = u + 1; v < n_nodes; v++) {
-            int index = lwl2_pair_to_index_map(n_nodes, u, v);
-            int col = get_initial_colour(index, u, v, graph, pair_to_edge_label);
-            colours[index] = col;
-          }
+      // init colours
+      log_iteration(0);
+      source.reset();
+      while (const auto problem_states = source.next()) {
+        graph_generator->set_problem(problem_states->problem);
+        for (const planning::State &state : problem_states->states) {
+          const auto graph = graph_generator->to_graph(state, workspace.graph_overlay);
+          pairs.clear();
+          encode_pairs(*graph, pairs);
+          graph_pairs.push_back(pairs);
+          initialise_colours(graph, pairs.data(), colours, graph_colours.size());
+          graph_colours.push_back(colours);
         }
-
-        graph_colours.push_back(colours);
       }
+      graph_colours.release();
+      graph_pairs.release();
 
       // main WL loop
+      refine_all(graph_colours, graph_pairs);
+    }
+
+    void LWL2Features::refine_all(ColouringStore &graph_colours, ColouringStore &graph_pairs) {
+      Colouring colours;
       for (int itr = 1; itr < iterations + 1; itr++) {
         log_iteration(itr);
-        for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
-          const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
-          std::vector<std::set<int>> pair_to_neighbours = get_lwl2_pair_to_neighbours(graph);
-          refine(graph, pair_to_neighbours, graph_colours[graph_i], itr);
+        for (size_t graph_i = 0; graph_i < graph_colours.size(); graph_i++) {
+          graph_colours.load(graph_i, colours);
+          refine(graph_pairs.begin(graph_i), colours, itr, graph_i);
+          graph_colours.store(graph_i, colours);
         }
 
         // layer pruning
         prune_this_iteration(itr, graph_colours);
+        graph_colours.release();
+        graph_pairs.release();
       }
     }
 
-
-    Embedding LWL2Features::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
-      /* 1. Initialise embedding before pruning */
-      Embedding x0;
-      int n_nodes = graph->nodes.size();
-      int n_pairs = get_n_lwl2_pairs(n_nodes);
-      Embedding colours;
-      for (int i = 0; i < n_pairs; i++) {
-        colours.insert({i, 0});
-      }
-
-      std::vector<int> pair_to_edge_label = get_lwl2_pair_to_edge_label(graph);
-      std::vector<std::set<int>> pair_to_neighbours = get_lwl2_pair_to_neighbours(graph);
-
-      /* 2. Compute initial colours */
-      for (int u = 0; u < n_nodes; u++) {
-        for (int v = u + 1; v < n_nodes; v++) {
-          int index = lwl2_pair_to_index_map(n_nodes, u, v);
-          int col = get_initial_colour(index, u, v, graph, pair_to_edge_label);
-          colours[index] = col;
-          add_colour_to_x(col, 0, x0);
-        }
+    Embedding LWL2Features::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                       EmbeddingWorkspace &workspace) {
+      /* 1. Compute initial colours */
+      std::vector<int> pairs;
+      encode_pairs(*graph, pairs);
+      Colouring colours;
+      initialise_colours(graph, pairs.data(), colours);
+      for (const int col : colours) {
+        add_colour_to_x(col, 0, workspace);
       }
 
-      /* 3. Main WL loop */
+      /* 2. Main WL loop */
       for (int itr = 1; itr < iterations + 1; itr++) {
-        refine(graph, pair_to_neighbours, colours, itr);
-        for (auto pair : colours) {
-          add_colour_to_x(pair.second, itr, x0);
+        refine(pairs.data(), colours, itr);
+        for (const int col : colours) {
+          add_colour_to_x(col, itr, workspace);
         }
       }
 
-      return x0;
+      return workspace.x.to_embedding();
     }
   }  // namespace feature_generator
 }  // namespace wlplan
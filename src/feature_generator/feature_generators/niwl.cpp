@@ -22,11 +22,12 @@ namespace wlplan {
     NIWLFeatures::NIWLFeatures(const std::string &filename, bool quiet)
         : IWLFeatures(filename, quiet) {}
 
-    Embedding NIWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
-      Embedding iwl_embedding = IWLFeatures::embed_impl(graph);
+    Embedding NIWLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                       EmbeddingWorkspace &workspace) {
+      Embedding iwl_embedding = IWLFeatures::embed_impl(graph, workspace);
       double n = (double)graph->get_n_nodes();
-      for (size_t i = 0; i < iwl_embedding.size(); i++) {
-        iwl_embedding[i] = iwl_embedding[i] / n;
+      for (auto &[_, count] : iwl_embedding) {
+        count = count / n;
       }
       return iwl_embedding;
     }
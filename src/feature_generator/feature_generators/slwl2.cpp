@@ -0,0 +1,91 @@
+#include "../../../include/feature_generator/feature_generators/slwl2.hpp"
+
+#include "../../../include/feature_generator/neighbour_containers/lwl2_neighbour_container.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace wlplan {
+  namespace feature_generator {
+    SLWL2Features::SLWL2Features(const planning::Domain &domain,
+                                 std::string graph_representation,
+                                 int iterations,
+                                 std::string pruning,
+                                 bool multiset_hash,
+                                 int radius)
+        : LWL2Features("2-slwl", domain, graph_representation, iterations, pruning, multiset_hash),
+          radius(radius) {
+      if (radius < 1) {
+        throw std::runtime_error("radius must be positive, got " + std::to_string(radius));
+      }
+    }
+
+    SLWL2Features::SLWL2Features(const std::string &filename)
+        : SLWL2Features(filename, false) {}
+
+    SLWL2Features::SLWL2Features(const std::string &filename, bool quiet)
+        : LWL2Features(filename, quiet), radius(extra_config.at("radius").get<int>()) {}
+
+    void SLWL2Features::save_config(json &config) const { config["radius"] = radius; }
+
+    void SLWL2Features::encode_pairs(const graph_generator::Graph &graph,
+                                     std::vector<int> &pairs) {
+      SparseLWL2PairNeighbours::encode(graph, radius, pairs);
+    }
+
+    void SLWL2Features::initialise_colours(const std::shared_ptr<graph_generator::Graph> &graph,
+                                           const int *pairs,
+                                           Colouring &colours,
+                                           int data_index) {
+      const SparseLWL2PairNeighbours pair_neighbours(pairs);
+      colours.resize(pair_neighbours.get_n_pairs());
+      for (int pair = 0; pair < pair_neighbours.get_n_pairs(); pair++) {
+        const int u_col = graph->nodes[pair_neighbours.get_u(pair)];
+        const int v_col = graph->nodes[pair_neighbours.get_v(pair)];
+        const std::array<int, 3> colour_key = {
+            std::min(u_col, v_col), std::max(u_col, v_col), pair_neighbours.get_edge_label(pair)};
+        colours[pair] = get_colour_hash(colour_key, 0, data_index);
+      }
+    }
+
+    void
+    SLWL2Features::refine(const int *pairs, Colouring &colours, int iteration, int data_index) {
+      const SparseLWL2PairNeighbours pair_neighbours(pairs);
+
+      // memory for the colour key and the colour pairs of neighbours
+      std::vector<int> new_colour;
+      std::vector<uint64_t> colour_pairs;
+
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
+      for (int pair = 0; pair < pair_neighbours.get_n_pairs(); pair++) {
+        if (colours[pair] == UNSEEN_COLOUR) {
+          continue;
+        }
+
+        colour_pairs.clear();
+        bool seen = pair_neighbours.for_each(pair, [&](const int pair1, const int pair2) {
+          int pair1_col =
+              pair1 == SparseLWL2PairNeighbours::FAR_PAIR ? FAR_PAIR_COLOUR : colours[pair1];
+          int pair2_col =
+              pair2 == SparseLWL2PairNeighbours::FAR_PAIR ? FAR_PAIR_COLOUR : colours[pair2];
+          if (pair1_col == UNSEEN_COLOUR || pair2_col == UNSEEN_COLOUR) {
+            return false;
+          }
+          colour_pairs.push_back(((uint64_t)std::max(pair1_col, pair2_col) << 32) |
+                                 (uint64_t)std::min(pair1_col, pair2_col));
+          return true;
+        });
+        if (!seen) {
+          continue;
+        }
+
+        new_colour = {colours[pair]};
+        append_pair_counts(colour_pairs, multiset_hash, new_colour);
+        new_colours[pair] = get_colour_hash(new_colour, iteration, data_index);
+      }
+
+      colours = std::move(new_colours);
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -3,7 +3,9 @@
 #include "../../../include/graph_generator/graph_generator_factory.hpp"
 #include "../../../include/utils/exceptions.hpp"
 #include "../../../include/utils/nlohmann/json.hpp"
+#include "../../../include/utils/parallel.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <queue>
 #include <set>
@@ -34,19 +36,18 @@ namespace wlplan {
 
     int WLFeatures::get_n_features() const { return get_n_colours(); }
 
-    void WLFeatures::refine(const std::shared_ptr<graph_generator::Graph> &graph,
+    template <typename G>
+    void WLFeatures::refine(const G &graph,
                             std::set<int> &nodes,
-                            Embedding &colours,
+                            Colouring &colours,
                             int iteration,
+                            NeighbourContainer &container,
                             int data_index) {
       // memory for storing string and hashed int representation of colours
       std::vector<int> new_colour;
       int new_colour_compressed;
 
-      Embedding new_colours;
-      for (int i = 0; i < (int) colours.size(); i++) {
-        new_colours.insert({i, UNSEEN_COLOUR});
-      }
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
       std::vector<int> nodes_to_discard;
 
       for (const int u : nodes) {
@@ -57,11 +58,11 @@ namespace wlplan {
           nodes_to_discard.push_back(u);
           goto end_of_iteration;
         }
-        neighbour_container->clear();
+        container.clear();
 
-        for (const auto &edge : graph->edges[u]) {
+        for (int j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
           // skip unseen colours
-          int neighbour_colour = colours[edge.second];
+          int neighbour_colour = colours[graph.neighbours[j]];
           if (neighbour_colour == UNSEEN_COLOUR) {
             new_colour_compressed = UNSEEN_COLOUR;
             nodes_to_discard.push_back(u);
@@ -69,11 +70,11 @@ namespace wlplan {
           }
 
           // add sorted neighbour (colour, edge_label) pair
-          neighbour_container->insert(neighbour_colour, edge.first);
+          container.insert(neighbour_colour, graph.edge_labels[j]);
         }
 
         // add current colour and sorted neighbours into sorted colour key
-        new_colour = neighbour_container->to_vector();
+        new_colour = container.to_vector();
         new_colour.push_back(current_colour);
 
         // hash seen colours
@@ -91,26 +92,33 @@ namespace wlplan {
       colours = std::move(new_colours);
     }
 
+    void WLFeatures::refine(const std::shared_ptr<graph_generator::Graph> &graph,
+                            std::set<int> &nodes,
+                            Colouring &colours,
+                            int iteration,
+                            NeighbourContainer &container,
+                            int data_index) {
+      refine(*graph, nodes, colours, iteration, container, data_index);
+    }
+
     void WLFeatures::refine_fast(const std::shared_ptr<graph_generator::Graph> &graph,
-                                 Embedding &colours,
-                                 int iteration) {
+                                 Colouring &colours,
+                                 int iteration,
+                                 NeighbourContainer &container) {
       // memory for storing string and hashed int representation of colours
       std::vector<int> new_colour;
-      Embedding new_colours;
-      for (int i = 0; i < (int) colours.size(); i++) {
-        new_colours.insert({i, UNSEEN_COLOUR});
-      }
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
 
       for (size_t u = 0; u < colours.size(); u++) {
-        neighbour_container->clear_init(graph->edges[u].size());
+        container.clear_init(graph->get_degree(u));
 
-        for (const auto &edge : graph->edges[u]) {
+        for (int j = graph->offsets[u]; j < graph->offsets[u + 1]; j++) {
           // add sorted neighbour (colour, edge_label) pair
-          neighbour_container->insert(colours[edge.second], edge.first);
+          container.insert(colours[graph->neighbours[j]], graph->edge_labels[j]);
         }
 
         // add current colour and sorted neighbours into sorted colour key
-        new_colour = neighbour_container->to_vector();
+        new_colour = container.to_vector();
         new_colour.push_back(colours[u]);
 
         // hash
@@ -120,12 +128,178 @@ namespace wlplan {
       colours = std::move(new_colours);
     }
 
+    template <typename G>
+    void WLFeatures::refine_concurrent(const G &graph,
+                                       Colouring &colours,
+                                       int iteration,
+                                       NeighbourContainer &container,
+                                       ConcurrentColourHash &hash,
+                                       size_t data_index) {
+      if (iteration == 0) {
+        colours.resize(graph.get_n_nodes());
+        for (int u = 0; u < graph.get_n_nodes(); u++) {
+          colours[u] = hash.get(ColourKey(&graph.nodes[u], 1),
+                              ConcurrentColourHash::occurrence(data_index, u));
+        }
+        return;
+      }
+
+      std::vector<int> new_colour;
+      Colouring new_colours(colours.size(), UNSEEN_COLOUR);
+
+      for (size_t u = 0; u < colours.size(); u++) {
+        // skip unseen colours, which may appear after layer pruning
+        int current_colour = colours[u];
+        if (current_colour == UNSEEN_COLOUR) {
+          continue;
+        }
+        container.clear();
+
+        bool unseen_neighbour = false;
+        for (int j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
+          int neighbour_colour = colours[graph.neighbours[j]];
+          if (neighbour_colour == UNSEEN_COLOUR) {
+            unseen_neighbour = true;
+            break;
+          }
+          container.insert(neighbour_colour, graph.edge_labels[j]);
+        }
+        if (unseen_neighbour) {
+          continue;
+        }
+
+        new_colour = container.to_vector();
+        new_colour.push_back(current_colour);
+        new_colours[u] = hash.get(new_colour, ConcurrentColourHash::occurrence(data_index, u));
+      }
+
+      colours = std::move(new_colours);
+    }
+
+    void WLFeatures::collect_impl_parallel(const std::vector<graph_generator::Graph> &graphs) {
+      ColouringStore graph_colours(spill_directory);
+      std::vector<Colouring> scratch(n_threads);
+      std::vector<EmbeddingWorkspace> workspaces;
+      for (int i = 0; i < n_threads; i++) {
+        workspaces.push_back(new_workspace());
+      }
+
+      for (int itr = 0; itr < iterations + 1; itr++) {
+        log_iteration(itr);
+        ConcurrentColourHash hash(colour_hash[itr], n_threads);
+        if (itr == 0) {
+          std::vector<Colouring> init_colours(graphs.size());
+          utils::parallel_for(graphs.size(), n_threads, [&](int thread_id, size_t graph_i) {
+            refine_concurrent(graphs[graph_i],
+                              init_colours[graph_i],
+                              itr,
+                              *workspaces[thread_id].neighbour_container,
+                              hash,
+                              graph_i);
+          });
+          for (const Colouring &colours : init_colours) {
+            graph_colours.push_back(colours);
+          }
+        } else {
+          utils::parallel_for(graphs.size(), n_threads, [&](int thread_id, size_t graph_i) {
+            graph_colours.load(graph_i, scratch[thread_id]);
+            refine_concurrent(graphs[graph_i],
+                              scratch[thread_id],
+                              itr,
+                              *workspaces[thread_id].neighbour_container,
+                              hash,
+                              graph_i);
+            graph_colours.store(graph_i, scratch[thread_id]);
+          });
+        }
+        add_concurrent_colours(hash, itr, graph_colours);
+
+        // layer pruning
+        if (itr > 0) {
+          prune_this_iteration(itr, graph_colours);
+        }
+        graph_colours.release();
+      }
+    }
+
+    void WLFeatures::collect_impl_parallel(data::ProblemSource &source) {
+      // Graphs are kept with the colours, so each graph is only generated once. The number of
+      // states is only known after the first pass over the source.
+      ColouringStore graph_colours(spill_directory);
+      ColouringStore stored_graphs(spill_directory);
+      std::vector<Colouring> scratch(n_threads);
+      std::vector<EmbeddingWorkspace> workspaces;
+      for (int i = 0; i < n_threads; i++) {
+        workspaces.push_back(new_workspace());
+      }
+
+      // init colours
+      log_iteration(0);
+      ConcurrentColourHash init_hash(colour_hash[0], n_threads);
+      source.reset();
+      while (const auto problem_states = source.next()) {
+        const auto &states = problem_states->states;
+        graph_generator->set_problem(problem_states->problem);
+
+        // colourings and graphs are appended in order once a problem is done
+        const size_t offset = graph_colours.size();
+        std::vector<Colouring> init_colours(states.size());
+        std::vector<std::vector<int>> encoded_graphs(states.size());
+        utils::parallel_for(states.size(), n_threads, [&](int thread_id, size_t i) {
+          const auto graph =
+              graph_generator->to_graph(states[i], workspaces[thread_id].graph_overlay);
+          StoredGraph::encode(*graph, encoded_graphs[i]);
+          refine_concurrent(*graph,
+                            init_colours[i],
+                            0,
+                            *workspaces[thread_id].neighbour_container,
+                            init_hash,
+                            offset + i);
+        });
+        for (size_t i = 0; i < states.size(); i++) {
+          graph_colours.push_back(init_colours[i]);
+          stored_graphs.push_back(encoded_graphs[i]);
+        }
+      }
+      add_concurrent_colours(init_hash, 0, graph_colours);
+      graph_colours.release();
+      stored_graphs.release();
+
+      // main WL loop
+      for (int itr = 1; itr < iterations + 1; itr++) {
+        log_iteration(itr);
+        ConcurrentColourHash hash(colour_hash[itr], n_threads);
+        utils::parallel_for(graph_colours.size(), n_threads, [&](int thread_id, size_t graph_i) {
+          const StoredGraph graph(stored_graphs.begin(graph_i));
+          graph_colours.load(graph_i, scratch[thread_id]);
+          refine_concurrent(graph,
+                            scratch[thread_id],
+                            itr,
+                            *workspaces[thread_id].neighbour_container,
+                            hash,
+                            graph_i);
+          graph_colours.store(graph_i, scratch[thread_id]);
+        });
+        add_concurrent_colours(hash, itr, graph_colours);
+
+        // layer pruning
+        prune_this_iteration(itr, graph_colours);
+        graph_colours.release();
+        stored_graphs.release();
+      }
+    }
+
     void WLFeatures::collect_impl(const std::vector<graph_generator::Graph> &graphs) {
+      if (n_threads > 1) {
+        collect_impl_parallel(graphs);
+        return;
+      }
+
       // Intermediate graph colours during WL
       // It could be more optimal to use map<int, int> for graph colours, with UNSEEN_COLOUR
       // nodes not showing up in the map. However, this would make the code more complex.
-      std::vector<Embedding> graph_colours;
-      graph_colours.reserve(graphs.size());
+      ColouringStore graph_colours(spill_directory);
+      Colouring colours;
 
       // init colours
       log_iteration(0);
@@ -133,112 +307,352 @@ namespace wlplan {
         const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
         int n_nodes = graph->nodes.size();
 
-        Embedding colours;
-        for (int i = 0; i < n_nodes; i++) {
-          colours.insert({i, 0});
-        }
+        colours.assign(n_nodes, 0);
         for (int node_i = 0; node_i < n_nodes; node_i++) {
-          int col = get_colour_hash({graph->nodes[node_i]}, 0, graph_i);
+          int col = get_colour_hash(ColourKey(&graph->nodes[node_i], 1), 0, graph_i);
           colours[node_i] = col;
         }
         graph_colours.push_back(colours);
       }
+      graph_colours.release();
 
       // main WL loop
       for (int itr = 1; itr < iterations + 1; itr++) {
         log_iteration(itr);
         for (size_t graph_i = 0; graph_i < graphs.size(); graph_i++) {
-          const auto graph = std::make_shared<graph_generator::Graph>(graphs[graph_i]);
-          std::set<int> nodes = graph->get_nodes_set();
-          refine(graph, nodes, graph_colours[graph_i], itr, graph_i);
+          std::set<int> nodes = graphs[graph_i].get_nodes_set();
+          graph_colours.load(graph_i, colours);
+          refine(graphs[graph_i], nodes, colours, itr, *neighbour_container, graph_i);
+          graph_colours.store(graph_i, colours);
         }
 
         // layer pruning
         prune_this_iteration(itr, graph_colours);
+        graph_colours.release();
       }
     }
-	
-    void WLFeatures::collect_impl(const std::vector<data::ProblemDataset> &data) {
-      // Intermediate graph colours during WL
-      // It could be more optimal to use map<int, int> for graph colours, with UNSEEN_COLOUR
-      // nodes not showing up in the map. However, this would make the code more complex.
-      std::vector<Embedding> graph_colours;
-      size_t ret = 0;
-      for (const auto &problem_states : data) {
-        ret += problem_states.states.size();
+
+    void WLFeatures::collect_impl(data::ProblemSource &source) {
+      if (n_threads > 1) {
+        collect_impl_parallel(source);
+        return;
       }
-      graph_colours.reserve(ret);
-      int data_index = 0;
+
+      // Intermediate graph colours during WL, and graphs which are kept with the colours so that
+      // each graph is only generated once
+      ColouringStore graph_colours(spill_directory);
+      ColouringStore stored_graphs(spill_directory);
+      Colouring colours;
+      std::vector<int> encoded_graph;
+
       // init colours
       log_iteration(0);
-      for (const auto &problem_states : data) {
-      const auto &problem = problem_states.problem;
-      const auto &states = problem_states.states;
-        graph_generator->set_problem(problem);
-        std::string p_string = problem.to_string();
-        for (const planning::State &state : states) {
-          const auto graph = graph_generator->to_graph(state);
+      source.reset();
+      while (const auto problem_states = source.next()) {
+        graph_generator->set_problem(problem_states->problem);
+        for (const planning::State &state : problem_states->states) {
+          const auto graph = graph_generator->to_graph(state, workspace.graph_overlay);
           int n_nodes = graph->nodes.size();
+          int data_index = graph_colours.size();
 
-          Embedding colours;
-          for (int i = 0; i < n_nodes; i++) {
-            colours.insert({i, 0});
-          }
+          colours.assign(n_nodes, 0);
           for (int node_i = 0; node_i < n_nodes; node_i++) {
-            int col = get_colour_hash({graph->nodes[node_i]}, 0, data_index);
+            int col = get_colour_hash(ColourKey(&graph->nodes[node_i], 1), 0, data_index);
             colours[node_i] = col;
           }
           graph_colours.push_back(colours);
-		  data_index++;
+          encoded_graph.clear();
+          StoredGraph::encode(*graph, encoded_graph);
+          stored_graphs.push_back(encoded_graph);
         }
-	  }
+      }
+      graph_colours.release();
+      stored_graphs.release();
+
       // main WL loop
       for (int itr = 1; itr < iterations + 1; itr++) {
-		    data_index = 0;
         log_iteration(itr);
-        for (const auto &problem_states : data) {
-          const auto &problem = problem_states.problem;
-          const auto &states = problem_states.states;
-          graph_generator->set_problem(problem);
-		  for (const planning::State &state : states) {
-            const auto graph = graph_generator->to_graph(state);
-          std::set<int> nodes = graph->get_nodes_set();
-          refine(graph, nodes, graph_colours[data_index], itr, data_index);
-		data_index++;
-        }
-	}
+        for (size_t graph_i = 0; graph_i < graph_colours.size(); graph_i++) {
+          const StoredGraph graph(stored_graphs.begin(graph_i));
+          std::set<int> nodes = graph.get_nodes_set();
+          graph_colours.load(graph_i, colours);
+          refine(graph, nodes, colours, itr, *neighbour_container, graph_i);
+          graph_colours.store(graph_i, colours);
+        }
+
         // layer pruning
         prune_this_iteration(itr, graph_colours);
+        graph_colours.release();
+        stored_graphs.release();
       }
     }
 
-
-    Embedding WLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph) {
+    Embedding WLFeatures::embed_impl(const std::shared_ptr<graph_generator::Graph> &graph,
+                                     EmbeddingWorkspace &workspace) {
       /* 1. Initialise embedding before pruning, and set up memory */
-      Embedding x0;
       int n_nodes = graph->nodes.size();
-      Embedding colours;
-      for (int i = 0; i < n_nodes; i++) {
-        colours.insert({i, 0});
-      }
+      Colouring colours(n_nodes, 0);
       std::set<int> nodes = graph->get_nodes_set();
 
       /* 2. Compute initial colours */
       for (const int node_i : nodes) {
-        int col = get_colour_hash({graph->nodes[node_i]}, 0);
+        int col = get_colour_hash(ColourKey(&graph->nodes[node_i], 1), 0);
         colours[node_i] = col;
-        add_colour_to_x(col, 0, x0);
+        add_colour_to_x(col, 0, workspace);
       }
 
       /* 3. Main WL loop */
       for (int itr = 1; itr < iterations + 1; itr++) {
-        refine(graph, nodes, colours, itr);
-        for (auto pair : colours) {
-          add_colour_to_x(pair.second, itr, x0);
+        refine(graph, nodes, colours, itr, *workspace.neighbour_container);
+        for (const int col : colours) {
+          add_colour_to_x(col, itr, workspace);
+        }
+      }
+
+      return workspace.x.to_embedding();
+    }
+
+    std::shared_ptr<WLContext> WLFeatures::init_context(const planning::State &state) {
+      if (feature_name != "wl") {
+        throw NotSupportedError("Incremental embedding for feature option `" + feature_name +
+                                "`");
+      }
+      if (graph_generator == nullptr) {
+        throw std::runtime_error("Incremental embedding requires a graph generator.");
+      }
+      collecting = false;
+      if (!collected) {
+        throw std::runtime_error("collect() must be called before embedding");
+      }
+      if (context_state == nullptr) {
+        context_state = std::make_shared<WLContextState>();
+      }
+
+      auto context = std::make_shared<WLContext>();
+      context->root = context.get();
+      context->problem = graph_generator->get_problem();
+      context->depth = 0;
+      context->atoms = state.get_atoms();
+      context->h = 0.0;
+      context->state = context_state;
+      context->h = rebuild_context_state(*context);
+      context_state->context = context;
+      return context;
+    }
+
+    std::shared_ptr<WLContext>
+    WLFeatures::successor_context(const std::shared_ptr<WLContext> &parent,
+                                  const std::vector<planning::Atom> &add_atoms,
+                                  const std::vector<planning::Atom> &del_atoms) {
+      move_context_state(parent);
+
+      auto context = std::make_shared<WLContext>();
+      context->parent = parent;
+      context->root = parent->root;
+      context->depth = parent->depth + 1;
+      context->h = parent->h;
+      context->state = context_state;
+
+      graph_generator::DynamicGraph &graph = *context_state->graph;
+      graph.set_log(&context->graph_changes);
+      std::vector<int> changed_nodes;
+      try {
+        changed_nodes = graph_generator->apply_transition(graph, add_atoms, del_atoms);
+      } catch (...) {
+        graph.set_log(nullptr);
+        graph.undo(context->graph_changes);
+        throw;
+      }
+      graph.set_log(nullptr);
+      recolour_context(changed_nodes, context->h, context.get());
+      context_state->context = context;
+      return context;
+    }
+
+    double WLFeatures::rebuild_context_state(const WLContext &root) {
+      WLContextState &state = *context_state;
+      state.graph = graph_generator->to_dynamic_graph(planning::State(root.atoms));
+      state.colours = std::vector<Colouring>(iterations + 1);
+      state.counts.clear();
+
+      // colour all nodes starting from an empty colouring
+      std::vector<int> nodes;
+      for (int u = 0; u < state.graph->get_n_indices(); u++) {
+        if (!state.graph->is_removed(u)) {
+          nodes.push_back(u);
+        }
+      }
+      double h = 0.0;
+      recolour_context(nodes, h, nullptr);
+      return h;
+    }
+
+    void WLFeatures::move_context_state(const std::shared_ptr<WLContext> &context) {
+      if (context_state == nullptr || context->state.lock() != context_state) {
+        throw std::runtime_error("Context was not made by this feature generator.");
+      }
+      if (context->root->problem != graph_generator->get_problem()) {
+        throw std::runtime_error("Context was made for a different problem than the one that is "
+                                 "set. Call init_context() again after set_problem().");
+      }
+      WLContextState &state = *context_state;
+
+      // contexts from the current one to the common ancestor are undone, and contexts from there
+      // to the target are redone, unless they are in different trees and the root is rebuilt
+      const WLContext *current = state.context.get();
+      const WLContext *target = context.get();
+      std::vector<const WLContext *> redo;
+      if (current == nullptr || current->root != target->root) {
+        for (; target != nullptr; target = target->parent.get()) {
+          redo.push_back(target);
+        }
+        rebuild_context_state(*redo.back());
+        redo.pop_back();
+      } else {
+        while (current != target) {
+          if (current->depth >= target->depth) {
+            state.graph->undo(current->graph_changes);
+            for (auto it = current->colour_changes.rbegin(); it != current->colour_changes.rend();
+                 it++) {
+              state.colours[it->iteration][it->node] = it->old_colour;
+              update_context_count(it->new_colour, -1);
+              update_context_count(it->old_colour, 1);
+            }
+            current = current->parent.get();
+          } else {
+            redo.push_back(target);
+            target = target->parent.get();
+          }
+        }
+      }
+
+      for (auto it = redo.rbegin(); it != redo.rend(); it++) {
+        const WLContext &next = **it;
+        state.graph->redo(next.graph_changes);
+        for (Colouring &colours : state.colours) {
+          if ((int)colours.size() < state.graph->get_n_indices()) {
+            colours.resize(state.graph->get_n_indices(), WLContext::NO_NODE);
+          }
+        }
+        for (const auto &change : next.colour_changes) {
+          state.colours[change.iteration][change.node] = change.new_colour;
+          update_context_count(change.old_colour, -1);
+          update_context_count(change.new_colour, 1);
+        }
+      }
+      state.context = context;
+    }
+
+    int WLFeatures::context_colour(const int u, const int iteration) {
+      const graph_generator::DynamicGraph &graph = *context_state->graph;
+      if (graph.is_removed(u)) {
+        return WLContext::NO_NODE;
+      }
+      if (iteration == 0) {
+        const int node_colour = graph.get_node_colour(u);
+        return get_colour_hash(ColourKey(&node_colour, 1), 0);
+      }
+
+      // same as refine(), where unseen colours stay unseen and spread to neighbours
+      const Colouring &colours = context_state->colours[iteration - 1];
+      if (colours[u] == UNSEEN_COLOUR) {
+        return UNSEEN_COLOUR;
+      }
+      NeighbourContainer &container = *workspace.neighbour_container;
+      container.clear();
+      bool unseen = false;
+      graph.for_each_edge(u, [&](const int r, const int v) {
+        if (colours[v] == UNSEEN_COLOUR) {
+          unseen = true;
+        } else if (!unseen) {
+          container.insert(colours[v], r);
+        }
+      });
+      if (unseen) {
+        return UNSEEN_COLOUR;
+      }
+      std::vector<int> new_colour = container.to_vector();
+      new_colour.push_back(colours[u]);
+      return get_colour_hash(new_colour, iteration);
+    }
+
+    void WLFeatures::update_context_count(const int colour, const int delta) {
+      if (colour == WLContext::NO_NODE || colour == UNSEEN_COLOUR) {
+        return;
+      }
+      int &count = context_state->counts[colour];
+      count += delta;
+      if (count == 0) {
+        context_state->counts.erase(colour);
+      }
+    }
+
+    void WLFeatures::recolour_context(const std::vector<int> &changed_nodes,
+                                      double &h,
+                                      WLContext *context) {
+      WLContextState &state = *context_state;
+      const graph_generator::DynamicGraph &graph = *state.graph;
+      const int n_indices = graph.get_n_indices();
+      for (Colouring &colours : state.colours) {
+        if ((int)colours.size() < n_indices) {
+          colours.resize(n_indices, WLContext::NO_NODE);
+        }
+      }
+
+      // changed nodes are recoloured at every iteration, and other nodes only if their colour or
+      // a neighbour's colour changed in the previous iteration
+      std::vector<int> recoloured;
+      std::vector<int> candidates;
+      for (int itr = 0; itr < iterations + 1; itr++) {
+        candidates = changed_nodes;
+        for (const int u : recoloured) {
+          candidates.push_back(u);
+          if (!graph.is_removed(u)) {
+            graph.for_each_edge(u, [&](const int r, const int v) {
+              (void)r;
+              candidates.push_back(v);
+            });
+          }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        recoloured.clear();
+        Colouring &colours = state.colours[itr];
+        for (const int u : candidates) {
+          const int new_colour = context_colour(u, itr);
+          if (new_colour == colours[u]) {
+            continue;
+          }
+          if (context != nullptr) {
+            context->colour_changes.push_back(
+                WLContext::ColourChange{itr, u, colours[u], new_colour});
+          }
+          for (const auto &[colour, delta] : {std::make_pair(colours[u], -1),
+                                              std::make_pair(new_colour, 1)}) {
+            if (store_weights && colour != WLContext::NO_NODE && colour != UNSEEN_COLOUR) {
+              h += delta * weights[colour];
+            }
+            update_context_count(colour, delta);
+          }
+          colours[u] = new_colour;
+          recoloured.push_back(u);
         }
       }
+    }
+
+    Embedding WLFeatures::embed_context(const std::shared_ptr<WLContext> &context) {
+      move_context_state(context);
+      Embedding x(context_state->counts.begin(), context_state->counts.end());
+      std::sort(x.begin(), x.end());
+      return x;
+    }
 
-      return x0;
+    double WLFeatures::predict_context(const WLContext &context) const {
+      if (!store_weights) {
+        throw std::runtime_error("Weights have not been set for prediction.");
+      }
+      return context.h;
     }
   }  // namespace feature_generator
 }  // namespace wlplan
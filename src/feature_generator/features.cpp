@@ -1,5 +1,6 @@
 #include "../../include/feature_generator/features.hpp"
 
+#include "../../include/feature_generator/concurrent_colour_hash.hpp"
 #include "../../include/feature_generator/maxsat.hpp"
 #include "../../include/feature_generator/neighbour_containers/kwl2_neighbour_container.hpp"
 #include "../../include/feature_generator/neighbour_containers/lwl2_neighbour_container.hpp"
@@ -8,7 +9,9 @@
 #include "../../include/graph_generator/graph_generator_factory.hpp"
 #include "../../include/utils/exceptions.hpp"
 #include "../../include/utils/nlohmann/json.hpp"
+#include "../../include/utils/parallel.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -33,6 +36,7 @@ namespace wlplan {
           iterations(iterations),
           pruning(pruning),
           multiset_hash(multiset_hash),
+          extra_config(json::object()),
           unseen_colours_filename("dummy.txt", std::ios::app)
     {
       quiet = false;
@@ -46,17 +50,20 @@ namespace wlplan {
       store_weights = false;
       save_unseen_colours = false;
 
-      colour_hash = new_colour_hash();
+      set_colour_hash(new_colour_hash());
       layer_to_colours = new_layer_to_colours();
-	    colour_statistics = std::vector<std::map<int, int>>();
+      colour_statistics = ColourStatistics();
 
       initialise_variables();
     }
 
     void Features::check_valid_configuration() {
-      // check pruning support
-      if (pruning != PruningOptions::NONE &&
-          !std::set<std::string>({"wl", "2-lwl"}).count(feature_name)) {
+      // check pruning support, where individualised WL colours have the same keys as WL colours
+      // after the first layer so that pruning them all at once is supported
+      const bool bulk_pruning = pruning == PruningOptions::ALL_MAXSAT &&
+                                std::set<std::string>({"iwl", "niwl"}).count(feature_name);
+      if (pruning != PruningOptions::NONE && !bulk_pruning &&
+          !std::set<std::string>({"wl", "2-kwl", "2-lwl", "2-slwl"}).count(feature_name)) {
         throw NotSupportedError("Pruning option `" + pruning + "` for feature option `" +
                                 feature_name + "`");
       }
@@ -66,71 +73,187 @@ namespace wlplan {
       graph_generator = graph_generator::init_feature_generator(graph_representation, *domain);
       seen_colour_statistics =
           std::vector<std::vector<long>>(2, std::vector<long>(iterations + 1, 0));
+      neighbour_container = new_neighbour_container();
+      workspace = new_workspace();
+      n_threads = 1;
+      maxsat_solver = "embedded";
+      maxsat_time_limit = 0;
+      frozen = false;
+    }
 
+    std::shared_ptr<NeighbourContainer> Features::new_neighbour_container() const {
       // We use a factory style method here instead of a virtual function as this is called
       // from a constructor, from which virtual functions are not allowed to be called.
       if (std::set<std::string>({"wl", "ccwl", "ccwl-a", "iwl", "niwl"}).count(feature_name)) {
         if (graph_representation == "custom")
-          neighbour_container = std::make_shared<WLNeighbourContainer>(multiset_hash);
+          return std::make_shared<WLNeighbourContainer>(multiset_hash);
         else
-          neighbour_container = std::make_shared<WLNeighbourContainerMk2>(
+          return std::make_shared<WLNeighbourContainerMk2>(
               multiset_hash, graph_generator->get_n_features(), graph_generator->get_n_relations());
       } else if (feature_name == "2-kwl") {
-        neighbour_container = std::make_shared<KWL2NeighbourContainer>(multiset_hash);
-      } else if (feature_name == "2-lwl") {
-        neighbour_container = std::make_shared<LWL2NeighbourContainer>(multiset_hash);
+        return std::make_shared<KWL2NeighbourContainer>(multiset_hash);
+      } else if (feature_name == "2-lwl" || feature_name == "2-slwl") {
+        return std::make_shared<LWL2NeighbourContainer>(multiset_hash);
       } else {
         throw NotImplementedError("Neighbour container for feature_name=" + feature_name);
       }
     }
 
+    EmbeddingWorkspace Features::new_workspace() const {
+      EmbeddingWorkspace ret;
+      ret.neighbour_container = new_neighbour_container();
+      ret.seen_colour_statistics =
+          std::vector<std::vector<long>>(2, std::vector<long>(iterations + 1, 0));
+      return ret;
+    }
+
+    // moves seen colour statistics from one workspace or Features to another, where either may
+    // have fewer iterations if layers were pruned after it was made
+    void move_seen_colour_statistics(std::vector<std::vector<long>> &from,
+                                     std::vector<std::vector<long>> &to) {
+      for (size_t i = 0; i < std::min(from.size(), to.size()); i++) {
+        for (size_t itr = 0; itr < std::min(from[i].size(), to[i].size()); itr++) {
+          to[i][itr] += from[i][itr];
+          from[i][itr] = 0;
+        }
+      }
+    }
+
+    void Features::merge_workspace(EmbeddingWorkspace &workspace) {
+      move_seen_colour_statistics(workspace.seen_colour_statistics, seen_colour_statistics);
+    }
+
+    void Features::merge_workspace(EmbeddingWorkspace &thread_workspace,
+                                   EmbeddingWorkspace &target) const {
+      for (const auto &[col, count] : thread_workspace.x.to_embedding()) {
+        target.x.add(col, count);
+      }
+      move_seen_colour_statistics(thread_workspace.seen_colour_statistics,
+                                  target.seen_colour_statistics);
+    }
+
+    void Features::reserve_thread_workspaces(EmbeddingWorkspace &workspace, const int n) const {
+      while ((int)workspace.thread_workspaces.size() < n) {
+        workspace.thread_workspaces.push_back(new_workspace());
+      }
+    }
+
+    void Features::set_n_threads(const int n_threads) {
+      if (n_threads < 1) {
+        throw std::runtime_error("n_threads must be at least 1, got " +
+                                 std::to_string(n_threads));
+      }
+      this->n_threads = n_threads;
+    }
+
+    int Features::get_n_embedding_threads() const {
+      // unseen colours are written to file in the order they are encountered
+      return save_unseen_colours ? 1 : n_threads;
+    }
+
     std::vector<std::set<int>> Features::new_layer_to_colours() const {
       return std::vector<std::set<int>>(iterations + 1, std::set<int>());
     }
 
     VecColourHash Features::new_colour_hash() const {
+      return VecColourHash(iterations + 1, ColourHash());
+    }
+
+    void Features::set_colour_hash(VecColourHash &&colour_hash) {
+      this->colour_hash = std::move(colour_hash);
+      n_colours = 0;
+      for (const ColourHash &layer_hash : this->colour_hash) {
+        n_colours += layer_hash.size();
+      }
+    }
+
+    VecColourHash Features::get_colour_hash_layers() const {
+      if (!frozen) {
+        return colour_hash;
+      }
       VecColourHash ret;
-      for (int i = 0; i < iterations + 1; i++) {
-        ret.push_back(std::unordered_map<std::vector<int>, int, int_vector_hasher>());
+      for (const FrozenColourHash &layer_hash : frozen_colour_hash) {
+        ret.push_back(layer_hash.to_colour_hash());
       }
       return ret;
     }
 
+    void Features::freeze() {
+      if (frozen) {
+        return;
+      }
+      frozen_colour_hash.clear();
+      for (const ColourHash &layer_hash : colour_hash) {
+        frozen_colour_hash.push_back(FrozenColourHash(layer_hash));
+      }
+      // keep the number of layers so that colour_hash[iteration] stays valid
+      colour_hash = VecColourHash(colour_hash.size(), ColourHash());
+      frozen = true;
+    }
+
+    void Features::unfreeze() {
+      if (!frozen) {
+        return;
+      }
+      colour_hash = get_colour_hash_layers();
+      frozen_colour_hash.clear();
+      frozen = false;
+    }
+
     Features::Features(const std::string &filename) : Features(filename, false) {}
 
-    Features::Features(const std::string &filename, const bool quiet):unseen_colours_filename("dummy.txt", std::ios::app) {
+    Features::Features(const std::string &filename, const bool quiet)
+        : unseen_colours_filename("dummy.txt", std::ios::app) {
       // let Python handle file exceptions
-      std::ifstream i(filename);
-      json j;
-      i >> j;
+      if (is_binary_model(filename)) {
+        load_binary(filename);
+      } else {
+        load_json(filename);
+      }
+
       std::string cur_pkg_ver = MACRO_STRINGIFY(WLPLAN_VERSION);
       cur_pkg_ver.erase(std::remove(cur_pkg_ver.begin(), cur_pkg_ver.end(), '\"'),
                         cur_pkg_ver.end());
-
-      // load configurations
-      package_version = j["package_version"];
       if (package_version != cur_pkg_ver) {
         std::cout << "WARNING: loaded generator was created with version " << package_version
                   << " but current version is " << cur_pkg_ver << ". ";
         std::cout << "This may lead to unexpected behaviour." << std::endl;
       }
-      feature_name = j.at("feature_name").get<std::string>();
-      graph_representation = j.at("graph_representation").get<std::string>();
-      iterations = j.at("iterations").get<int>();
-      pruning = j.at("pruning").get<std::string>();
-      multiset_hash = j.at("multiset_hash").get<bool>();
 
-      // load colours
-      StrColourHash colour_hash_str = j.at("colour_hash").get<StrColourHash>();
-      colour_hash = str_to_int_colour_hash(colour_hash_str);
-      colour_to_layer = j.at("colour_to_layer").get<std::unordered_map<int, int>>();
+      store_weights = weights.size() > 0;
 
-      // initialise domain object
-      std::string domain_name = j.at("domain").at("name").get<std::string>();
-	    std::vector<std::string> types = j.at("domain").at("types").get<std::vector<std::string>>();
+      // reconstruct layer to colours
+      layer_to_colours = get_layer_to_colours();
+
+      // initialise other variables (assume collection already done)
+      collected = true;
+      collecting = false;
+      pruned = true;
+      save_unseen_colours = false;
+
+      initialise_variables();
+
+      if (!quiet) {
+        std::cout << "package_version=" << package_version << std::endl;
+        std::cout << "feature_name=" << feature_name << std::endl;
+        std::cout << "graph_representation=" << graph_representation << std::endl;
+        std::cout << "iterations=" << iterations << std::endl;
+        std::cout << "pruning=" << pruning << std::endl;
+        std::cout << "multiset_hash=" << multiset_hash << std::endl;
+        if (!extra_config.empty()) {
+          std::cout << "extra_config=" << extra_config.dump() << std::endl;
+        }
+        std::cout << "domain=" << domain->to_string() << std::endl;
+        std::cout << "weights_size=" << weights.size() << std::endl;
+      }
+    }
+
+    std::shared_ptr<planning::Domain> domain_from_json(const json &j) {
+      std::string domain_name = j.at("name").get<std::string>();
+      std::vector<std::string> types = j.at("types").get<std::vector<std::string>>();
 
       std::vector<std::pair<std::string, int>> raw_predicates =
-          j.at("domain").at("predicates").get<std::vector<std::pair<std::string, int>>>();
+          j.at("predicates").get<std::vector<std::pair<std::string, int>>>();
       std::vector<planning::Predicate> domain_predicates = std::vector<planning::Predicate>();
       for (size_t i = 0; i < raw_predicates.size(); i++) {
         domain_predicates.push_back(
@@ -138,7 +261,7 @@ namespace wlplan {
       }
 
       std::vector<std::pair<std::string, int>> raw_functions =
-          j.at("domain").at("functions").get<std::vector<std::pair<std::string, int>>>();
+          j.at("functions").get<std::vector<std::pair<std::string, int>>>();
       std::vector<planning::Function> domain_functions = std::vector<planning::Function>();
       for (size_t i = 0; i < raw_functions.size(); i++) {
         domain_functions.push_back(
@@ -146,52 +269,47 @@ namespace wlplan {
       }
 
       std::vector<std::pair<std::string, int>> raw_schemata =
-          j.at("domain").at("schemata").get<std::vector<std::pair<std::string, int>>>();
+          j.at("schemata").get<std::vector<std::pair<std::string, int>>>();
       std::vector<planning::Schema> domain_schemata = std::vector<planning::Schema>();
       for (size_t i = 0; i < raw_schemata.size(); i++) {
         domain_schemata.push_back(planning::Schema(raw_schemata[i].first, raw_schemata[i].second));
       }
 
       std::vector<std::pair<std::string, std::string>> raw_constant_objects =
-        j.at("domain").at("constant_objects").get<std::vector<std::pair<std::string, std::string>>>();
-	    std::vector<planning::Object> constant_objects = std::vector<planning::Object>();
-	    for (size_t i = 0; i < raw_constant_objects.size(); i++) {
-	      constant_objects.push_back(
-	          planning::Object(raw_constant_objects[i].first, raw_constant_objects[i].second));
-	  }
-      domain = std::make_shared<planning::Domain>(
+          j.at("constant_objects").get<std::vector<std::pair<std::string, std::string>>>();
+      std::vector<planning::Object> constant_objects = std::vector<planning::Object>();
+      for (size_t i = 0; i < raw_constant_objects.size(); i++) {
+        constant_objects.push_back(
+            planning::Object(raw_constant_objects[i].first, raw_constant_objects[i].second));
+      }
+      return std::make_shared<planning::Domain>(
           domain_name, domain_predicates, domain_functions, domain_schemata, types, constant_objects);
+    }
 
-      // load weights if they exist
-      std::vector<double> weights_tmp = j.at("weights").get<std::vector<double>>();
-      if (weights_tmp.size() > 0) {
-        store_weights = true;
-        weights = weights_tmp;
-      } else {
-        store_weights = false;
-      }
+    void Features::load_json(const std::string &filename) {
+      std::ifstream i(filename);
+      json j;
+      i >> j;
 
-      // reconstruct layer to colours
-      layer_to_colours = get_layer_to_colours();
+      // load configurations
+      package_version = j["package_version"];
+      feature_name = j.at("feature_name").get<std::string>();
+      graph_representation = j.at("graph_representation").get<std::string>();
+      iterations = j.at("iterations").get<int>();
+      pruning = j.at("pruning").get<std::string>();
+      multiset_hash = j.at("multiset_hash").get<bool>();
+      extra_config = j.contains("extra_config") ? j.at("extra_config") : json::object();
 
-      // initialise other variables (assume collection already done)
-      collected = true;
-      collecting = false;
-      pruned = true;
-      save_unseen_colours = false;
+      // load colours
+      StrColourHash colour_hash_str = j.at("colour_hash").get<StrColourHash>();
+      set_colour_hash(str_to_int_colour_hash(colour_hash_str));
+      colour_to_layer = j.at("colour_to_layer").get<std::unordered_map<int, int>>();
 
-      initialise_variables();
+      // initialise domain object
+      domain = domain_from_json(j.at("domain"));
 
-      if (!quiet) {
-        std::cout << "package_version=" << package_version << std::endl;
-        std::cout << "feature_name=" << feature_name << std::endl;
-        std::cout << "graph_representation=" << graph_representation << std::endl;
-        std::cout << "iterations=" << iterations << std::endl;
-        std::cout << "pruning=" << pruning << std::endl;
-        std::cout << "multiset_hash=" << multiset_hash << std::endl;
-        std::cout << "domain=" << domain->to_string() << std::endl;
-        std::cout << "weights_size=" << weights_tmp.size() << std::endl;
-      }
+      // load weights if they exist
+      weights = j.at("weights").get<std::vector<double>>();
     }
 
     void Features::set_problem(const planning::Problem &problem) {
@@ -202,53 +320,108 @@ namespace wlplan {
 
     /* Feature generation functions */
 
-    int Features::get_colour_hash(const std::vector<int> &colour, const int iteration, int data_index) {
+    int Features::get_colour_hash(const ColourKey colour,
+                                  const int iteration,
+                                  int data_index,
+                                  int count) {
       if (colour.size() == 0) {
         return UNSEEN_COLOUR;
       }
-      if (!collecting && !colour_hash[iteration].count(colour)) {
+      if (!collecting) {
+        // only read the colour hash here as embedding may be run in parallel
+        const int ret = frozen ? frozen_colour_hash[iteration].find(colour)
+                               : colour_hash[iteration].find(colour);
+        if (ret != ColourHash::NOT_FOUND) {
+          return ret;
+        }
 #ifdef DEBUGMODE
         std::cout << "UNSEEN ";
         debug_vec(colour);
 #endif
         if (save_unseen_colours) {
           // during embedding, save unseen colours if required
-          if (!colour_hash_unseen[iteration].count(colour)) {
-            int hash = get_n_colours() + get_n_colours_unseen();
-            colour_hash_unseen[iteration][colour] = hash;
+          const auto [hash, inserted] = colour_hash_unseen[iteration].insert(
+              colour, get_n_colours() + get_n_colours_unseen());
+          if (inserted) {
             colour_to_layer_unseen[hash] = iteration;
             layer_to_colours_unseen[iteration].insert(hash);
             colour_to_count_unseen[hash] = 0;
           }
-          colour_to_count_unseen[colour_hash_unseen[iteration][colour]]++;
+          colour_to_count_unseen[hash] += count;
           // Source - https://stackoverflow.com/a/2519011
           // Posted by fbrereto
           // Retrieved 2025-11-26, License - CC BY-SA 2.5
           std::stringstream result;
           std::copy(colour.begin(), colour.end(), std::ostream_iterator<int>(result, "."));
-          unseen_colours_filename << iteration << ":" << colour_hash_unseen[iteration][colour] << ":" << result.str() << std::endl;
+          unseen_colours_filename << iteration << ":" << hash << ":" << result.str() << std::endl;
         }
         return UNSEEN_COLOUR;
-      } else if (collecting) {
-        if (!colour_hash[iteration].count(colour)) {
-          int hash = get_n_colours();
-          colour_hash[iteration][colour] = hash;
-          colour_to_layer[hash] = iteration;
-          layer_to_colours[iteration].insert(hash);
-          colour_statistics.push_back(std::map<int, int>({{data_index, 0}}));
-        }
-        colour_statistics[colour_hash[iteration][colour]][data_index]++;
       }
-      return colour_hash[iteration][colour];
+
+      const auto [hash, inserted] = colour_hash[iteration].insert(colour, n_colours);
+      if (inserted) {
+        n_colours++;
+        colour_to_layer[hash] = iteration;
+        layer_to_colours[iteration].insert(hash);
+        colour_statistics.resize(n_colours);
+      }
+      colour_statistics.add(hash, data_index, count);
+      return hash;
     }
 
-    int Features::get_colour_hash_fast(const std::vector<int> &colour, const int iteration) {
-      auto [it, inserted] = colour_hash[iteration].try_emplace(colour, get_n_colours());
-      int ret = it->second;
-      layer_to_colours[iteration].insert(ret);
+    int Features::get_colour_hash_fast(const ColourKey colour, const int iteration) {
+      const auto [ret, inserted] = colour_hash[iteration].insert(colour, n_colours);
+      if (inserted) {
+        n_colours++;
+        layer_to_colours[iteration].insert(ret);
+      }
       return ret;
     }
 
+    void Features::add_concurrent_colours(const ConcurrentColourHash &hash,
+                                          const int iteration,
+                                          ColouringStore &graph_colours) {
+      std::vector<int> provisional_to_colour(hash.get_n_provisional(), UNSEEN_COLOUR);
+      for (const auto &[colour, provisional] : hash.get_new_colours()) {
+        int new_hash = n_colours++;
+        colour_hash[iteration].insert(colour, new_hash);
+        colour_to_layer[new_hash] = iteration;
+        layer_to_colours[iteration].insert(new_hash);
+        provisional_to_colour[ConcurrentColourHash::from_provisional(provisional)] = new_hash;
+      }
+      colour_statistics.resize(n_colours);
+
+      // Replace provisional colours and count colours of each graph in parallel. Graphs are counted
+      // in chunks so that only the counts of one chunk are held in memory at a time.
+      const size_t n_graphs = graph_colours.size();
+      const size_t chunk_size = std::min<size_t>(n_graphs, 4096);
+      std::vector<Embedding> graph_counts(chunk_size);
+      std::vector<EmbeddingWorkspace> workspaces(n_threads);
+      for (size_t chunk_start = 0; chunk_start < n_graphs; chunk_start += chunk_size) {
+        const size_t n_chunk = std::min(chunk_size, n_graphs - chunk_start);
+        utils::parallel_for(n_chunk, n_threads, [&](int thread_id, size_t i) {
+          const size_t graph_i = chunk_start + i;
+          EmbeddingCounter &counter = workspaces[thread_id].x;
+          for (int *col = graph_colours.begin(graph_i); col != graph_colours.end(graph_i); col++) {
+            if (ConcurrentColourHash::is_provisional(*col)) {
+              *col = provisional_to_colour[ConcurrentColourHash::from_provisional(*col)];
+            }
+            if (*col != UNSEEN_COLOUR) {
+              counter.add(*col);
+            }
+          }
+          graph_counts[i] = counter.to_embedding();
+        });
+
+        // data indices are visited in increasing order as required by the statistics
+        for (size_t i = 0; i < n_chunk; i++) {
+          for (const auto &[col, count] : graph_counts[i]) {
+            colour_statistics.add(col, chunk_start + i, count);
+          }
+        }
+      }
+    }
+
     std::map<int, int> Features::remap_colour_hash(std::set<int> &to_prune) {
 
       //////////////////////////////////////////
@@ -273,7 +446,7 @@ namespace wlplan {
       std::vector<std::vector<std::pair<std::vector<int>, int>>> new_hash_vec(
           iterations + 1, std::vector<std::pair<std::vector<int>, int>>());
       std::unordered_map<int, int> new_colour_layer;
-	  std::vector<std::map<int, int>> new_colour_statistics = std::vector<std::map<int, int>>();
+      std::vector<int> kept_colours;
 
       int modifications = 1;
       int post_pruning_itr = 0;
@@ -289,7 +462,8 @@ namespace wlplan {
             }
 
             bool skip = false;
-            for (const int &neighbour : neighbour_container->get_neighbour_colours(key)) {
+            std::vector<int> neighbours(key.begin(), key.end());
+            for (const int &neighbour : neighbour_container->get_neighbour_colours(neighbours)) {
               if (to_prune.count(neighbour) > 0) {
                 skip = true;
                 break;
@@ -314,9 +488,10 @@ namespace wlplan {
           // otherwise remap
           int new_val = remap.size();
           remap[val] = new_val;
-          new_hash_vec[itr].push_back(std::make_pair(key, new_val));
+          new_hash_vec[itr].push_back(
+              std::make_pair(std::vector<int>(key.begin(), key.end()), new_val));
           new_colour_layer[new_val] = colour_to_layer[val];
-          new_colour_statistics.push_back(colour_statistics[val]);
+          kept_colours.push_back(val);
         }
       }
 
@@ -330,14 +505,13 @@ namespace wlplan {
       //////////////////////////////////////////
 
       // remap keys
-      VecColourHash new_hash(iterations + 1,
-                             std::unordered_map<std::vector<int>, int, int_vector_hasher>());
+      VecColourHash new_hash = new_colour_hash();
 
       // layer 0 keeps same keys because they are from graph init node colours
       for (size_t i = 0; i < new_hash_vec[0].size(); i++) {
         std::vector<int> key = new_hash_vec[0][i].first;
         int val = new_hash_vec[0][i].second;
-        new_hash[0][key] = val;
+        new_hash[0].insert_or_assign(key, val);
       }
 
       // other layers (>=1) remap keys
@@ -348,13 +522,14 @@ namespace wlplan {
           if (new_colour_layer[val] > 0) {
             key = neighbour_container->remap(key, remap);
           }
-          new_hash[itr][key] = val;
+          new_hash[itr].insert_or_assign(key, val);
         }
       }
 
       // remap hash
-      colour_hash = new_hash;
+      set_colour_hash(std::move(new_hash));
       colour_to_layer = new_colour_layer;
+      colour_statistics = colour_statistics.select(kept_colours);
       layer_to_colours = new_layer_to_colours();
       for (int itr = 0; itr < iterations + 1; itr++) {
         for (const auto &[key, val] : colour_hash[itr]) {
@@ -400,22 +575,31 @@ namespace wlplan {
       return remap;
     }
 
-    std::vector<graph_generator::Graph> Features::to_graphs(const data::DomainDataset dataset) {
+    std::vector<graph_generator::Graph> Features::to_graphs(const data::DomainDataset &dataset) {
       return graph_generator->to_graphs(dataset);
     }
 
-    void Features::collect_from_dataset(const data::DomainDataset dataset) {
+    void Features::collect_from_dataset(const data::DomainDataset &dataset) {
+      data::DomainDatasetSource source(dataset);
+      collect_from_source(source);
+    }
+
+    void Features::collect_from_source(data::ProblemSource &source) {
       if (graph_generator == nullptr) {
         throw std::runtime_error("No graph generator is set. Use graph input instead of dataset.");
       }
-      const std::vector<data::ProblemDataset> &data = dataset.data;
 
       if (pruning != PruningOptions::NONE && pruned) {
         throw std::runtime_error("Collect with pruning can only be called at most once");
       }
+      if (frozen) {
+        throw std::runtime_error("Cannot collect colours while frozen, call unfreeze() first");
+      }
       collecting = true;
+      // colours from earlier collections have no statistics
+      colour_statistics.reset(n_colours, spill_directory);
 
-	    collect_impl(data);
+      collect_impl(source);
 
       std::cout << "[complete]" << std::endl;
 
@@ -425,7 +609,7 @@ namespace wlplan {
 
       collected = true;
       collecting = false;
-      colour_statistics = std::vector<std::map<int, int>>(); // remove this to free memory
+      colour_statistics = ColourStatistics(); // remove this to free memory
 
       // check features have been collected
       if (get_n_colours() == 0) {
@@ -437,8 +621,12 @@ namespace wlplan {
       if (pruning != PruningOptions::NONE && pruned) {
         throw std::runtime_error("Collect with pruning can only be called at most once");
       }
+      if (frozen) {
+        throw std::runtime_error("Cannot collect colours while frozen, call unfreeze() first");
+      }
 
       collecting = true;
+      colour_statistics.reset(n_colours, spill_directory);
 
       collect_impl(graphs);
 
@@ -470,35 +658,146 @@ namespace wlplan {
     }
 
     // overloaded embedding functions
+    void Features::embed_dataset_rows(const data::DomainDataset &dataset,
+                                      const std::function<void(size_t, Embedding &&)> &write_row) {
+      int n_workers = get_n_embedding_threads();
+      std::vector<EmbeddingWorkspace> workspaces;
+      for (int i = 0; i < n_workers; i++) {
+        workspaces.push_back(new_workspace());
+      }
+
+      size_t offset = 0;
+      for (const auto &problem_states : dataset.data) {
+        graph_generator->set_problem(problem_states.problem);
+        const std::vector<planning::State> &states = problem_states.states;
+        // graph generators do not modify their problem specific variables in to_graph(state)
+        utils::parallel_for(states.size(), n_workers, [&](const int thread_id, const size_t i) {
+          EmbeddingWorkspace &thread_workspace = workspaces[thread_id];
+          write_row(offset + i,
+                    embed_impl(graph_generator->to_graph(states[i], thread_workspace.graph_overlay),
+                               thread_workspace));
+        });
+        offset += states.size();
+      }
+
+      for (auto &thread_workspace : workspaces) {
+        merge_workspace(thread_workspace);
+      }
+    }
+
+    void Features::embed_graph_rows(const std::vector<graph_generator::Graph> &graphs,
+                                    const std::function<void(size_t, Embedding &&)> &write_row) {
+      int n_workers = get_n_embedding_threads();
+      std::vector<EmbeddingWorkspace> workspaces;
+      for (int i = 0; i < n_workers; i++) {
+        workspaces.push_back(new_workspace());
+      }
+
+      utils::parallel_for(graphs.size(), n_workers, [&](const int thread_id, const size_t i) {
+        const auto graph = std::make_shared<graph_generator::Graph>(graphs[i]);
+        write_row(i, embed_impl(graph, workspaces[thread_id]));
+      });
+
+      for (auto &thread_workspace : workspaces) {
+        merge_workspace(thread_workspace);
+      }
+    }
+
+    void Features::embed_state_rows(const std::vector<planning::State> &states,
+                                    const std::function<void(size_t, Embedding &&)> &write_row) {
+      int n_workers = get_n_embedding_threads();
+      std::vector<EmbeddingWorkspace> workspaces;
+      for (int i = 0; i < n_workers; i++) {
+        workspaces.push_back(new_workspace());
+      }
+
+      utils::parallel_for(states.size(), n_workers, [&](const int thread_id, const size_t i) {
+        EmbeddingWorkspace &thread_workspace = workspaces[thread_id];
+        write_row(i,
+                  embed_impl(graph_generator->to_graph(states[i], thread_workspace.graph_overlay),
+                             thread_workspace));
+      });
+
+      for (auto &thread_workspace : workspaces) {
+        merge_workspace(thread_workspace);
+      }
+    }
+
+    void Features::write_dense_row(Embedding &&x, double *row, const size_t n_cols) const {
+      std::fill(row, row + n_cols, 0.0);
+      for (const auto &[colour, count] : x) {
+        if (colour < 0 || (size_t)colour >= n_cols) {
+          throw std::runtime_error("Feature " + std::to_string(colour) +
+                                   " is out of bounds for a matrix with " +
+                                   std::to_string(n_cols) + " columns");
+        }
+        row[colour] = count;
+      }
+    }
+
     std::vector<Embedding> Features::embed_dataset(const data::DomainDataset &dataset) {
-      std::vector<Embedding> X;
-      X.reserve(dataset.get_size());
-	    for (const auto & problem_states : dataset.data) {
-	      graph_generator->set_problem(problem_states.problem);
-	      for (const planning::State &state : problem_states.states) {
-	        Embedding x = embed_graph(*(graph_generator->to_graph(state)));
-	        X.push_back(x);
-	      }
-	   }
+      std::vector<Embedding> X(dataset.get_size());
+      embed_dataset_rows(dataset, [&](const size_t i, Embedding &&x) { X[i] = std::move(x); });
       return X;
     }
 
     std::vector<Embedding>
     Features::embed_graphs(const std::vector<graph_generator::Graph> &graphs) {
-      std::vector<Embedding> X;
-      X.reserve(graphs.size());
-      for (const auto &graph : graphs) {
-        X.push_back(embed_graph(graph));
-      }
+      std::vector<Embedding> X(graphs.size());
+      embed_graph_rows(graphs, [&](const size_t i, Embedding &&x) { X[i] = std::move(x); });
       return X;
     }
 
+    CSRMatrix Features::embed_dataset_csr(const data::DomainDataset &dataset) {
+      CSRWriter writer(dataset.get_size(), get_n_features());
+      embed_dataset_rows(
+          dataset, [&](const size_t i, Embedding &&x) { writer.write_row(i, std::move(x)); });
+      return writer.finish();
+    }
+
+    CSRMatrix Features::embed_graphs_csr(const std::vector<graph_generator::Graph> &graphs) {
+      CSRWriter writer(graphs.size(), get_n_features());
+      embed_graph_rows(graphs,
+                       [&](const size_t i, Embedding &&x) { writer.write_row(i, std::move(x)); });
+      return writer.finish();
+    }
+
+    void Features::embed_dataset_dense(const data::DomainDataset &dataset,
+                                       double *X,
+                                       const size_t n_rows,
+                                       const size_t n_cols) {
+      if (n_rows != dataset.get_size()) {
+        throw std::runtime_error("Expected a matrix with " + std::to_string(dataset.get_size()) +
+                                 " rows but got " + std::to_string(n_rows));
+      }
+      embed_dataset_rows(dataset, [&](const size_t i, Embedding &&x) {
+        write_dense_row(std::move(x), X + i * n_cols, n_cols);
+      });
+    }
+
+    void Features::embed_graphs_dense(const std::vector<graph_generator::Graph> &graphs,
+                                      double *X,
+                                      const size_t n_rows,
+                                      const size_t n_cols) {
+      if (n_rows != graphs.size()) {
+        throw std::runtime_error("Expected a matrix with " + std::to_string(graphs.size()) +
+                                 " rows but got " + std::to_string(n_rows));
+      }
+      embed_graph_rows(graphs, [&](const size_t i, Embedding &&x) {
+        write_dense_row(std::move(x), X + i * n_cols, n_cols);
+      });
+    }
+
     Embedding Features::embed_graph(const graph_generator::Graph &graph) {
-      return embed_impl(std::make_shared<graph_generator::Graph>(graph));
+      return embed_single(std::make_shared<graph_generator::Graph>(graph));
     }
 
     Embedding Features::embed_state(const planning::State &state) {
-      return embed_impl(graph_generator->to_graph(state));
+      return embed_single(graph_generator->to_graph(state));
+    }
+
+    Embedding Features::embed_state(const planning::InternedState &state) {
+      return embed_single(graph_generator->to_graph(state));
     }
 
     Embedding Features::embed(const std::shared_ptr<graph_generator::Graph> &graph) {
@@ -507,56 +806,105 @@ namespace wlplan {
         throw std::runtime_error("collect() must be called before embedding");
       }
 
-      return embed_impl(graph);
+      return embed_single(graph);
+    }
+
+    Embedding Features::embed_single(const std::shared_ptr<graph_generator::Graph> &graph) {
+      workspace.n_threads = get_n_embedding_threads();
+      Embedding x = embed_impl(graph, workspace);
+      merge_workspace(workspace);
+      return x;
     }
 
-    void Features::add_colour_to_x(int col, int itr, Embedding &x) {
+    void Features::add_colour_to_x(int col, int itr, EmbeddingWorkspace &workspace) {
       bool is_seen_colour = (col != UNSEEN_COLOUR);  // prevent branch prediction
-      seen_colour_statistics[is_seen_colour][itr]++;
+      workspace.seen_colour_statistics[is_seen_colour][itr]++;
       if (is_seen_colour) {
-        x[col]++;
+        workspace.x.add(col);
+      }
+    }
+
+    void Features::add_colour_to_x(int col, int itr, EmbeddingWorkspace &workspace, int count) {
+      bool is_seen_colour = (col != UNSEEN_COLOUR);
+      workspace.seen_colour_statistics[is_seen_colour][itr] += count;
+      if (is_seen_colour) {
+        workspace.x.add(col, count);
       }
     }
 
     /* Pruning functions (see pruning/ source files for specific implementations) */
 
-  std::map<int, int> Features::get_equivalence_groups() {
-    std::map<int, int> feature_group;
-    int n_features = get_n_colours();
-    std::vector<std::map<int, int>> group_keys;
-    for (int colour = 0; colour < n_features; colour++) {
-      std::map<int, int> &colour_map = colour_statistics[colour];
-      bool checked = false;
-      for (int i = 0; i < (int) group_keys.size(); i++) {
-        // check if this colour is equivalent to the group key
-        if (colour_map.size() == group_keys[i].size()
-              && std::equal(colour_map.begin(), colour_map.end(),
-                            group_keys[i].begin())) {
-          feature_group[colour] = i;
-          checked = true;
-          break;
+    std::map<int, int> Features::get_equivalence_groups() {
+      int n_features = get_n_colours();
+
+      // colours can only be equivalent if their signatures are, so sort colours by signature and
+      // only compare colours within each run of equal signatures
+      std::vector<int> order(n_features);
+      for (int colour = 0; colour < n_features; colour++) {
+        order[colour] = colour;
+      }
+      std::sort(order.begin(), order.end(), [&](const int a, const int b) {
+        const uint64_t sig_a = colour_statistics.get_signature(a);
+        const uint64_t sig_b = colour_statistics.get_signature(b);
+        return sig_a != sig_b ? sig_a < sig_b : a < b;
+      });
+      std::vector<std::pair<int, int>> buckets;
+      for (int begin = 0, end = 0; begin < n_features; begin = end) {
+        const uint64_t signature = colour_statistics.get_signature(order[begin]);
+        while (end < n_features && colour_statistics.get_signature(order[end]) == signature) {
+          end++;
         }
+        buckets.emplace_back(begin, end);
       }
-      if (checked) {
-        continue; // already assigned to a group
+
+      // smallest equivalent colour of each colour, with buckets checked in parallel
+      std::vector<int> representative(n_features);
+      utils::parallel_for(buckets.size(), n_threads, [&](int, size_t bucket_i) {
+        const auto [begin, end] = buckets[bucket_i];
+        std::vector<int> bucket_representatives;
+        for (int i = begin; i < end; i++) {
+          const int colour = order[i];
+          representative[colour] = colour;
+          for (const int other : bucket_representatives) {
+            if (colour_statistics.equal(colour, other)) {
+              representative[colour] = other;
+              break;
+            }
+          }
+          if (representative[colour] == colour) {
+            bucket_representatives.push_back(colour);
+          }
+        }
+      });
+
+      // groups are numbered in order of their smallest colour
+      std::map<int, int> feature_group;
+      int n_groups = 0;
+      for (int colour = 0; colour < n_features; colour++) {
+        const int rep = representative[colour];
+        feature_group[colour] = rep == colour ? n_groups++ : feature_group[rep];
       }
-      group_keys.push_back(colour_map);
-      feature_group[colour] = (int) group_keys.size() - 1; // assign new group
-    }
 
-    return feature_group;
-  }
+      return feature_group;
+    }
 
     /* Prediction functions */
 
+    double Features::predict_embedding(const Embedding &embedding) const {
+      // sorted by colour, so the sum is the same as a dense dot product
+      double h = 0;
+      for (const auto &[colour, count] : embedding) {
+        h += count * weights[colour];
+      }
+      return h;
+    }
+
     double Features::predict(const std::shared_ptr<graph_generator::Graph> &graph) {
       if (!store_weights) {
         throw std::runtime_error("Weights have not been set for prediction.");
       }
 
-      EmbeddingVec x = convert_embedding_to_vector(embed_impl(graph));
-      double h = std::inner_product(x.begin(), x.end(), weights.begin(), 0.0);
-      return h;
+      return predict_embedding(embed_single(graph));
     }
 
     double Features::predict(const graph_generator::Graph &graph) {
@@ -570,6 +918,31 @@ namespace wlplan {
       return h;
     }
 
+    double Features::predict(const planning::InternedState &state) {
+      return predict(graph_generator->to_graph(state));
+    }
+
+    std::vector<double> Features::predict_batch(const std::vector<planning::State> &states) {
+      if (!store_weights) {
+        throw std::runtime_error("Weights have not been set for prediction.");
+      }
+
+      std::vector<double> h(states.size());
+      embed_state_rows(states, [&](const size_t i, Embedding &&x) { h[i] = predict_embedding(x); });
+      return h;
+    }
+
+    std::vector<double>
+    Features::predict_batch(const std::vector<graph_generator::Graph> &graphs) {
+      if (!store_weights) {
+        throw std::runtime_error("Weights have not been set for prediction.");
+      }
+
+      std::vector<double> h(graphs.size());
+      embed_graph_rows(graphs, [&](const size_t i, Embedding &&x) { h[i] = predict_embedding(x); });
+      return h;
+    }
+
     /* Util functions */
     void Features::log_iteration(int iteration) const {
       if (!quiet)
@@ -595,8 +968,7 @@ namespace wlplan {
 
     std::string Features::get_string_representation(const Embedding &embedding) {
       std::string str_embed = "";
-      for (size_t i = 0; i < embedding.size(); i++) {
-        int count = embedding.at(i);
+      for (const auto &[i, count] : embedding) {
         if (count == 0) {
           continue;
         }
@@ -621,7 +993,7 @@ namespace wlplan {
           while (std::getline(iss, token, '.')) {
             colour.push_back(std::stoi(token));
           }
-          int_colour_hash[itr][colour] = pair.second;
+          int_colour_hash[itr].insert_or_assign(colour, pair.second);
         }
       }
       return int_colour_hash;
@@ -693,14 +1065,6 @@ namespace wlplan {
     void Features::print_init_colours() const { graph_generator->print_init_colours(); }
     std::map<int, std::string> Features::get_colour_to_description() const { return graph_generator->get_colour_to_description(); }
 
-    int Features::get_n_colours() const {
-      int ret = 0;
-      for (int i = 0; i < iterations + 1; i++) {
-        ret += colour_hash[i].size();
-      }
-      return ret;
-    }
-
     int Features::get_n_colours_unseen() const {
       int ret = 0;
       for (int i = 0; i < iterations + 1; i++) {
@@ -723,7 +1087,26 @@ namespace wlplan {
       return true;
     }
 
-    void Features::save(const std::string &filename) {
+    void Features::create_parent_directory(const std::string &filename) {
+      if (filename.find_last_of("/") != std::string::npos) {
+        std::error_code err;
+        std::string directory_name = filename.substr(0, filename.find_last_of("/"));
+        if (!create_directory_recursive(directory_name, err)) {
+          std::cout << "Error: failed to recursively create directory. " << err.message()
+                    << std::endl;
+        }
+      }
+    }
+
+    json Features::get_extra_config() const {
+      json config = json::object();
+      save_config(config);
+      return config;
+    }
+
+    void Features::save(const std::string &filename) { save_json(filename); }
+
+    void Features::save_json(const std::string &filename) {
       // let Python handle file exceptions
       json j;
       j["package_version"] = package_version;
@@ -732,23 +1115,17 @@ namespace wlplan {
       j["iterations"] = iterations;
       j["pruning"] = pruning;
       j["multiset_hash"] = multiset_hash;
+      j["extra_config"] = get_extra_config();
 
       j["domain"] = domain->to_json();
 
-      j["colour_hash"] = int_to_str_colour_hash(colour_hash);
+      j["colour_hash"] = int_to_str_colour_hash(get_colour_hash_layers());
       j["colour_to_layer"] = colour_to_layer;
 
       j["weights"] = weights;
 
       // Create directory if it doesn't exist
-      if (filename.find_last_of("/") != std::string::npos) {
-        std::error_code err;
-        std::string directory_name = filename.substr(0, filename.find_last_of("/"));
-        if (!create_directory_recursive(directory_name, err)) {
-          std::cout << "Error: failed to recursively create directory. " << err.message()
-                    << std::endl;
-        }
-      }
+      create_parent_directory(filename);
 
       // Save to file
       std::ofstream o(filename);
@@ -769,10 +1146,11 @@ namespace wlplan {
       j["iterations"] = iterations;
       j["pruning"] = pruning;
       j["multiset_hash"] = multiset_hash;
+      j["extra_config"] = get_extra_config();
 
       j["domain"] = domain->to_json();
 
-      j["colour_hash"] = int_to_str_colour_hash(colour_hash);
+      j["colour_hash"] = int_to_str_colour_hash(get_colour_hash_layers());
       j["colour_to_layer"] = colour_to_layer;
 
       j["weights"] = weights;
@@ -783,14 +1161,7 @@ namespace wlplan {
       j["colour_to_count_unseen"] = colour_to_count_unseen;
 
       // Create directory if it doesn't exist
-      if (filename.find_last_of("/") != std::string::npos) {
-        std::error_code err;
-        std::string directory_name = filename.substr(0, filename.find_last_of("/"));
-        if (!create_directory_recursive(directory_name, err)) {
-          std::cout << "Error: failed to recursively create directory. " << err.message()
-                    << std::endl;
-        }
-      }
+      create_parent_directory(filename);
 
       // Save to file
       std::ofstream o(filename);
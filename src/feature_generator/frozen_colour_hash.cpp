@@ -0,0 +1,80 @@
+#include "../../include/feature_generator/frozen_colour_hash.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace wlplan {
+  namespace feature_generator {
+    FrozenColourHash::FrozenColourHash(const ColourHash &colour_hash) {
+      const size_t n_entries = colour_hash.size();
+
+      std::vector<std::pair<ColourKey, int>> entries;
+      std::vector<uint64_t> entry_fingerprints;
+      entries.reserve(n_entries);
+      entry_fingerprints.reserve(n_entries);
+      for (const auto &entry : colour_hash) {
+        entries.push_back(entry);
+        entry_fingerprints.push_back(colour_fingerprint(entry.first));
+      }
+
+      std::vector<size_t> order(n_entries);
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+        return entry_fingerprints[a] < entry_fingerprints[b];
+      });
+
+      fingerprints.reserve(n_entries);
+      values.reserve(n_entries);
+      key_offsets.reserve(n_entries + 1);
+      key_offsets.push_back(0);
+      for (const size_t i : order) {
+        const auto &[key, value] = entries[i];
+        fingerprints.push_back(entry_fingerprints[i]);
+        values.push_back(value);
+        arena.insert(arena.end(), key.begin(), key.end());
+        key_offsets.push_back(arena.size());
+      }
+
+      // about one entry per bucket
+      int log_n_buckets = 1;
+      while (((size_t)1 << log_n_buckets) < n_entries) {
+        log_n_buckets++;
+      }
+      shift = 64 - log_n_buckets;
+      directory.assign(((size_t)1 << log_n_buckets) + 1, 0);
+      for (const uint64_t fingerprint : fingerprints) {
+        directory[(fingerprint >> shift) + 1]++;
+      }
+      std::partial_sum(directory.begin(), directory.end(), directory.begin());
+
+      size_t n_filter_bits = 64;
+      while (n_filter_bits < 8 * n_entries) {
+        n_filter_bits *= 2;
+      }
+      filter.assign(n_filter_bits / 64, 0);
+      filter_mask = n_filter_bits - 1;
+      for (const uint64_t fingerprint : fingerprints) {
+        const uint64_t i = fingerprint & filter_mask;
+        const uint64_t j = (fingerprint >> 24) & filter_mask;
+        filter[i >> 6] |= (uint64_t)1 << (i & 63);
+        filter[j >> 6] |= (uint64_t)1 << (j & 63);
+      }
+    }
+
+    ColourHash FrozenColourHash::to_colour_hash() const {
+      std::vector<size_t> order(size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+        return values[a] < values[b];
+      });
+
+      ColourHash ret;
+      ret.reserve(size());
+      for (const size_t i : order) {
+        ColourKey key(arena.data() + key_offsets[i], key_offsets[i + 1] - key_offsets[i]);
+        ret.insert(key, values[i], fingerprints[i]);
+      }
+      return ret;
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -0,0 +1,185 @@
+#include "../../include/feature_generator/lwl2_pair_neighbours.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace wlplan {
+  namespace feature_generator {
+    void LWL2PairNeighbours::encode(const graph_generator::Graph &graph,
+                                    const long max_entries,
+                                    std::vector<int> &data) {
+      const int n_nodes = graph.nodes.size();
+      const size_t start = data.size();
+      data.push_back(n_nodes);
+      data.push_back(ON_THE_FLY);
+
+      // sorted neighbours of each node without duplicates from edges with different labels
+      const size_t node_offsets = data.size();
+      data.resize(node_offsets + n_nodes + 1, 0);
+      for (int u = 0; u < n_nodes; u++) {
+        const size_t begin = data.size();
+        data.insert(data.end(),
+                    graph.neighbours.begin() + graph.offsets[u],
+                    graph.neighbours.begin() + graph.offsets[u + 1]);
+        std::sort(data.begin() + begin, data.end());
+        data.erase(std::unique(data.begin() + begin, data.end()), data.end());
+        data[node_offsets + u + 1] = data.size() - node_offsets - n_nodes - 1;
+      }
+
+      // offsets are ints, so stored entries are limited by their range
+      const long limit = std::min(max_entries, (long)std::numeric_limits<int>::max());
+      const int n_pairs = get_n_lwl2_pairs(n_nodes);
+      std::vector<int> pair_offsets(n_pairs + 1, 0);
+      std::vector<int> pair_entries;
+      const LWL2PairNeighbours view(data.data() + start);
+      for (int u = 0; u < n_nodes; u++) {
+        for (int v = u + 1; v < n_nodes; v++) {
+          const int index = lwl2_pair_to_index_map(n_nodes, u, v);
+          view.for_each(u, v, index, [&](const int pair_uw, const int pair_vw) {
+            pair_entries.push_back(pair_uw);
+            pair_entries.push_back(pair_vw);
+            return true;
+          });
+          if ((long)pair_entries.size() > limit) {
+            return;
+          }
+          pair_offsets[index + 1] = pair_entries.size();
+        }
+      }
+      data[start + 1] = pair_entries.size();
+      data.insert(data.end(), pair_offsets.begin(), pair_offsets.end());
+      data.insert(data.end(), pair_entries.begin(), pair_entries.end());
+    }
+
+    LWL2PairNeighbours::LWL2PairNeighbours(const int *data)
+        : n_nodes(data[0]),
+          node_offsets(data + 2),
+          node_neighbours(data + 2 + data[0] + 1),
+          pair_offsets(nullptr),
+          pair_entries(nullptr) {
+      if (data[1] != ON_THE_FLY) {
+        pair_offsets = node_neighbours + node_offsets[n_nodes];
+        pair_entries = pair_offsets + get_n_lwl2_pairs(n_nodes) + 1;
+      }
+    }
+
+    void SparseLWL2PairNeighbours::encode(const graph_generator::Graph &graph,
+                                          const int radius,
+                                          std::vector<int> &data) {
+      const int n_nodes = graph.nodes.size();
+
+      // breadth first search from each node u for nodes w within radius, where the pair
+      // {min(u, w), max(u, w)} is stored in the list of its smaller node
+      std::vector<std::vector<int>> larger_nodes(n_nodes);
+      std::vector<int> depth(n_nodes, -1);
+      std::vector<int> queue;
+      for (int u = 0; u < n_nodes; u++) {
+        queue = {u};
+        depth[u] = 0;
+        for (size_t i = 0; i < queue.size(); i++) {
+          const int w = queue[i];
+          if (w != u) {
+            larger_nodes[std::min(u, w)].push_back(std::max(u, w));
+          }
+          if (depth[w] == radius) {
+            continue;
+          }
+          for (int j = graph.offsets[w]; j < graph.offsets[w + 1]; j++) {
+            const int x = graph.neighbours[j];
+            if (depth[x] == -1) {
+              depth[x] = depth[w] + 1;
+              queue.push_back(x);
+            }
+          }
+        }
+        for (const int w : queue) {
+          depth[w] = -1;
+        }
+      }
+
+      // pairs are numbered in order of their smaller and then larger node
+      std::vector<int> node_offsets(n_nodes + 1, 0);
+      for (int u = 0; u < n_nodes; u++) {
+        std::sort(larger_nodes[u].begin(), larger_nodes[u].end());
+        larger_nodes[u].erase(std::unique(larger_nodes[u].begin(), larger_nodes[u].end()),
+                              larger_nodes[u].end());
+        node_offsets[u + 1] = node_offsets[u] + larger_nodes[u].size();
+      }
+      const auto find_pair = [&](const int a, const int b) {
+        const int u = std::min(a, b);
+        const int v = std::max(a, b);
+        const auto it = std::lower_bound(larger_nodes[u].begin(), larger_nodes[u].end(), v);
+        if (it == larger_nodes[u].end() || *it != v) {
+          return FAR_PAIR;
+        }
+        return node_offsets[u] + (int)(it - larger_nodes[u].begin());
+      };
+
+      const int n_pairs = node_offsets[n_nodes];
+      data.push_back(n_nodes);
+      data.push_back(n_pairs);
+      const size_t pairs_start = data.size();
+      for (int u = 0; u < n_nodes; u++) {
+        for (const int v : larger_nodes[u]) {
+          data.insert(data.end(), {u, v, NO_EDGE_COLOUR});
+        }
+      }
+
+      // edge labels of the pairs as in 2-LWL, where adjacent nodes are always within radius
+      for (int u = 0; u < n_nodes; u++) {
+        for (int j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
+          const int v = graph.neighbours[j];
+          if (u < v) {
+            data[pairs_start + 3 * find_pair(u, v) + 2] = graph.edge_labels[j];
+          }
+        }
+      }
+
+      // neighbours w of each pair {u, v} are the neighbours of u or v other than u and v
+      std::vector<std::vector<int>> node_neighbours(n_nodes);
+      for (int u = 0; u < n_nodes; u++) {
+        node_neighbours[u].assign(graph.neighbours.begin() + graph.offsets[u],
+                                  graph.neighbours.begin() + graph.offsets[u + 1]);
+        std::sort(node_neighbours[u].begin(), node_neighbours[u].end());
+        node_neighbours[u].erase(
+            std::unique(node_neighbours[u].begin(), node_neighbours[u].end()),
+            node_neighbours[u].end());
+      }
+      std::vector<int> pair_offsets(n_pairs + 1, 0);
+      std::vector<int> pair_entries;
+      std::vector<int> neighbours;
+      for (int pair = 0; pair < n_pairs; pair++) {
+        const int u = data[pairs_start + 3 * pair];
+        const int v = data[pairs_start + 3 * pair + 1];
+        neighbours.clear();
+        std::set_union(node_neighbours[u].begin(),
+                       node_neighbours[u].end(),
+                       node_neighbours[v].begin(),
+                       node_neighbours[v].end(),
+                       std::back_inserter(neighbours));
+        for (const int w : neighbours) {
+          if (w != u && w != v) {
+            pair_entries.push_back(find_pair(u, w));
+            pair_entries.push_back(find_pair(v, w));
+          }
+        }
+        if (pair_entries.size() > (size_t)std::numeric_limits<int>::max()) {
+          throw std::runtime_error("Sparse 2-LWL pairs of a graph with " +
+                                   std::to_string(n_nodes) + " nodes have too many neighbours.");
+        }
+        pair_offsets[pair + 1] = pair_entries.size();
+      }
+      data.insert(data.end(), pair_offsets.begin(), pair_offsets.end());
+      data.insert(data.end(), pair_entries.begin(), pair_entries.end());
+    }
+
+    SparseLWL2PairNeighbours::SparseLWL2PairNeighbours(const int *data)
+        : n_pairs(data[1]),
+          pairs(data + 2),
+          pair_offsets(data + 2 + 3 * data[1]),
+          pair_entries(data + 2 + 3 * data[1] + data[1] + 1) {}
+  }  // namespace feature_generator
+}  // namespace wlplan
@@ -1,250 +1,721 @@
 #include "../../include/feature_generator/maxsat.hpp"
 
-#include "../../include/utils/exceptions.hpp"
+#include "../../include/feature_generator/sat_solver.hpp"
+#include "../../include/utils/parallel.hpp"
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <iostream>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <map>
+#include <numeric>
 #include <sstream>
-#include <random>
-#ifndef NOPYTHON
-#include <pybind11/embed.h>
-#include <pybind11/functional.h>
-#include <pybind11/pybind11.h>
-#include <pybind11/stl.h>
-#include <pybind11/typing.h>
-namespace py = pybind11;
-#endif
-
-using std::chrono::duration;
-using std::chrono::duration_cast;
-using std::chrono::high_resolution_clock;
-using std::chrono::milliseconds;
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace wlplan {
   namespace feature_generator {
-    MaxSatClause::MaxSatClause(const std::vector<int> &variables,
-                               const std::vector<bool> &negated,
-                               const int weight,
-                               const bool hard)
-        : variables(variables), negated(negated), weight(weight), hard(hard) {
-      if (hard && weight != 0) {
-        throw std::runtime_error("Hard MaxSAT clauses should have 0 weight!");
-      } else if (!hard && weight < 1) {
-        throw std::runtime_error("Soft MaxSAT clauses should have weight >= 1!");
-      }
-      if (variables.size() != negated.size()) {
-        throw std::runtime_error(
-            "Variables and negated in MaxSatClause should have the same size!");
-      }
-      for (size_t i = 0; i < variables.size(); i++) {
-        if (variables[i] < 1) {
-          throw std::runtime_error("Variables in MaxSatClause should be strictly positive!");
+    MaxSatProblem::MaxSatProblem() : n_variables(0), offsets({0}) {}
+
+    void MaxSatProblem::add_clause(std::span<const int> clause, const long weight) {
+      for (const int lit : clause) {
+        if (lit == 0) {
+          throw std::runtime_error("MaxSAT literals should be nonzero!");
         }
+        n_variables = std::max(n_variables, std::abs(lit));
       }
+      literals.insert(literals.end(), clause.begin(), clause.end());
+      offsets.push_back(literals.size());
+      weights.push_back(weight);
     }
 
-  std::string MaxSatClause::to_string(std::string hard_header) const {
-    std::string ret = "";
-    if (hard) {
-      ret += hard_header + " ";
-    } else {
-      ret += std::to_string(weight) + " ";
+    void MaxSatProblem::add_hard(std::span<const int> clause) { add_clause(clause, 0); }
+
+    void MaxSatProblem::add_soft(std::span<const int> clause, const long weight) {
+      if (weight < 1) {
+        throw std::runtime_error("Soft MaxSAT clauses should have weight >= 1!");
+      }
+      add_clause(clause, weight);
     }
-    for (int i = 0; i < size(); i++) {
-      if (negated[i]) {
-        ret += "-";
+
+    long MaxSatProblem::get_cost(const std::vector<bool> &values) const {
+      long cost = 0;
+      for (int i = 0; i < get_n_clauses(); i++) {
+        bool satisfied = false;
+        for (const int lit : get_clause(i)) {
+          if (values[std::abs(lit)] == (lit > 0)) {
+            satisfied = true;
+            break;
+          }
+        }
+        if (!satisfied) {
+          if (is_hard(i)) {
+            return -1;
+          }
+          cost += weights[i];
+        }
       }
-      ret += std::to_string(variables[i]) + " ";
+      return cost;
     }
-    ret += "0";
-    return ret;
-  }
 
-  MaxSatProblem::MaxSatProblem(const std::vector<MaxSatClause> &clauses) : clauses(clauses) {
-    for (const MaxSatClause &clause : clauses) {
-      for (int variable : clause.variables) {
-        variables.insert(variable);
+    std::string MaxSatProblem::to_string() const {
+      // https://maxsat-evaluations.github.io/2021/rules.html#input
+      long top = 1;
+      for (const long weight : weights) {
+        top += weight;
       }
+      std::ostringstream ret;
+      ret << "p wcnf " << n_variables << " " << get_n_clauses() << " " << top << "\n";
+      for (int i = 0; i < get_n_clauses(); i++) {
+        ret << (is_hard(i) ? top : weights[i]);
+        for (const int lit : get_clause(i)) {
+          ret << " " << lit;
+        }
+        ret << " 0\n";
+      }
+      return ret.str();
     }
-  }
 
-  std::string MaxSatProblem::to_string() {
-    // older wcnf version
-    // https://maxsat-evaluations.github.io/2021/rules.html#input
+    namespace {
+      // Totalizer encoding whose k-th output is implied by at least k inputs being true. Outputs
+      // are only created up to the largest k asked for, and more are added on demand.
+      class Totalizer {
+       public:
+        Totalizer(const std::vector<int> &inputs) : n_inputs(inputs.size()) {
+          root = build(inputs, 0, inputs.size());
+        }
 
-    uint64_t sum_variable = 0;
-    uint64_t max_variable = 0;
-    for (const MaxSatClause &clause : clauses) {
-      sum_variable = clause.weight + sum_variable;
-      max_variable = std::max(max_variable, (uint64_t) clause.weight);
-    }
-    sum_variable += 1;  // add one for the top variable
-    if (sum_variable < max_variable) {
-      throw std::runtime_error("Sum of weights is less than max weight!");
-    }
-    std::string top_value = std::to_string(sum_variable);
-
-    std::string ret = "p wcnf ";
-    ret += std::to_string(sum_variable) + " ";
-    ret += std::to_string(clauses.size()) + " ";
-    ret += top_value + "\n";
-    std::cout << "  Variables: " << get_n_variables() << std::endl;
-    std::cout << "  Clauses: " << clauses.size() << std::endl;
-    std::cout << "  Max variable weights (Top): " << sum_variable << std::endl;
-    for (const MaxSatClause &clause : clauses) {
-      ret += clause.to_string(top_value) + "\n";
-    }
-    return ret;
-
-    // // 2022 wcnf version
-    // // https://maxsat-evaluations.github.io/2022/rules.html#input
-    // std::string ret = "";
-    // for (const MaxSatClause &clause : clauses) {
-    //   ret += clause.to_string("h") + "\n";
-    // }
-    // return ret;
-  }
-
-  std::map<int, int> MaxSatProblem::call_solver() {
-//#ifndef NOPYTHON
-//
-//    std::string maxsat_wcnf_string = to_string();
-//
-//#ifdef DEBUGMODE
-//    std::cout << maxsat_wcnf_string << std::endl;
-//#endif
-//
-//    py::object pysat_rc2 = py::module::import("pysat.examples.rc2").attr("RC2");
-//    py::object pysat_wcnf = py::module::import("pysat.formula").attr("WCNF");
-//    py::dict kwargs;
-//    kwargs["from_string"] = maxsat_wcnf_string;
-//    py::object wncf = pysat_wcnf(**kwargs);
-//    py::object rc2 = pysat_rc2(wncf, py::arg("solver") = "g4");
-//
-//    std::cout << "Solving MaxSAT with RC2." << std::endl;
-//    auto t1 = high_resolution_clock::now();
-//    py::list pylist_solution = rc2.attr("compute")();
-//    auto t2 = high_resolution_clock::now();
-//    duration<double, std::milli> ms_double = t2 - t1;
-//    py::int_ cost = rc2.attr("cost");
-//    std::cout << "MaxSAT solved!" << std::endl;
-//    std::cout << "  Solving time: " << ms_double.count() / 1000 << "s\n";
-//    std::cout << "  Solution cost: " << cost << std::endl;
-//
-//    std::vector<int> solution_vector = py::cast<std::vector<int>>(pylist_solution);
-//    std::map<int, int> solution;
-//    for (const int value : solution_vector) {
-//      int variable = std::abs(value);
-//      if (variables.count(variable) == 0) {
-//        continue;
-//      }
-//      solution[variable] = (value > 0);
-//    }
-//    return solution;
-//#else
-//    throw std::runtime_error("MaxSAT feature pruning is not supported in the C++ interface.");
-//#endif
-// Generate the WCNF string
-    std::string maxsat_wcnf_string = to_string();
-
-    // Write the WCNF string to a temporary file
-    // Generate a random number
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(100000, 999999);
-
-    // Combine the temporary directory path with a random number
-    const std::string temp_wcnf_file = "./temp_" + std::to_string(dis(gen)) + ".wcnf";
-    const std::string temp_output_file = "./temp_output_" + std::to_string(dis(gen)) + ".txt";
-
-    {
-      std::ofstream wcnf_file(temp_wcnf_file);
-      if (!wcnf_file) {
-        throw std::runtime_error("Failed to create temp.wcnf file!");
-      }
-      wcnf_file << maxsat_wcnf_string;
-    }
+        int get_n_inputs() const { return n_inputs; }
+
+        int get_output(SatSolver &solver, const int k) {
+          extend(solver, root, k);
+          return nodes[root].outputs[k - 1];
+        }
 
-    // Call the external MaxSAT solver
-    std::string command = "./uwrmaxsat " + temp_wcnf_file + " > " + temp_output_file;
-    int ret_code = std::system(command.c_str());
+       private:
+        struct Node {
+          int left;
+          int right;
+          int n_leaves;
+          std::vector<int> outputs;
+        };
 
-    // Read the output file
-    std::ifstream output_file(temp_output_file);
-    if (!output_file) {
-      throw std::runtime_error("Failed to open temp_output.txt file!");
-    }
+        int n_inputs;
+        int root;
+        std::vector<Node> nodes;
 
-    // Delete the temp.wcnf file
-    if (std::remove(temp_wcnf_file.c_str()) != 0) {
-      throw std::runtime_error("Failed to delete temp.wcnf file!");
-    }
+        int build(const std::vector<int> &inputs, const int begin, const int end) {
+          if (end - begin == 1) {
+            nodes.push_back({-1, -1, 1, {inputs[begin]}});
+          } else {
+            const int mid = (begin + end) / 2;
+            const int left = build(inputs, begin, mid);
+            const int right = build(inputs, mid, end);
+            nodes.push_back({left, right, end - begin, {}});
+          }
+          return nodes.size() - 1;
+        }
 
-    std::string line;
-    std::string solution_line;
-    bool optimum_found = false;
+        void extend(SatSolver &solver, const int node, int k) {
+          k = std::min(k, nodes[node].n_leaves);
+          const int n_old = nodes[node].outputs.size();
+          if (nodes[node].left == -1 || n_old >= k) {
+            return;
+          }
+          extend(solver, nodes[node].left, k);
+          extend(solver, nodes[node].right, k);
+          for (int i = n_old; i < k; i++) {
+            nodes[node].outputs.push_back(solver.new_variable());
+          }
 
-    while (std::getline(output_file, line)) {
-      if (line.find("Optimal solution: ") != std::string::npos) {
-        // This line contains the optimal solution cost
-//        std::cout << "Optimal solution cost found in solver output: " << line << std::endl;
-        continue;
+          // at least i inputs on the left and j on the right imply at least i + j inputs
+          const std::vector<int> &left = nodes[nodes[node].left].outputs;
+          const std::vector<int> &right = nodes[nodes[node].right].outputs;
+          const std::vector<int> &outputs = nodes[node].outputs;
+          std::vector<int> clause;
+          for (int i = 0; i <= std::min(k, (int)left.size()); i++) {
+            for (int j = 0; j <= std::min(k - i, (int)right.size()); j++) {
+              if (i + j <= n_old) {
+                continue;
+              }
+              clause.clear();
+              if (i > 0) {
+                clause.push_back(-left[i - 1]);
+              }
+              if (j > 0) {
+                clause.push_back(-right[j - 1]);
+              }
+              clause.push_back(outputs[i + j - 1]);
+              solver.add_clause(clause);
+            }
+          }
+        }
+      };
+
+      // conflicts allowed per SAT call when shrinking a core
+      constexpr uint64_t CORE_CONFLICTS = 1000;
+
+      // Shrinks an unsatisfiable core by solving again without each of its literals, and keeps a
+      // literal if that is satisfiable or takes too long. Smaller cores give smaller totalizers
+      // and tighter lower bounds.
+      void minimise_core(SatSolver &sat, std::vector<int> &core, const Deadline deadline) {
+        std::vector<int> necessary;
+        std::vector<int> candidates = core;
+        std::vector<int> assumptions;
+        while (!candidates.empty()) {
+          const int lit = candidates.back();
+          candidates.pop_back();
+          assumptions = necessary;
+          assumptions.insert(assumptions.end(), candidates.begin(), candidates.end());
+          const SatSolver::Result result = sat.solve(assumptions, deadline, CORE_CONFLICTS);
+          if (result == SatSolver::Result::UNSAT) {
+            const std::vector<int> &subcore = sat.get_core();
+            std::erase_if(candidates, [&](const int c) {
+              return std::find(subcore.begin(), subcore.end(), c) == subcore.end();
+            });
+          } else {
+            necessary.push_back(lit);
+          }
+        }
+        core = std::move(necessary);
       }
-      if (line == "s OPTIMUM FOUND") {
-        optimum_found = true;
-        std::cout << "optimum found" << std::endl;
-      } else if (optimum_found) {
-        solution_line = line.substr(1);  // Skip the first character 'v'
-//        std::cout << "Solver output: " << line << std::endl;
-        break;
+    }  // namespace
+
+    MaxSatSolution CoreGuidedMaxSatSolver::solve(const MaxSatProblem &problem,
+                                                 const double time_limit) {
+      const Deadline deadline =
+          time_limit > 0 ? std::chrono::steady_clock::now() +
+                               std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double>(time_limit))
+                         : Deadline::max();
+      const int n_variables = problem.get_n_variables();
+      MaxSatSolution best = {false, false, 0, 0, std::vector<bool>(n_variables + 1, false)};
+
+      SatSolver sat;
+      for (int var = 0; var < n_variables; var++) {
+        sat.new_variable();
       }
-    }
-    output_file.close();
 
-    if (!optimum_found) {
-      throw std::runtime_error("No solution found: 's OPTIMUM FOUND' not present in solver output!");
+      // each soft clause is satisfied if its assumption literal holds, and weights of soft clauses
+      // with the same literal are added up; ordered maps keep assumptions deterministic
+      std::map<int, long> soft_weights;
+      std::vector<int> relaxed;
+      for (int i = 0; i < problem.get_n_clauses(); i++) {
+        std::span<const int> clause = problem.get_clause(i);
+        if (problem.is_hard(i)) {
+          if (!sat.add_clause(clause)) {
+            return best;
+          }
+          continue;
+        }
+        int lit;
+        if (clause.size() == 1) {
+          lit = clause[0];
+        } else {
+          lit = sat.new_variable();
+          relaxed.assign(clause.begin(), clause.end());
+          relaxed.push_back(-lit);
+          sat.add_clause(relaxed);
+        }
+        soft_weights[lit] += problem.get_weight(i);
+        sat.set_polarity(std::abs(lit), lit > 0);
+      }
+
+      auto update_best = [&]() {
+        std::vector<bool> values(n_variables + 1, false);
+        for (int var = 1; var <= n_variables; var++) {
+          values[var] = sat.get_value(var);
+        }
+        const long cost = problem.get_cost(values);
+        if (!best.found || cost < best.cost) {
+          best.found = true;
+          best.cost = cost;
+          best.values = std::move(values);
+        }
+      };
+
+      // any model is an upper bound
+      SatSolver::Result result = sat.solve({}, deadline);
+      if (result != SatSolver::Result::SAT) {
+        return best;
+      }
+      update_best();
+
+      // totalizer outputs whose negation is a soft literal, from the literal to the totalizer
+      // and the number of inputs the output stands for
+      std::vector<Totalizer> totalizers;
+      std::map<int, std::pair<int, int>> output_softs;
+      std::vector<int> assumptions;
+      int n_cores = 0;
+      int next_upper_bound = 1;
+      while (best.cost > best.lower_bound) {
+        assumptions.clear();
+        for (const auto &[lit, weight] : soft_weights) {
+          if (weight > 0) {
+            assumptions.push_back(lit);
+          }
+        }
+        result = sat.solve(assumptions, deadline);
+        if (result == SatSolver::Result::UNKNOWN) {
+          break;
+        } else if (result == SatSolver::Result::SAT) {
+          // all remaining soft literals hold, so this model meets the lower bound
+          update_best();
+          best.lower_bound = best.cost;
+          break;
+        }
+
+        std::vector<int> core = sat.get_core();
+        if (core.empty()) {
+          break;
+        }
+        minimise_core(sat, core, deadline);
+        long min_weight = soft_weights[core[0]];
+        for (const int lit : core) {
+          min_weight = std::min(min_weight, soft_weights[lit]);
+        }
+        best.lower_bound += min_weight;
+
+        for (const int lit : core) {
+          soft_weights[lit] -= min_weight;
+          // relax the bound of a totalizer by one
+          auto it = output_softs.find(lit);
+          if (it != output_softs.end()) {
+            const auto [t, k] = it->second;
+            if (k < totalizers[t].get_n_inputs()) {
+              const int next_lit = -totalizers[t].get_output(sat, k + 1);
+              soft_weights[next_lit] += min_weight;
+              output_softs[next_lit] = {t, k + 1};
+            }
+          }
+        }
+        if (core.size() == 1) {
+          sat.add_clause(std::vector<int>({-core[0]}));
+        } else {
+          // at most one of the core's soft literals may be violated at no further cost
+          std::vector<int> violated;
+          for (const int lit : core) {
+            violated.push_back(-lit);
+          }
+          totalizers.emplace_back(violated);
+          const int lit = -totalizers.back().get_output(sat, 2);
+          soft_weights[lit] += min_weight;
+          output_softs[lit] = {(int)totalizers.size() - 1, 2};
+        }
+
+        if (++n_cores >= next_upper_bound) {
+          next_upper_bound *= 2;
+          result = sat.solve({}, deadline);
+          if (result == SatSolver::Result::UNKNOWN) {
+            break;
+          } else if (result == SatSolver::Result::SAT) {
+            update_best();
+          }
+        }
+      }
+
+      best.optimal = best.cost <= best.lower_bound;
+      best.lower_bound = std::min(best.lower_bound, best.cost);
+      return best;
     }
 
-    // Delete the temp_output.txt file
-    if (std::remove(temp_output_file.c_str()) != 0) {
-      throw std::runtime_error("Failed to delete temp_output.txt file!");
+    ExternalMaxSatSolver::ExternalMaxSatSolver(const std::string &command) : command(command) {}
+
+    namespace {
+      // time given to an external solver to print its best assignment after being asked to stop
+      constexpr double STOP_GRACE_PERIOD = 1.0;
+
+      Deadline deadline_after(const double seconds) {
+        return std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(seconds));
+      }
+
+      // milliseconds until the deadline for poll(), or -1 for no deadline
+      int poll_timeout(const Deadline &deadline) {
+        if (deadline == Deadline::max()) {
+          return -1;
+        }
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        return std::max<long>(0, std::min<long>(remaining.count() + 1, INT_MAX));
+      }
+    }  // namespace
+
+    MaxSatSolution ExternalMaxSatSolver::solve(const MaxSatProblem &problem,
+                                               const double time_limit) {
+      // unique file name so that concurrent processes do not overwrite each others' encodings
+      // solvers such as uwrmaxsat detect the input format from the extension
+      std::string path = (std::filesystem::temp_directory_path() / "wlplan_XXXXXX.wcnf").string();
+      const int fd = mkstemps(path.data(), 5);
+      if (fd == -1) {
+        throw std::runtime_error(std::string("Failed to create WCNF file: ") +
+                                 std::strerror(errno));
+      }
+      close(fd);
+      {
+        std::ofstream wcnf_file(path);
+        wcnf_file << problem.to_string();
+        if (!wcnf_file) {
+          std::filesystem::remove(path);
+          throw std::runtime_error("Failed to write WCNF file " + path);
+        }
+      }
+
+      // The solver runs in its own process group, so that it can be stopped together with the
+      // shell running it. Pipes are closed on exec so that solvers started concurrently from
+      // other threads do not keep each others' output open.
+      const std::string shell_command = command + " " + path;
+      int pipe_fds[2];
+      if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        std::filesystem::remove(path);
+        throw std::runtime_error("Failed to run MaxSAT solver " + command);
+      }
+      const pid_t pid = fork();
+      if (pid == -1) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        std::filesystem::remove(path);
+        throw std::runtime_error("Failed to run MaxSAT solver " + command);
+      }
+      if (pid == 0) {
+        setpgid(0, 0);
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", shell_command.c_str(), (char *)nullptr);
+        _exit(127);
+      }
+      setpgid(pid, pid);
+      close(pipe_fds[1]);
+
+      // Once the time limit is reached, the solver is sent SIGTERM, on which anytime solvers
+      // print their best assignment, and SIGKILL if it has not exited after a grace period.
+      Deadline deadline = time_limit > 0 ? deadline_after(time_limit) : Deadline::max();
+      bool stopped = false;
+      std::string output;
+      char buffer[4096];
+      pollfd poll_fd = {pipe_fds[0], POLLIN, 0};
+      while (true) {
+        const int ready = poll(&poll_fd, 1, poll_timeout(deadline));
+        if (ready == -1 && errno == EINTR) {
+          continue;
+        }
+        if (ready == 0) {
+          if (!stopped) {
+            kill(-pid, SIGTERM);
+            stopped = true;
+            deadline = deadline_after(STOP_GRACE_PERIOD);
+          } else {
+            kill(-pid, SIGKILL);
+            deadline = Deadline::max();
+          }
+          continue;
+        }
+        const ssize_t n_read = ready == -1 ? -1 : read(pipe_fds[0], buffer, sizeof(buffer));
+        if (n_read == -1 && errno == EINTR) {
+          continue;
+        }
+        if (n_read <= 0) {
+          break;
+        }
+        output.append(buffer, n_read);
+      }
+      close(pipe_fds[0]);
+      waitpid(pid, nullptr, 0);
+      std::filesystem::remove(path);
+      if (stopped) {
+        // the last line may have been cut off
+        const size_t end_of_lines = output.rfind('\n');
+        output.resize(end_of_lines == std::string::npos ? 0 : end_of_lines + 1);
+      }
+
+      const int n_variables = problem.get_n_variables();
+      MaxSatSolution solution = {false, false, 0, 0, std::vector<bool>(n_variables + 1, false)};
+      bool reported = false;
+      std::istringstream lines(output);
+      std::string line;
+      while (std::getline(lines, line)) {
+        if (line == "s OPTIMUM FOUND") {
+          reported = true;
+          solution.optimal = true;
+        } else if (line == "s SATISFIABLE") {
+          reported = true;
+        } else if (line == "s UNSATISFIABLE") {
+          return solution;
+        } else if (line.rfind("v ", 0) == 0) {
+          reported = true;
+          // values are either literals or a string of 0s and 1s
+          std::istringstream values(line.substr(2));
+          std::string token;
+          while (values >> token) {
+            if ((int)token.size() == n_variables &&
+                token.find_first_not_of("01") == std::string::npos) {
+              for (int var = 1; var <= n_variables; var++) {
+                solution.values[var] = token[var - 1] == '1';
+              }
+            } else {
+              const int lit = std::stoi(token);
+              if (lit != 0 && std::abs(lit) <= n_variables) {
+                solution.values[std::abs(lit)] = lit > 0;
+              }
+            }
+          }
+        }
+      }
+      if (!reported) {
+        // nothing is found if the solver was stopped before its first assignment
+        if (stopped) {
+          return solution;
+        }
+        throw std::runtime_error("MaxSAT solver " + command + " did not report a solution");
+      }
+      solution.cost = problem.get_cost(solution.values);
+      if (solution.cost < 0) {
+        throw std::runtime_error("MaxSAT solver " + command +
+                                 " reported an assignment violating hard clauses");
+      }
+      solution.found = true;
+      solution.lower_bound = solution.optimal ? solution.cost : 0;
+      return solution;
     }
 
-    // Return the solution line as a string
-    std::istringstream solution_stream(solution_line);
-    std::map<int, int> solution;
-    int value;
-    while (solution_stream >> value) {
-      int variable = std::abs(value);
-      if (variables.count(variable) == 0) {
-        continue;
-      }
-      solution[variable] = (value > 0);
-//      std::cout << "Variable " << variable << " is " << value << std::endl;
+    std::shared_ptr<MaxSatSolver> new_maxsat_solver(const std::string &name) {
+      if (name == "embedded") {
+        return std::make_shared<CoreGuidedMaxSatSolver>();
+      }
+      return std::make_shared<ExternalMaxSatSolver>(name);
     }
-    std::cout << "MaxSAT solved!" << std::endl;
-    //    std::cout << "  Solving time: " << ms_double.count() / 1000 << "s\n";
-    //    std::cout << "  Solution cost: " << cost << std::endl;
-
-    return solution;
-  }
-
-  std::map<int, int> MaxSatProblem::solve() {
-//#ifndef NOPYTHON
-//    if (Py_IsInitialized() == 0) {
-//      // interpreter is not running
-//      py::scoped_interpreter guard{};
-//      return call_solver();
-//    } else {
-//      // interpreter is running (e.g. Python calling wlplan)
-//      return call_solver();
-//    }
-//#else
-//    throw std::runtime_error("MaxSAT feature pruning is not supported in the C++ interface.");
-//#endif
-    return call_solver();
-  }
 
+    namespace {
+      // components with at most this many clauses are solved in process
+      constexpr int SMALL_COMPONENT = 64;
+
+      // the smallest time limit given to a component, as 0 means no limit
+      constexpr double MIN_TIME_LIMIT = 1e-3;
+
+      int find_root(std::vector<int> &parent, int x) {
+        while (parent[x] != x) {
+          parent[x] = parent[parent[x]];
+          x = parent[x];
+        }
+        return x;
+      }
+    }  // namespace
+
+    DecomposingMaxSatSolver::DecomposingMaxSatSolver(const std::string &solver_name,
+                                                     const int n_threads)
+        : solver_name(solver_name),
+          n_threads(n_threads),
+          n_fixed_variables(0),
+          n_components(0),
+          largest_component(0),
+          n_unsolved_components(0) {}
+
+    MaxSatSolution DecomposingMaxSatSolver::solve(const MaxSatProblem &problem,
+                                                  const double time_limit) {
+      const auto start = std::chrono::steady_clock::now();
+      const int n_variables = problem.get_n_variables();
+      const int n_clauses = problem.get_n_clauses();
+      MaxSatSolution solution = {false, false, 0, 0, std::vector<bool>(n_variables + 1, false)};
+      n_fixed_variables = 0;
+      n_components = 0;
+      largest_component = 0;
+      n_unsolved_components = 0;
+
+      // 1. unit propagation of the hard clauses, where value[v] is 1 if v is true, -1 if v is
+      // false and 0 if v is unassigned
+      std::vector<signed char> value(n_variables + 1, 0);
+      std::vector<int> trail;
+      auto lit_value = [&](const int lit) { return lit > 0 ? value[lit] : -value[-lit]; };
+      auto propagate_clause = [&](const int i) {
+        int unit = 0;
+        int n_open = 0;
+        for (const int lit : problem.get_clause(i)) {
+          const int lit_val = lit_value(lit);
+          if (lit_val > 0) {
+            return true;
+          } else if (lit_val == 0) {
+            unit = lit;
+            n_open++;
+          }
+        }
+        if (n_open == 1) {
+          value[std::abs(unit)] = unit > 0 ? 1 : -1;
+          trail.push_back(unit);
+        }
+        return n_open > 0;
+      };
+
+      // hard clauses containing each literal, where literal l has index 2 * |l| + (l < 0)
+      std::vector<size_t> occurrence_offsets(2 * n_variables + 3, 0);
+      for (int i = 0; i < n_clauses; i++) {
+        if (problem.is_hard(i)) {
+          for (const int lit : problem.get_clause(i)) {
+            occurrence_offsets[2 * std::abs(lit) + (lit < 0) + 1]++;
+          }
+        }
+      }
+      for (size_t j = 1; j < occurrence_offsets.size(); j++) {
+        occurrence_offsets[j] += occurrence_offsets[j - 1];
+      }
+      std::vector<int> occurrences(occurrence_offsets.back());
+      std::vector<size_t> fill(occurrence_offsets.begin(), occurrence_offsets.end() - 1);
+      for (int i = 0; i < n_clauses; i++) {
+        if (problem.is_hard(i)) {
+          for (const int lit : problem.get_clause(i)) {
+            occurrences[fill[2 * std::abs(lit) + (lit < 0)]++] = i;
+          }
+        }
+      }
+
+      for (int i = 0; i < n_clauses; i++) {
+        if (problem.is_hard(i) && !propagate_clause(i)) {
+          return solution;
+        }
+      }
+      for (size_t head = 0; head < trail.size(); head++) {
+        const int falsified = -trail[head];
+        const size_t index = 2 * std::abs(falsified) + (falsified < 0);
+        for (size_t j = occurrence_offsets[index]; j < occurrence_offsets[index + 1]; j++) {
+          if (!propagate_clause(occurrences[j])) {
+            return solution;
+          }
+        }
+      }
+      n_fixed_variables = trail.size();
+
+      // 2. connected components of the unassigned variables of clauses that are not yet satisfied
+      long fixed_cost = 0;
+      std::vector<int> parent(n_variables + 1);
+      std::iota(parent.begin(), parent.end(), 0);
+      std::vector<int> clause_variable(n_clauses, 0);
+      for (int i = 0; i < n_clauses; i++) {
+        int first = 0;
+        bool satisfied = false;
+        for (const int lit : problem.get_clause(i)) {
+          const int lit_val = lit_value(lit);
+          if (lit_val > 0) {
+            satisfied = true;
+            break;
+          } else if (lit_val == 0 && first == 0) {
+            first = std::abs(lit);
+          } else if (lit_val == 0) {
+            parent[find_root(parent, std::abs(lit))] = find_root(parent, first);
+          }
+        }
+        if (!satisfied && first == 0) {
+          // only soft clauses can be falsified after propagation
+          fixed_cost += problem.get_weight(i);
+        } else if (!satisfied) {
+          clause_variable[i] = first;
+        }
+      }
+
+      std::vector<int> component_of(n_variables + 1, -1);
+      std::vector<std::vector<int>> component_clauses;
+      for (int i = 0; i < n_clauses; i++) {
+        if (clause_variable[i] == 0) {
+          continue;
+        }
+        const int root = find_root(parent, clause_variable[i]);
+        if (component_of[root] == -1) {
+          component_of[root] = component_clauses.size();
+          component_clauses.emplace_back();
+        }
+        component_clauses[component_of[root]].push_back(i);
+      }
+      n_components = component_clauses.size();
+
+      // 3. subproblems over variables numbered from 1 in each component
+      std::vector<int> local_variable(n_variables + 1, 0);
+      std::vector<std::vector<int>> component_variables(n_components);
+      std::vector<MaxSatProblem> subproblems(n_components);
+      std::vector<int> clause;
+      for (int c = 0; c < n_components; c++) {
+        for (const int i : component_clauses[c]) {
+          clause.clear();
+          for (const int lit : problem.get_clause(i)) {
+            if (lit_value(lit) == 0) {
+              const int var = std::abs(lit);
+              if (local_variable[var] == 0) {
+                component_variables[c].push_back(var);
+                local_variable[var] = component_variables[c].size();
+              }
+              clause.push_back(lit > 0 ? local_variable[var] : -local_variable[var]);
+            }
+          }
+          if (problem.is_hard(i)) {
+            subproblems[c].add_hard(clause);
+          } else {
+            subproblems[c].add_soft(clause, problem.get_weight(i));
+          }
+        }
+        largest_component = std::max(largest_component, subproblems[c].get_n_clauses());
+      }
+      component_clauses.clear();
+
+      // 4. solve the largest components first so that they do not finish last
+      std::vector<int> order(n_components);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) {
+        return subproblems[a].get_n_clauses() > subproblems[b].get_n_clauses();
+      });
+      std::vector<MaxSatSolution> solutions(n_components);
+      utils::parallel_for(order.size(), n_threads, [&](const int, const size_t k) {
+        const int c = order[k];
+        double component_time_limit = 0;
+        if (time_limit > 0) {
+          const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+          component_time_limit = std::max(time_limit - elapsed.count(), MIN_TIME_LIMIT);
+        }
+        const bool small = subproblems[c].get_n_clauses() <= SMALL_COMPONENT;
+        solutions[c] = new_maxsat_solver(small ? "embedded" : solver_name)
+                           ->solve(subproblems[c], component_time_limit);
+      });
+
+      // 5. merge
+      for (int var = 1; var <= n_variables; var++) {
+        solution.values[var] = value[var] > 0;
+      }
+      solution.found = true;
+      solution.optimal = true;
+      solution.cost = fixed_cost;
+      solution.lower_bound = fixed_cost;
+      for (int c = 0; c < n_components; c++) {
+        MaxSatSolution &component_solution = solutions[c];
+        if (!component_solution.found) {
+          n_unsolved_components++;
+          if ((int)fallback.size() == n_variables + 1) {
+            component_solution.values.assign(component_variables[c].size() + 1, false);
+            for (size_t v = 0; v < component_variables[c].size(); v++) {
+              component_solution.values[v + 1] = fallback[component_variables[c][v]];
+            }
+            component_solution.cost = subproblems[c].get_cost(component_solution.values);
+            component_solution.found = component_solution.cost >= 0;
+            component_solution.optimal = false;
+          }
+        }
+        if (!component_solution.found) {
+          solution.found = false;
+          solution.optimal = false;
+          return solution;
+        }
+        for (size_t v = 0; v < component_variables[c].size(); v++) {
+          solution.values[component_variables[c][v]] = component_solution.values[v + 1];
+        }
+        solution.optimal = solution.optimal && component_solution.optimal;
+        solution.cost += component_solution.cost;
+        solution.lower_bound += component_solution.lower_bound;
+      }
+      return solution;
+    }
   }  // namespace feature_generator
 }  // namespace wlplan
@@ -10,7 +10,7 @@ namespace wlplan {
     std::vector<int>
     KWL2NeighbourContainer::get_neighbour_colours(const std::vector<int> &colours) {
       std::set<int> neighbour_colours_set;
-      for (const auto &[col0, col1, n_occurrences] : deconstruct(colours)) {
+      for (const auto &[col0, col1, n_occurrences] : deconstruct_pairs(colours)) {
         neighbour_colours_set.insert(col0);
         neighbour_colours_set.insert(col1);
       }
@@ -22,13 +22,20 @@ namespace wlplan {
       return neighbour_colours;
     }
 
+    std::vector<std::tuple<int, int, int>>
+    KWL2NeighbourContainer::deconstruct_pairs(const std::vector<int> &colours) {
+      std::vector<int> rotated(colours.begin() + 1, colours.end());
+      rotated.push_back(colours.at(0));
+      return deconstruct(rotated);
+    }
+
     std::vector<int> KWL2NeighbourContainer::remap(const std::vector<int> &input,
                                                    const std::map<int, int> &remap) {
       clear();
 
       std::vector<int> output = {remap.at(input.at(0))};
 
-      for (const auto &[col0, col1, n_occurrences] : deconstruct(input)) {
+      for (const auto &[col0, col1, n_occurrences] : deconstruct_pairs(input)) {
         for (int i = 0; i < n_occurrences; i++) {
           insert(remap.at(col0), remap.at(col1));
         }
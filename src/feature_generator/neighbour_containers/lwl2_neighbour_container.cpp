@@ -7,6 +7,21 @@ namespace wlplan {
     LWL2NeighbourContainer::LWL2NeighbourContainer(bool multiset_hash)
         : KWL2NeighbourContainer(multiset_hash) {}
 
+    std::vector<int>
+    LWL2NeighbourContainer::get_neighbour_colours(const std::vector<int> &colours) {
+      std::vector<int> neighbour_colours = KWL2NeighbourContainer::get_neighbour_colours(colours);
+      if (neighbour_colours.back() == FAR_PAIR_COLOUR) {
+        neighbour_colours.pop_back();
+      }
+      return neighbour_colours;
+    }
+
+    namespace {
+      int remap_pair_colour(const int colour, const std::map<int, int> &remap) {
+        return colour == FAR_PAIR_COLOUR ? colour : remap.at(colour);
+      }
+    }  // namespace
+
     std::vector<int> LWL2NeighbourContainer::remap(const std::vector<int> &input,
                                                    const std::map<int, int> &remap) {
       clear();
@@ -21,10 +36,10 @@ namespace wlplan {
 
       std::vector<int> output = {remap.at(input.at(0))};
 
-      for (const auto &[col0, col1, n_occurrences] : deconstruct(input)) {
+      for (const auto &[col0, col1, n_occurrences] : deconstruct_pairs(input)) {
         for (int i = 0; i < n_occurrences; i++) {
-          int col_a = std::min(remap.at(col0), remap.at(col1));
-          int col_b = std::max(remap.at(col0), remap.at(col1));
+          int col_a = std::min(remap_pair_colour(col0, remap), remap_pair_colour(col1, remap));
+          int col_b = std::max(remap_pair_colour(col0, remap), remap_pair_colour(col1, remap));
           insert(col_a, col_b);
         }
       }
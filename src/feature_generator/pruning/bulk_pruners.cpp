@@ -9,6 +9,7 @@ namespace wlplan {
   namespace feature_generator {
 
     void Features::prune_bulk() {
+      colour_statistics.seal();
       std::set<int> to_prune;
       pruned = true;
       if (pruning == PruningOptions::ALL_MAXSAT) {
@@ -34,8 +35,9 @@ namespace wlplan {
       std::vector<std::set<int>> edges_bw = std::vector<std::set<int>>(n_features, std::set<int>());
 
       for (int itr = 1; itr < maxsat_iterations + 1; itr++) {
-        // neighbours: std::vector<int>; colour: int
-        for (const auto &[neighbours, colour] : colour_hash[itr]) {
+        // key: ColourKey; colour: int
+        for (const auto &[key, colour] : colour_hash[itr]) {
+          std::vector<int> neighbours(key.begin(), key.end());
           for (const int ancestor : neighbour_container->get_neighbour_colours(neighbours)) {
             edges_fw.at(ancestor).insert(colour);
             edges_bw.at(colour).insert(ancestor);
@@ -65,12 +67,12 @@ namespace wlplan {
       // 2. maxsat
       std::cout << "Encoding MaxSAT." << std::endl;
 
-      std::vector<MaxSatClause> clauses;
+      MaxSatProblem max_sat_problem;
 
       // variable=T indicates feature to be thrown out
       // equivalently, ~variable=T indicates feature to be kept
       for (const auto &[colour, _] : feature_group) {
-        clauses.push_back(MaxSatClause({colour + 1}, {false}, 1, false));
+        max_sat_problem.add_soft({colour + 1}, 1);
       }
 
       // a kept variable forces ancestors to be kept
@@ -78,29 +80,51 @@ namespace wlplan {
       // (child | ~ancestor_1) & ... & (child | ~ancestor_n)
       for (const auto &[child, _] : feature_group) {
         for (const int ancestor : edges_bw.at(child)) {
-          clauses.push_back(MaxSatClause({child + 1, ancestor + 1}, {false, true}, 0, true));
+          max_sat_problem.add_hard({child + 1, -(ancestor + 1)});
         }
       }
 
       // keep one feature from each equivalence group
       for (const auto &[group, features] : group_to_features) {
-        std::vector<int> features_v;
+        std::vector<int> clause;
         for (const int feature : features) {
-          features_v.push_back(feature + 1);
+          clause.push_back(-(feature + 1));
         }
-        std::vector<bool> negated(features.size(), true);
-        clauses.push_back(MaxSatClause(features_v, negated, 0, true));
+        max_sat_problem.add_hard(clause);
       }
 
       // solve
-      MaxSatProblem max_sat_problem = MaxSatProblem(clauses);
-
-      // time the solver
-      std::map<int, int> solution = max_sat_problem.solve();
+      std::cout << "  Variables: " << max_sat_problem.get_n_variables() << std::endl;
+      std::cout << "  Clauses: " << max_sat_problem.get_n_clauses() << std::endl;
+      DecomposingMaxSatSolver solver(maxsat_solver, n_threads);
+      // keeping all features satisfies the hard clauses, so components that are not solved in
+      // time keep their features instead of discarding the solutions of the other components
+      solver.set_fallback(std::vector<bool>(max_sat_problem.get_n_variables() + 1, false));
+      MaxSatSolution solution = solver.solve(max_sat_problem, maxsat_time_limit);
+      std::cout << "  Variables fixed by propagation: " << solver.get_n_fixed_variables()
+                << std::endl;
+      std::cout << "  Components: " << solver.get_n_components()
+                << " (largest with " << solver.get_largest_component() << " clauses)"
+                << std::endl;
+      if (solver.get_n_unsolved_components() > 0) {
+        std::cout << "WARNING: " << solver.get_n_unsolved_components()
+                  << " MaxSAT components were not solved, so their features are kept"
+                  << std::endl;
+      }
+      if (!solution.found) {
+        std::cout << "WARNING: no MaxSAT solution found, so no features are pruned" << std::endl;
+        return to_prune;
+      }
+      std::cout << "MaxSAT solved!" << std::endl;
+      std::cout << "  Solution cost: " << solution.cost
+                << (solution.optimal ? " (optimal)" : " (lower bound " +
+                                                          std::to_string(solution.lower_bound) +
+                                                          ")")
+                << std::endl;
 
-      for (const auto &[colour, value] : solution) {
-        if (value == 1) {
-          to_prune.insert(colour - 1);
+      for (const auto &[colour, _] : feature_group) {
+        if (solution.values[colour + 1]) {
+          to_prune.insert(colour);
         }
       }
 
@@ -3,8 +3,8 @@
 namespace wlplan {
   namespace feature_generator {
 
-    void Features::prune_this_iteration(int iteration,
-                                        std::vector<Embedding> &cur_colours) {
+    void Features::prune_this_iteration(int iteration, ColouringStore &cur_colours) {
+      colour_statistics.seal();
       std::set<int> to_prune;
       pruned = true;
       if (pruning == PruningOptions::LAYER_GREEDY) {
@@ -26,13 +26,9 @@ namespace wlplan {
         std::cout << "Pruning " << to_prune.size() << " features." << std::endl;
         std::map<int, int> remap = remap_colour_hash(to_prune);
         for (size_t graph_i = 0; graph_i < cur_colours.size(); graph_i++) {
-          for (size_t node_i = 0; node_i < cur_colours[graph_i].size(); node_i++) {
-            int col = cur_colours[graph_i][node_i];
-            if (remap.count(col) > 0) {
-              cur_colours[graph_i][node_i] = remap[col];
-            } else {
-              cur_colours[graph_i][node_i] = UNSEEN_COLOUR;
-            }
+          for (int *col = cur_colours.begin(graph_i); col != cur_colours.end(graph_i); col++) {
+            auto it = remap.find(*col);
+            *col = it == remap.end() ? UNSEEN_COLOUR : it->second;
           }
         }
       }
@@ -107,9 +103,7 @@ namespace wlplan {
       int D = get_n_colours();
       int one_percent = N / 100;
       for (int i = 0; i < D; i++) {
-        int count = accumulate( colour_statistics[i].begin(), colour_statistics[i].end(), 0,
-                               []( int acc, std::pair<int, int> p ) { return ( acc + p.second ); } );
-        if (count <= one_percent) {
+        if (colour_statistics.get_total_count(i) <= one_percent) {
           to_prune.insert(i);
         }
       }
@@ -0,0 +1,510 @@
+#include "../../include/feature_generator/sat_solver.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace wlplan {
+  namespace feature_generator {
+    namespace {
+      constexpr double VAR_DECAY = 0.95;
+      constexpr double CLAUSE_DECAY = 0.999;
+      constexpr uint64_t RESTART_UNIT = 100;
+
+      // 1, 1, 2, 1, 1, 2, 4, 1, ...
+      uint64_t luby(uint64_t x) {
+        uint64_t size = 1, seq = 0;
+        while (size < x + 1) {
+          seq++;
+          size = 2 * size + 1;
+        }
+        while (size - 1 != x) {
+          size = (size - 1) >> 1;
+          seq--;
+          x = x % size;
+        }
+        return (uint64_t)1 << seq;
+      }
+    }  // namespace
+
+    SatSolver::SatSolver()
+        : ok(true),
+          qhead(0),
+          var_inc(1),
+          clause_inc(1),
+          n_learnts(0),
+          max_learnts(0),
+          n_conflicts(0) {}
+
+    int SatSolver::new_variable() {
+      int var = assigns.size();
+      assigns.push_back(-1);
+      polarity.push_back(false);
+      level.push_back(0);
+      reason.push_back(-1);
+      activity.push_back(0);
+      heap_index.push_back(-1);
+      seen.push_back(0);
+      watches.emplace_back();
+      watches.emplace_back();
+      heap_insert(var);
+      return var + 1;
+    }
+
+    void SatSolver::set_polarity(const int variable, const bool value) {
+      polarity[variable - 1] = value;
+    }
+
+    /* Variable order */
+
+    void SatSolver::heap_up(int i) {
+      const int var = heap[i];
+      while (i > 0) {
+        int parent = (i - 1) >> 1;
+        if (activity[heap[parent]] >= activity[var]) {
+          break;
+        }
+        heap[i] = heap[parent];
+        heap_index[heap[i]] = i;
+        i = parent;
+      }
+      heap[i] = var;
+      heap_index[var] = i;
+    }
+
+    void SatSolver::heap_down(int i) {
+      const int var = heap[i];
+      const int n = heap.size();
+      while (2 * i + 1 < n) {
+        int child = 2 * i + 1;
+        if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]]) {
+          child++;
+        }
+        if (activity[heap[child]] <= activity[var]) {
+          break;
+        }
+        heap[i] = heap[child];
+        heap_index[heap[i]] = i;
+        i = child;
+      }
+      heap[i] = var;
+      heap_index[var] = i;
+    }
+
+    void SatSolver::heap_insert(const int var) {
+      if (heap_index[var] != -1) {
+        return;
+      }
+      heap.push_back(var);
+      heap_up(heap.size() - 1);
+    }
+
+    int SatSolver::heap_pop() {
+      const int var = heap[0];
+      heap_index[var] = -1;
+      const int last = heap.back();
+      heap.pop_back();
+      if (!heap.empty()) {
+        heap[0] = last;
+        heap_index[last] = 0;
+        heap_down(0);
+      }
+      return var;
+    }
+
+    void SatSolver::bump_variable(const int var) {
+      if ((activity[var] += var_inc) > 1e100) {
+        for (double &a : activity) {
+          a *= 1e-100;
+        }
+        var_inc *= 1e-100;
+      }
+      if (heap_index[var] != -1) {
+        heap_up(heap_index[var]);
+      }
+    }
+
+    void SatSolver::bump_clause(Clause &clause) {
+      if ((clause.activity += clause_inc) > 1e20) {
+        for (Clause &c : clauses) {
+          if (c.learnt) {
+            c.activity *= 1e-20;
+          }
+        }
+        clause_inc *= 1e-20;
+      }
+    }
+
+    /* Clauses and propagation */
+
+    bool SatSolver::add_clause(std::span<const int> literals) {
+      if (!ok) {
+        return false;
+      }
+      std::vector<int> lits;
+      for (const int dimacs : literals) {
+        if (dimacs == 0 || std::abs(dimacs) > get_n_variables()) {
+          throw std::runtime_error("Invalid SAT literal " + std::to_string(dimacs));
+        }
+        lits.push_back(to_literal(dimacs));
+      }
+      std::sort(lits.begin(), lits.end());
+
+      // drop duplicates and literals false at the root, and skip satisfied clauses
+      size_t j = 0;
+      for (size_t i = 0; i < lits.size(); i++) {
+        const int lit = lits[i];
+        if (value(lit) == 1 || (j > 0 && lits[j - 1] == (lit ^ 1))) {
+          return true;
+        }
+        if (value(lit) != 0 && (j == 0 || lits[j - 1] != lit)) {
+          lits[j++] = lit;
+        }
+      }
+      lits.resize(j);
+
+      if (lits.empty()) {
+        ok = false;
+      } else if (lits.size() == 1) {
+        enqueue(lits[0], -1);
+        ok = propagate() == -1;
+      } else {
+        clauses.push_back({std::move(lits), 0, false, false});
+        attach(clauses.size() - 1);
+      }
+      return ok;
+    }
+
+    void SatSolver::attach(const int cref) {
+      const std::vector<int> &lits = clauses[cref].lits;
+      watches[lits[0]].push_back({cref, lits[1]});
+      watches[lits[1]].push_back({cref, lits[0]});
+    }
+
+    void SatSolver::enqueue(const int lit, const int cref) {
+      const int var = lit >> 1;
+      assigns[var] = !(lit & 1);
+      level[var] = decision_level();
+      reason[var] = cref;
+      trail.push_back(lit);
+    }
+
+    int SatSolver::propagate() {
+      int confl = -1;
+      while (qhead < trail.size()) {
+        const int false_lit = trail[qhead++] ^ 1;
+        std::vector<Watcher> &ws = watches[false_lit];
+        size_t i = 0, j = 0;
+        while (i < ws.size()) {
+          const Watcher w = ws[i++];
+          if (value(w.blocker) == 1) {
+            ws[j++] = w;
+            continue;
+          }
+          Clause &c = clauses[w.cref];
+          if (c.deleted) {
+            continue;
+          }
+
+          // make sure the false literal is the second watch
+          std::vector<int> &lits = c.lits;
+          if (lits[0] == false_lit) {
+            std::swap(lits[0], lits[1]);
+          }
+          const int first = lits[0];
+          if (first != w.blocker && value(first) == 1) {
+            ws[j++] = {w.cref, first};
+            continue;
+          }
+
+          // look for a new literal to watch
+          bool found = false;
+          for (size_t k = 2; k < lits.size(); k++) {
+            if (value(lits[k]) != 0) {
+              std::swap(lits[1], lits[k]);
+              watches[lits[1]].push_back({w.cref, first});
+              found = true;
+              break;
+            }
+          }
+          if (found) {
+            continue;
+          }
+
+          // clause is unit or conflicting
+          ws[j++] = {w.cref, first};
+          if (value(first) == 0) {
+            confl = w.cref;
+            qhead = trail.size();
+            while (i < ws.size()) {
+              ws[j++] = ws[i++];
+            }
+          } else {
+            enqueue(first, w.cref);
+          }
+        }
+        ws.resize(j);
+      }
+      return confl;
+    }
+
+    /* Conflict analysis */
+
+    void SatSolver::analyse(int confl, std::vector<int> &learnt, int &backtrack_level) {
+      learnt.assign(1, -1);
+      int path = 0;
+      int lit = -1;
+      int index = trail.size() - 1;
+      do {
+        Clause &c = clauses[confl];
+        if (c.learnt) {
+          bump_clause(c);
+        }
+        for (size_t k = lit == -1 ? 0 : 1; k < c.lits.size(); k++) {
+          const int q = c.lits[k];
+          const int var = q >> 1;
+          if (!seen[var] && level[var] > 0) {
+            bump_variable(var);
+            seen[var] = 1;
+            if (level[var] >= decision_level()) {
+              path++;
+            } else {
+              learnt.push_back(q);
+            }
+          }
+        }
+        while (!seen[trail[index--] >> 1]) {
+        }
+        lit = trail[index + 1];
+        confl = reason[lit >> 1];
+        seen[lit >> 1] = 0;
+        path--;
+      } while (path > 0);
+      learnt[0] = lit ^ 1;
+
+      // drop literals implied by the other literals of the clause
+      const std::vector<int> analysed(learnt.begin() + 1, learnt.end());
+      size_t j = 1;
+      for (size_t i = 1; i < learnt.size(); i++) {
+        const int cref = reason[learnt[i] >> 1];
+        bool redundant = cref != -1;
+        if (redundant) {
+          const std::vector<int> &lits = clauses[cref].lits;
+          for (size_t k = 1; k < lits.size(); k++) {
+            const int var = lits[k] >> 1;
+            if (!seen[var] && level[var] > 0) {
+              redundant = false;
+              break;
+            }
+          }
+        }
+        if (!redundant) {
+          learnt[j++] = learnt[i];
+        }
+      }
+      learnt.resize(j);
+      for (const int q : analysed) {
+        seen[q >> 1] = 0;
+      }
+
+      // the literal with the highest level after the asserting literal becomes the second watch
+      backtrack_level = 0;
+      if (learnt.size() > 1) {
+        size_t max_i = 1;
+        for (size_t i = 2; i < learnt.size(); i++) {
+          if (level[learnt[i] >> 1] > level[learnt[max_i] >> 1]) {
+            max_i = i;
+          }
+        }
+        std::swap(learnt[1], learnt[max_i]);
+        backtrack_level = level[learnt[1] >> 1];
+      }
+    }
+
+    void SatSolver::analyse_final(const int failed) {
+      // failed is an assumption that is false under the current assumptions
+      core.assign(1, to_dimacs(failed));
+      if (decision_level() == 0) {
+        return;
+      }
+      seen[failed >> 1] = 1;
+      for (int i = trail.size() - 1; i >= trail_lim[0]; i--) {
+        const int var = trail[i] >> 1;
+        if (!seen[var]) {
+          continue;
+        }
+        if (reason[var] == -1) {
+          // decisions below the assumption levels are assumptions
+          core.push_back(to_dimacs(trail[i]));
+        } else {
+          const std::vector<int> &lits = clauses[reason[var]].lits;
+          for (size_t k = 1; k < lits.size(); k++) {
+            if (level[lits[k] >> 1] > 0) {
+              seen[lits[k] >> 1] = 1;
+            }
+          }
+        }
+        seen[var] = 0;
+      }
+      seen[failed >> 1] = 0;
+    }
+
+    void SatSolver::cancel_until(const int target_level) {
+      if (decision_level() <= target_level) {
+        return;
+      }
+      for (int i = trail.size() - 1; i >= trail_lim[target_level]; i--) {
+        const int var = trail[i] >> 1;
+        assigns[var] = -1;
+        polarity[var] = !(trail[i] & 1);
+        heap_insert(var);
+      }
+      trail.resize(trail_lim[target_level]);
+      trail_lim.resize(target_level);
+      qhead = trail.size();
+    }
+
+    void SatSolver::reduce_learnts() {
+      // delete the less active half of the learnt clauses that are not reasons
+      std::vector<int> candidates;
+      for (size_t cref = 0; cref < clauses.size(); cref++) {
+        const Clause &c = clauses[cref];
+        if (!c.learnt || c.deleted || c.lits.size() <= 2) {
+          continue;
+        }
+        const int var = c.lits[0] >> 1;
+        if (reason[var] == (int)cref && value(c.lits[0]) == 1) {
+          continue;
+        }
+        candidates.push_back(cref);
+      }
+      std::sort(candidates.begin(), candidates.end(), [&](const int a, const int b) {
+        return clauses[a].activity < clauses[b].activity;
+      });
+      for (size_t i = 0; i < candidates.size() / 2; i++) {
+        Clause &c = clauses[candidates[i]];
+        c.deleted = true;
+        c.lits = std::vector<int>();
+        n_learnts--;
+      }
+      max_learnts *= 1.1;
+    }
+
+    /* Search */
+
+    SatSolver::Result SatSolver::search(const std::vector<int> &assumptions,
+                                        const uint64_t max_conflicts,
+                                        const Deadline deadline) {
+      uint64_t conflicts = 0;
+      uint64_t decisions = 0;
+      std::vector<int> learnt;
+      for (;;) {
+        const int confl = propagate();
+        if (confl != -1) {
+          n_conflicts++;
+          conflicts++;
+          if (decision_level() == 0) {
+            ok = false;
+            core.clear();
+            return Result::UNSAT;
+          }
+          int backtrack_level;
+          analyse(confl, learnt, backtrack_level);
+          cancel_until(backtrack_level);
+          if (learnt.size() == 1) {
+            enqueue(learnt[0], -1);
+          } else {
+            clauses.push_back({learnt, 0, true, false});
+            const int cref = clauses.size() - 1;
+            attach(cref);
+            bump_clause(clauses[cref]);
+            n_learnts++;
+            enqueue(learnt[0], cref);
+          }
+          var_inc /= VAR_DECAY;
+          clause_inc /= CLAUSE_DECAY;
+          if ((n_conflicts & 255) == 0 && std::chrono::steady_clock::now() >= deadline) {
+            cancel_until(0);
+            return Result::UNKNOWN;
+          }
+          continue;
+        }
+
+        if (conflicts >= max_conflicts) {
+          cancel_until(0);
+          return Result::UNKNOWN;
+        }
+        if (n_learnts >= trail.size() + max_learnts) {
+          reduce_learnts();
+        }
+
+        // assumptions are decided first, one per level
+        int next = -1;
+        while (decision_level() < (int)assumptions.size()) {
+          const int lit = assumptions[decision_level()];
+          if (value(lit) == 1) {
+            trail_lim.push_back(trail.size());
+          } else if (value(lit) == 0) {
+            analyse_final(lit);
+            cancel_until(0);
+            return Result::UNSAT;
+          } else {
+            next = lit;
+            break;
+          }
+        }
+        if (next == -1) {
+          while (!heap.empty() && assigns[heap[0]] != -1) {
+            heap_pop();
+          }
+          if (heap.empty()) {
+            model.resize(assigns.size());
+            for (size_t var = 0; var < assigns.size(); var++) {
+              model[var] = assigns[var] == 1;
+            }
+            cancel_until(0);
+            return Result::SAT;
+          }
+          const int var = heap_pop();
+          next = 2 * var + !polarity[var];
+        }
+        if ((++decisions & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) {
+          cancel_until(0);
+          return Result::UNKNOWN;
+        }
+        trail_lim.push_back(trail.size());
+        enqueue(next, -1);
+      }
+    }
+
+    SatSolver::Result SatSolver::solve(const std::vector<int> &assumptions,
+                                       const Deadline deadline,
+                                       const uint64_t conflict_budget) {
+      core.clear();
+      if (!ok) {
+        return Result::UNSAT;
+      }
+      std::vector<int> lits;
+      for (const int dimacs : assumptions) {
+        if (dimacs == 0 || std::abs(dimacs) > get_n_variables()) {
+          throw std::runtime_error("Invalid SAT assumption " + std::to_string(dimacs));
+        }
+        lits.push_back(to_literal(dimacs));
+      }
+      max_learnts = std::max(max_learnts, std::max(1000.0, clauses.size() / 3.0));
+
+      const uint64_t conflict_limit = conflict_budget > 0 ? n_conflicts + conflict_budget : 0;
+      for (uint64_t restart = 0;; restart++) {
+        uint64_t max_conflicts = luby(restart) * RESTART_UNIT;
+        if (conflict_limit > 0) {
+          max_conflicts = std::min(max_conflicts, conflict_limit - n_conflicts);
+        }
+        const Result result = search(lits, max_conflicts, deadline);
+        if (result != Result::UNKNOWN || std::chrono::steady_clock::now() >= deadline ||
+            (conflict_limit > 0 && n_conflicts >= conflict_limit)) {
+          return result;
+        }
+      }
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
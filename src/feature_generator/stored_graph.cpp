@@ -0,0 +1,28 @@
+#include "../../include/feature_generator/stored_graph.hpp"
+
+namespace wlplan {
+  namespace feature_generator {
+    void StoredGraph::encode(const graph_generator::Graph &graph, std::vector<int> &data) {
+      data.push_back(graph.nodes.size());
+      data.insert(data.end(), graph.nodes.begin(), graph.nodes.end());
+      data.insert(data.end(), graph.offsets.begin(), graph.offsets.end());
+      data.insert(data.end(), graph.edge_labels.begin(), graph.edge_labels.end());
+      data.insert(data.end(), graph.neighbours.begin(), graph.neighbours.end());
+    }
+
+    StoredGraph::StoredGraph(const int *data) : n_nodes(data[0]) {
+      nodes = data + 1;
+      offsets = nodes + n_nodes;
+      edge_labels = offsets + n_nodes + 1;
+      neighbours = edge_labels + offsets[n_nodes];
+    }
+
+    std::set<int> StoredGraph::get_nodes_set() const {
+      std::set<int> nodes_set;
+      for (int u = 0; u < n_nodes; u++) {
+        nodes_set.insert(u);
+      }
+      return nodes_set;
+    }
+  }  // namespace feature_generator
+}  // namespace wlplan
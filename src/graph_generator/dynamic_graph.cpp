@@ -0,0 +1,254 @@
+#include "../../include/graph_generator/dynamic_graph.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace wlplan::graph_generator {
+  void DynamicGraphLog::clear() {
+    changes.clear();
+    edges.clear();
+  }
+
+  DynamicGraph::DynamicGraph(const std::shared_ptr<const Graph> &base)
+      : base(base),
+        n_base_nodes(base->nodes.size()),
+        nodes(base->nodes),
+        removed(base->nodes.size(), false),
+        first_in(base->nodes.size(), -1),
+        log(nullptr) {}
+
+  int DynamicGraph::add_node(const int64_t key,
+                             const int colour,
+                             const std::vector<std::pair<int, int>> &edges) {
+    DynamicGraphLog::Change node;
+    node.type = DynamicGraphLog::ChangeType::ADD_NODE;
+    node.key = key;
+    node.old_colour = colour;
+    node.new_colour = colour;
+    node.n_edges = edges.size();
+    node.new_index = free_nodes.empty();
+    node.node = node.new_index ? nodes.size() : free_nodes.back();
+    node.new_block = node.n_edges > 0 && ((int)free_blocks.size() <= node.n_edges ||
+                                          free_blocks[node.n_edges].empty());
+    if (node.n_edges == 0) {
+      node.block = -1;
+    } else if (node.new_block) {
+      node.block = edge_sources.size();
+    } else {
+      node.block = free_blocks[node.n_edges].back();
+    }
+
+    insert_node(node, edges.data());
+    if (log != nullptr) {
+      node.edges_start = log->edges.size();
+      log->edges.insert(log->edges.end(), edges.begin(), edges.end());
+      log->changes.push_back(node);
+    }
+    return node.node;
+  }
+
+  void DynamicGraph::change_node_colour(const int u, const int new_colour) {
+    if (log != nullptr) {
+      DynamicGraphLog::Change change;
+      change.type = DynamicGraphLog::ChangeType::CHANGE_COLOUR;
+      change.node = u;
+      change.old_colour = nodes[u];
+      change.new_colour = new_colour;
+      log->changes.push_back(change);
+    }
+    nodes[u] = new_colour;
+  }
+
+  std::vector<int> DynamicGraph::remove_node(const int64_t key) {
+    auto it = key_to_node.find(key);
+    if (it == key_to_node.end()) {
+      throw std::runtime_error("Error: cannot remove node with key " + std::to_string(key) +
+                               " as it does not exist");
+    }
+
+    DynamicGraphLog::Change node;
+    node.type = DynamicGraphLog::ChangeType::REMOVE_NODE;
+    node.node = it->second;
+    node.key = key;
+    node.old_colour = nodes[node.node];
+    node.new_colour = nodes[node.node];
+    node.block = blocks[node.node - n_base_nodes];
+    node.n_edges = degrees[node.node - n_base_nodes];
+    node.new_index = false;
+    node.new_block = false;
+
+    std::vector<int> neighbours;
+    for (int e = node.block; e < node.block + node.n_edges; e++) {
+      neighbours.push_back(edge_targets[e]);
+    }
+    if (log != nullptr) {
+      node.edges_start = log->edges.size();
+      for (int e = node.block; e < node.block + node.n_edges; e++) {
+        log->edges.push_back(std::make_pair(edge_labels[e], edge_targets[e]));
+      }
+    }
+
+    erase_node(node);
+    if (log != nullptr) {
+      log->changes.push_back(node);
+    }
+    return neighbours;
+  }
+
+  int DynamicGraph::get_node_index(const int64_t key) const {
+    auto it = key_to_node.find(key);
+    return it == key_to_node.end() ? -1 : it->second;
+  }
+
+  void DynamicGraph::insert_node(const DynamicGraphLog::Change &node,
+                                 const std::pair<int, int> *edges) {
+    const int u = node.node;
+    if (node.new_index) {
+      nodes.push_back(node.new_colour);
+      removed.push_back(false);
+      first_in.push_back(-1);
+      blocks.push_back(-1);
+      degrees.push_back(0);
+    } else {
+      free_nodes.pop_back();
+      nodes[u] = node.new_colour;
+      removed[u] = false;
+    }
+
+    if (node.new_block) {
+      const size_t pool_size = edge_sources.size() + node.n_edges;
+      edge_sources.resize(pool_size);
+      edge_labels.resize(pool_size);
+      edge_targets.resize(pool_size);
+      next_in.resize(pool_size);
+      prev_in.resize(pool_size);
+    } else if (node.n_edges > 0) {
+      free_blocks[node.n_edges].pop_back();
+    }
+    for (int i = 0; i < node.n_edges; i++) {
+      const int e = node.block + i;
+      edge_sources[e] = u;
+      edge_labels[e] = edges[i].first;
+      edge_targets[e] = edges[i].second;
+    }
+
+    blocks[u - n_base_nodes] = node.block;
+    degrees[u - n_base_nodes] = node.n_edges;
+    link_block(u);
+    key_to_node[node.key] = u;
+  }
+
+  void DynamicGraph::erase_node(const DynamicGraphLog::Change &node) {
+    const int u = node.node;
+    unlink_block(u);
+    if (first_in[u] != -1) {
+      link_block(u);
+      throw std::runtime_error("Error: cannot remove node with key " + std::to_string(node.key) +
+                               " as nodes added after it have edges to it");
+    }
+    key_to_node.erase(node.key);
+
+    if (node.new_block) {
+      const size_t pool_size = edge_sources.size() - node.n_edges;
+      edge_sources.resize(pool_size);
+      edge_labels.resize(pool_size);
+      edge_targets.resize(pool_size);
+      next_in.resize(pool_size);
+      prev_in.resize(pool_size);
+    } else if (node.n_edges > 0) {
+      if ((int)free_blocks.size() <= node.n_edges) {
+        free_blocks.resize(node.n_edges + 1);
+      }
+      free_blocks[node.n_edges].push_back(node.block);
+    }
+
+    if (node.new_index) {
+      nodes.pop_back();
+      removed.pop_back();
+      first_in.pop_back();
+      blocks.pop_back();
+      degrees.pop_back();
+    } else {
+      removed[u] = true;
+      free_nodes.push_back(u);
+    }
+  }
+
+  void DynamicGraph::link_block(const int u) {
+    const int block = blocks[u - n_base_nodes];
+    for (int e = block; e < block + degrees[u - n_base_nodes]; e++) {
+      const int v = edge_targets[e];
+      prev_in[e] = -1;
+      next_in[e] = first_in[v];
+      if (first_in[v] != -1) {
+        prev_in[first_in[v]] = e;
+      }
+      first_in[v] = e;
+    }
+  }
+
+  void DynamicGraph::unlink_block(const int u) {
+    const int block = blocks[u - n_base_nodes];
+    for (int e = block; e < block + degrees[u - n_base_nodes]; e++) {
+      if (prev_in[e] != -1) {
+        next_in[prev_in[e]] = next_in[e];
+      } else {
+        first_in[edge_targets[e]] = next_in[e];
+      }
+      if (next_in[e] != -1) {
+        prev_in[next_in[e]] = prev_in[e];
+      }
+    }
+  }
+
+  void DynamicGraph::apply(const DynamicGraphLog::Change &change,
+                           const DynamicGraphLog &log,
+                           bool forward) {
+    switch (change.type) {
+    case DynamicGraphLog::ChangeType::CHANGE_COLOUR:
+      nodes[change.node] = forward ? change.new_colour : change.old_colour;
+      break;
+    case DynamicGraphLog::ChangeType::ADD_NODE:
+    case DynamicGraphLog::ChangeType::REMOVE_NODE:
+      if (forward == (change.type == DynamicGraphLog::ChangeType::ADD_NODE)) {
+        insert_node(change, log.edges.data() + change.edges_start);
+      } else {
+        erase_node(change);
+      }
+      break;
+    }
+  }
+
+  void DynamicGraph::undo(const DynamicGraphLog &log) {
+    for (auto it = log.changes.rbegin(); it != log.changes.rend(); it++) {
+      apply(*it, log, false);
+    }
+  }
+
+  void DynamicGraph::redo(const DynamicGraphLog &log) {
+    for (const auto &change : log.changes) {
+      apply(change, log, true);
+    }
+  }
+
+  std::shared_ptr<Graph> DynamicGraph::to_graph() const {
+    std::vector<int> new_index(nodes.size(), -1);
+    std::vector<int> node_colours;
+    for (size_t u = 0; u < nodes.size(); u++) {
+      if (!removed[u]) {
+        new_index[u] = node_colours.size();
+        node_colours.push_back(nodes[u]);
+      }
+    }
+    std::vector<std::vector<std::pair<int, int>>> new_edges;
+    for (size_t u = 0; u < nodes.size(); u++) {
+      if (!removed[u]) {
+        new_edges.emplace_back();
+        for_each_edge(u, [&](const int r, const int v) {
+          new_edges.back().push_back(std::make_pair(r, new_index[v]));
+        });
+      }
+    }
+    return std::make_shared<Graph>(node_colours, new_edges);
+  }
+}  // namespace wlplan::graph_generator
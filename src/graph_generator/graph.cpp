@@ -7,11 +7,26 @@ namespace wlplan::graph_generator {
                const std::vector<std::vector<std::pair<int, int>>> &edges)
       : nodes(node_colours),
         node_values(node_values),
-        edges(edges),
         store_node_names(true),
         index_to_node_(node_names) {
-    for (size_t u = 0; u < node_names.size(); u++) {
-      node_to_index_[node_names[u]] = u;
+    int n_nodes = nodes.size();
+    if ((int)edges.size() != n_nodes) {
+      throw std::runtime_error("Error: number of edge lists (" + std::to_string(edges.size()) +
+                               ") does not match number of nodes (" + std::to_string(n_nodes) +
+                               ")");
+    }
+
+    offsets = std::vector<int>(n_nodes + 1, 0);
+    for (int u = 0; u < n_nodes; u++) {
+      offsets[u + 1] = offsets[u] + edges[u].size();
+    }
+    edge_labels.reserve(offsets[n_nodes]);
+    neighbours.reserve(offsets[n_nodes]);
+    for (int u = 0; u < n_nodes; u++) {
+      for (const auto &[r, v] : edges[u]) {
+        edge_labels.push_back(r);
+        neighbours.push_back(v);
+      }
     }
   }
 
@@ -29,60 +44,28 @@ namespace wlplan::graph_generator {
                const std::vector<std::vector<std::pair<int, int>>> &edges)
       : Graph(node_colours, std::vector<double>(), edges) {}
 
-  Graph::Graph(bool store_node_names) : store_node_names(store_node_names) {}
-
-  int Graph::add_node(const std::string &node_name, int colour, double value) {
-    int index = nodes.size();
-    nodes.push_back(colour);
-    node_values.push_back(value);
-    if (store_node_names) {
-      node_to_index_[node_name] = index;
-      index_to_node_.push_back(node_name);
-    }
-    edges.push_back(std::vector<std::pair<int, int>>());
-    return index;
-  }
-
-  int Graph::add_node(const std::string &node_name, int colour) {
-    return add_node(node_name, colour, 0);
-  }
-
-  void Graph::add_edge(const int u, const int r, const int v) {
-    edges.at(u).push_back(std::make_pair(r, v));
-  }
-
-  void Graph::add_edge(const std::string &u_name, const int r, const std::string &v_name) {
-    if (!store_node_names) {
-      throw std::runtime_error("Error: cannot add edge by name as store_node_names is false");
-    }
-    add_edge(node_to_index_.at(u_name), r, node_to_index_.at(v_name));
-  }
+  Graph::Graph() : offsets({0}), store_node_names(false) {}
 
   void Graph::change_node_colour(const int u, const int new_colour) { nodes[u] = new_colour; }
 
-  void Graph::change_node_colour(const std::string &node_name, const int new_colour) {
-    if (!store_node_names) {
-      throw std::runtime_error(
-          "Error: cannot change node colour by name as store_node_names is false");
-    }
-    change_node_colour(node_to_index_.at(node_name), new_colour);
-  }
-
   void Graph::change_node_value(const int u, const double new_value) { node_values[u] = new_value; }
 
-  void Graph::change_node_value(const std::string &node_name, const double new_value) {
-    if (!store_node_names) {
-      throw std::runtime_error(
-          "Error: cannot change node value by name as store_node_names is false");
+  std::vector<std::vector<std::pair<int, int>>> Graph::get_edges() const {
+    std::vector<std::vector<std::pair<int, int>>> edges(nodes.size());
+    for (size_t u = 0; u < nodes.size(); u++) {
+      edges[u].reserve(get_degree(u));
+      for (int j = offsets[u]; j < offsets[u + 1]; j++) {
+        edges[u].push_back(std::make_pair(edge_labels[j], neighbours[j]));
+      }
     }
-    change_node_value(node_to_index_.at(node_name), new_value);
+    return edges;
   }
 
   std::vector<std::set<int>> Graph::get_node_to_neighbours() const {
     std::vector<std::set<int>> node_to_neighbours(nodes.size());
     for (size_t u = 0; u < nodes.size(); u++) {
-      for (size_t j = 0; j < edges[u].size(); j++) {
-        node_to_neighbours[u].insert(edges[u][j].second);
+      for (int j = offsets[u]; j < offsets[u + 1]; j++) {
+        node_to_neighbours[u].insert(neighbours[j]);
       }
     }
     return node_to_neighbours;
@@ -95,19 +78,9 @@ namespace wlplan::graph_generator {
     return index_to_node_.at(u);
   }
 
-  int Graph::get_node_index(const std::string &node_name) const {
-    return node_to_index_.at(node_name);
-  }
-
   int Graph::get_n_nodes() const { return nodes.size(); }
 
-  int Graph::get_n_edges() const {
-    int ret = 0;
-    for (size_t u = 0; u < nodes.size(); u++) {
-      ret += edges.at(u).size();
-    }
-    return ret;
-  }
+  int Graph::get_n_edges() const { return neighbours.size(); }
 
   std::set<int> Graph::get_nodes_set() const {
     std::set<int> ret;
@@ -135,8 +108,8 @@ namespace wlplan::graph_generator {
 
     std::cout << get_n_edges() << " edges" << std::endl;
     for (size_t u = 0; u < nodes.size(); u++) {
-      for (size_t j = 0; j < edges[u].size(); j++) {
-        std::cout << u << " " << edges[u][j].first << " " << edges[u][j].second << std::endl;
+      for (int j = offsets[u]; j < offsets[u + 1]; j++) {
+        std::cout << u << " " << edge_labels[j] << " " << neighbours[j] << std::endl;
       }
     }
   }
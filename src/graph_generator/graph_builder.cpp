@@ -0,0 +1,130 @@
+#include "../../include/graph_generator/graph_builder.hpp"
+
+namespace wlplan::graph_generator {
+  GraphBuilder::GraphBuilder(bool store_node_names) : store_node_names(store_node_names) {}
+
+  GraphBuilder::GraphBuilder(const GraphBuilder &other, bool store_node_names)
+      : nodes(other.nodes),
+        node_values(other.node_values),
+        edge_sources(other.edge_sources),
+        edge_labels(other.edge_labels),
+        edge_targets(other.edge_targets),
+        store_node_names(store_node_names) {
+    if (store_node_names) {
+      node_to_index_ = other.node_to_index_;
+      index_to_node_ = other.index_to_node_;
+    }
+  }
+
+  int GraphBuilder::add_node(const std::string &node_name, int colour, double value) {
+    int index = nodes.size();
+    nodes.push_back(colour);
+    node_values.push_back(value);
+    if (store_node_names) {
+      node_to_index_[node_name] = index;
+      index_to_node_.push_back(node_name);
+    }
+    return index;
+  }
+
+  int GraphBuilder::add_node(const std::string &node_name, int colour) {
+    return add_node(node_name, colour, 0);
+  }
+
+  void GraphBuilder::add_edge(const int u, const int r, const int v) {
+    edge_sources.push_back(u);
+    edge_labels.push_back(r);
+    edge_targets.push_back(v);
+  }
+
+  void GraphBuilder::add_edge(const std::string &u_name, const int r, const std::string &v_name) {
+    if (!store_node_names) {
+      throw std::runtime_error("Error: cannot add edge by name as store_node_names is false");
+    }
+    add_edge(node_to_index_.at(u_name), r, node_to_index_.at(v_name));
+  }
+
+  void GraphBuilder::change_node_colour(const int u, const int new_colour) {
+    nodes[u] = new_colour;
+  }
+
+  void GraphBuilder::change_node_colour(const std::string &node_name, const int new_colour) {
+    if (!store_node_names) {
+      throw std::runtime_error(
+          "Error: cannot change node colour by name as store_node_names is false");
+    }
+    change_node_colour(node_to_index_.at(node_name), new_colour);
+  }
+
+  void GraphBuilder::change_node_value(const int u, const double new_value) {
+    node_values[u] = new_value;
+  }
+
+  void GraphBuilder::change_node_value(const std::string &node_name, const double new_value) {
+    if (!store_node_names) {
+      throw std::runtime_error(
+          "Error: cannot change node value by name as store_node_names is false");
+    }
+    change_node_value(node_to_index_.at(node_name), new_value);
+  }
+
+  int GraphBuilder::get_node_index(const std::string &node_name) const {
+    return node_to_index_.at(node_name);
+  }
+
+  void GraphBuilder::truncate(const int n_nodes, const int n_edges) {
+    nodes.resize(n_nodes);
+    node_values.resize(n_nodes);
+    edge_sources.resize(n_edges);
+    edge_labels.resize(n_edges);
+    edge_targets.resize(n_edges);
+    for (int u = (int)index_to_node_.size() - 1; u >= n_nodes; u--) {
+      node_to_index_.erase(index_to_node_[u]);
+    }
+    if ((int)index_to_node_.size() > n_nodes) {
+      index_to_node_.resize(n_nodes);
+    }
+  }
+
+  std::shared_ptr<Graph> GraphBuilder::to_graph() const {
+    std::shared_ptr<Graph> graph = std::make_shared<Graph>();
+    to_graph(*graph);
+    return graph;
+  }
+
+  void GraphBuilder::to_graph(Graph &graph) const {
+    int n_nodes = nodes.size();
+    int n_edges = edge_sources.size();
+
+    graph.nodes.assign(nodes.begin(), nodes.end());
+    graph.node_values.assign(node_values.begin(), node_values.end());
+    graph.store_node_names = store_node_names && (int)index_to_node_.size() == n_nodes;
+    if (graph.store_node_names) {
+      graph.index_to_node_.assign(index_to_node_.begin(), index_to_node_.end());
+    } else {
+      graph.index_to_node_.clear();
+    }
+
+    // counting sort of edges by source node, which keeps insertion order within each node
+    graph.offsets.assign(n_nodes + 1, 0);
+    for (int j = 0; j < n_edges; j++) {
+      graph.offsets[edge_sources[j] + 1]++;
+    }
+    for (int u = 0; u < n_nodes; u++) {
+      graph.offsets[u + 1] += graph.offsets[u];
+    }
+
+    // offsets[u] is used as the insertion position of u and ends up as the start of u + 1
+    graph.edge_labels.resize(n_edges);
+    graph.neighbours.resize(n_edges);
+    for (int j = 0; j < n_edges; j++) {
+      int pos = graph.offsets[edge_sources[j]]++;
+      graph.edge_labels[pos] = edge_labels[j];
+      graph.neighbours[pos] = edge_targets[j];
+    }
+    for (int u = n_nodes; u > 0; u--) {
+      graph.offsets[u] = graph.offsets[u - 1];
+    }
+    graph.offsets[0] = 0;
+  }
+}  // namespace wlplan::graph_generator
@@ -8,7 +8,8 @@ namespace wlplan::graph_generator {
                                  const std::string &graph_generator_name)
       : domain(domain),
         differentiate_constant_objects(differentiate_constant_objects),
-        graph_generator_name(graph_generator_name) {
+        graph_generator_name(graph_generator_name),
+        opt_graph(std::make_shared<Graph>()) {
     /* We assume all graphs have object nodes */
 
     // add constant object colours
@@ -34,7 +35,40 @@ namespace wlplan::graph_generator {
     return to_graph(state, action_pointers);
   }
 
-  std::vector<Graph> GraphGenerator::to_graphs(const data::DomainDataset dataset) {
+  std::shared_ptr<Graph> GraphGenerator::to_graph_opt(const planning::State &state,
+                                                      const planning::ActionPointers &actions) {
+    (void)actions;
+    return to_graph_opt(state);
+  }
+
+  std::shared_ptr<Graph> GraphGenerator::to_graph(const planning::State &state,
+                                                  GraphOverlay &overlay) {
+    (void)overlay;
+    return to_graph(state);
+  }
+
+  std::shared_ptr<Graph> GraphGenerator::to_graph(const planning::InternedState &state) {
+    return to_graph(problem->get_state(state));
+  }
+
+  std::shared_ptr<DynamicGraph>
+  GraphGenerator::to_dynamic_graph(const planning::State &state) const {
+    (void)state;
+    throw NotSupportedError(graph_generator_name + ".to_dynamic_graph(state)");
+  }
+
+  std::vector<int>
+  GraphGenerator::apply_transition(DynamicGraph &graph,
+                                   const std::vector<planning::Atom> &add_atoms,
+                                   const std::vector<planning::Atom> &del_atoms) const {
+    (void)graph;
+    (void)add_atoms;
+    (void)del_atoms;
+    throw NotSupportedError(graph_generator_name +
+                            ".apply_transition(graph, add_atoms, del_atoms)");
+  }
+
+  std::vector<Graph> GraphGenerator::to_graphs(const data::DomainDataset &dataset) {
     std::vector<Graph> graphs;
 
     const std::vector<data::ProblemDataset> &data = dataset.data;
@@ -45,11 +79,7 @@ namespace wlplan::graph_generator {
       const auto &actions = d.actions;
       set_problem(problem);
       for (size_t j = 0; j < states.size(); j++) {
-        planning::ActionPointers action_pointers;
-        for (const auto &action : actions.at(j)) {
-          action_pointers.push_back(std::make_shared<planning::Action>(action));
-        }
-        graphs.push_back(*(to_graph(states.at(j), action_pointers)));
+        graphs.push_back(*(to_graph(states.at(j), actions.at(j))));
       }
     }
 
@@ -25,36 +25,63 @@ namespace wlplan::graph_generator {
     return ILGGenerator::to_graph(state);
   }
 
-  std::shared_ptr<Graph> AOAGGenerator::to_graph(const planning::State &state,
-                                                 const planning::ActionPointers &actions) {
-    std::shared_ptr<Graph> graph = ILGGenerator::to_graph(state);
+  static const planning::Action &get_action(const planning::Action &action) { return action; }
+
+  static const planning::Action &get_action(const std::shared_ptr<planning::Action> &action) {
+    return *action;
+  }
 
+  template <typename A>
+  void AOAGGenerator::add_actions(GraphBuilder &graph, const A &actions) const {
     int action_node, object_node;
-    std::string action_node_str, schema_name;
+    std::string action_node_str;
 
-    for (const auto &action : actions) {
-      // add node
-      action_node_str = action->to_string();
-      schema_name = action->schema->name;
-      action_node = graph->add_node(action_node_str, schema_to_graph_colour.at(schema_name));
+    for (const auto &action_or_pointer : actions) {
+      const planning::Action &action = get_action(action_or_pointer);
+
+      // add node, where names are skipped when modifying the base graph
+      if (graph.get_store_node_names()) {
+        action_node_str = action.to_string();
+      }
+      action_node =
+          graph.add_node(action_node_str, schema_to_graph_colour.at(action.schema->name));
 
       // add edges
-      for (size_t r = 0; r < action->objects.size(); r++) {
-        object_node = graph->get_node_index(action->objects[r].to_string());
-        graph->add_edge(action_node, r, object_node);
-        graph->add_edge(object_node, r, action_node);
+      for (size_t r = 0; r < action.objects.size(); r++) {
+        object_node = problem->get_object_id(action.objects[r]);
+        graph.add_edge(action_node, r, object_node);
+        graph.add_edge(object_node, r, action_node);
       }
     }
+  }
 
-    return graph;
+  std::shared_ptr<Graph> AOAGGenerator::to_graph(const planning::State &state,
+                                                 const planning::ActionPointers &actions) {
+    std::shared_ptr<GraphBuilder> graph = std::make_shared<GraphBuilder>(*base_graph);
+    graph = modify_graph_from_state(state, graph, false);
+    add_actions(*graph, actions);
+    return graph->to_graph();
   }
 
-  std::shared_ptr<Graph> AOAGGenerator::to_graph_opt(const planning::State &state) {
-    (void)state;
-    throw NotSupportedError("AOAGGenerator.to_graph_opt(state)");
+  std::shared_ptr<Graph> AOAGGenerator::to_graph(const planning::State &state,
+                                                 const planning::Actions &actions) {
+    std::shared_ptr<GraphBuilder> graph = std::make_shared<GraphBuilder>(*base_graph);
+    graph = modify_graph_from_state(state, graph, false);
+    add_actions(*graph, actions);
+    return graph->to_graph();
   }
 
-  void AOAGGenerator::reset_graph() const {
-    throw NotImplementedError("AOAGGenerator.reset_graph()");
+  std::shared_ptr<Graph> AOAGGenerator::to_graph_opt(const planning::State &state,
+                                                     const planning::ActionPointers &actions) {
+    base_graph = modify_graph_from_state(state, base_graph, true);
+    add_actions(*base_graph, actions);
+    base_graph->to_graph(*opt_graph);
+    return opt_graph;
+  }
+
+  std::shared_ptr<DynamicGraph>
+  AOAGGenerator::to_dynamic_graph(const planning::State &state) const {
+    (void)state;
+    throw NotSupportedError("AOAGGenerator.to_dynamic_graph(state)");
   }
 }  // namespace wlplan::graph_generator
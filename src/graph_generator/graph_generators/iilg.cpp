@@ -5,7 +5,7 @@ namespace wlplan::graph_generator {
 
   void IILGGenerator::set_problem(const planning::Problem &problem) {
     ILGGenerator::set_problem(problem);
-    Graph graph = *base_graph;
+    GraphBuilder graph = *base_graph;
 
     for (const auto &object : problem.get_constant_objects()) {
       obj_to_colour[object] = -obj_to_colour.size();
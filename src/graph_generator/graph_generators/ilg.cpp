@@ -25,9 +25,8 @@ namespace wlplan::graph_generator {
 
   void ILGGenerator::set_problem(const planning::Problem &problem) {
     // reset graph and variables
-    Graph graph = Graph(/*store_node_names=*/true);
-    positive_goal_names = std::unordered_set<std::string>();
-    negative_goal_names = std::unordered_set<std::string>();
+    GraphBuilder graph = GraphBuilder(/*store_node_names=*/true);
+    std::map<planning::AtomId, int> goal_nodes;
     this->problem = std::make_shared<planning::Problem>(problem);
 
     /* add nodes */
@@ -55,15 +54,14 @@ namespace wlplan::graph_generator {
     for (const auto &atom : problem.get_positive_goals()) {
       std::string node = atom.to_string();
       colour = fact_colour(atom, ILGFactDescription::F_POS_GOAL);
-      graph.add_node(node, colour);
-      positive_goal_names.insert(node);
+      goal_nodes[problem.get_atom_id(atom)] = graph.add_node(node, colour);
     }
 
+    first_neg_goal_node = graph.get_n_nodes();
     for (const auto &atom : problem.get_negative_goals()) {
       std::string node = atom.to_string();
       colour = fact_colour(atom, ILGFactDescription::F_NEG_GOAL);
-      graph.add_node(node, colour);
-      negative_goal_names.insert(node);
+      goal_nodes[problem.get_atom_id(atom)] = graph.add_node(node, colour);
     }
 
     /* add edges */
@@ -78,63 +76,113 @@ namespace wlplan::graph_generator {
       }
     }
 
+    /* goal lookup tables */
+    dense_goal_table = this->problem->get_n_atom_ids() <= MAX_DENSE_GOAL_TABLE;
+    goal_node_table = std::vector<int>();
+    sorted_goal_ids = std::vector<planning::AtomId>();
+    sorted_goal_nodes = std::vector<int>();
+    if (dense_goal_table) {
+      goal_node_table.assign(this->problem->get_n_atom_ids(), -1);
+    }
+    for (const auto &[atom_id, node] : goal_nodes) {
+      if (dense_goal_table) {
+        goal_node_table[atom_id] = node;
+      } else {
+        sorted_goal_ids.push_back(atom_id);
+        sorted_goal_nodes.push_back(node);
+      }
+    }
+
     /* set pointer */
-    base_graph = std::make_shared<Graph>(graph);
-    n_edges_added = std::vector<int>(base_graph->nodes.size(), 0);
+    base_graph = std::make_shared<GraphBuilder>(graph);
+    dynamic_base_graph = base_graph->to_graph();
   }
 
-  std::shared_ptr<Graph> ILGGenerator::modify_graph_from_state(const planning::State &state,
-                                                               const std::shared_ptr<Graph> graph,
-                                                               bool store_changes) {
+  void ILGGenerator::start_changes(GraphBuilder &graph, bool store_changes) {
     if (store_changes) {
-      n_nodes_added = 0;
-      std::fill(n_edges_added.begin(), n_edges_added.end(), 0);
+      n_base_nodes = graph.get_n_nodes();
+      n_base_edges = graph.get_n_edges();
       pos_goal_changed = std::vector<int>();
       neg_goal_changed = std::vector<int>();
       pos_goal_changed_pred = std::vector<int>();
       neg_goal_changed_pred = std::vector<int>();
-      graph->set_store_node_names(false);
+      graph.set_store_node_names(false);
     }
+  }
 
-    int atom_node, object_node, pred_idx;
-    std::string atom_node_str;
+  template <typename G>
+  void ILGGenerator::add_atom(G &graph,
+                              const planning::AtomId atom_id,
+                              const std::string &atom_name,
+                              bool store_changes,
+                              std::vector<int> &object_ids) {
+    int pred_idx = problem->get_atom_predicate(atom_id);
+    int goal_node = get_goal_node(atom_id);
+    if (goal_node >= first_neg_goal_node) {
+      graph.change_node_colour(goal_node, fact_colour(pred_idx, ILGFactDescription::T_NEG_GOAL));
+      if (store_changes) {
+        neg_goal_changed.push_back(goal_node);
+        neg_goal_changed_pred.push_back(pred_idx);
+      }
+      return;
+    } else if (goal_node >= 0) {
+      graph.change_node_colour(goal_node, fact_colour(pred_idx, ILGFactDescription::T_POS_GOAL));
+      if (store_changes) {
+        pos_goal_changed.push_back(goal_node);
+        pos_goal_changed_pred.push_back(pred_idx);
+      }
+      return;
+    }
+
+    int atom_node = graph.add_node(atom_name, fact_colour(pred_idx, ILGFactDescription::NON_GOAL));
+    problem->get_atom_object_ids(atom_id, object_ids);
+    for (size_t r = 0; r < object_ids.size(); r++) {
+      // object nodes should never be needed to be added
+      graph.add_edge(atom_node, r, object_ids[r]);
+      graph.add_edge(object_ids[r], r, atom_node);
+    }
+  }
 
+  std::shared_ptr<GraphBuilder>
+  ILGGenerator::modify_graph_from_state(const planning::State &state,
+                                        const std::shared_ptr<GraphBuilder> graph,
+                                        bool store_changes) {
+    start_changes(*graph, store_changes);
+    std::vector<int> object_ids;
+    const std::string no_name;
     for (const auto &atom : state.atoms) {
-      atom_node_str = atom->to_string();
-      pred_idx = domain.predicate_to_colour.at(atom->predicate->name);
-      if (positive_goal_names.count(atom_node_str)) {
-        atom_node = graph->get_node_index(atom_node_str);
-        graph->change_node_colour(atom_node, fact_colour(pred_idx, ILGFactDescription::T_POS_GOAL));
-        if (store_changes) {
-          pos_goal_changed.push_back(atom_node);
-          pos_goal_changed_pred.push_back(pred_idx);
-        }
-      } else if (negative_goal_names.count(atom_node_str)) {
-        atom_node = graph->get_node_index(atom_node_str);
-        graph->change_node_colour(atom_node, fact_colour(pred_idx, ILGFactDescription::T_NEG_GOAL));
-        if (store_changes) {
-          neg_goal_changed.push_back(atom_node);
-          neg_goal_changed_pred.push_back(pred_idx);
-        }
-      } else {
-        atom_node =
-            graph->add_node(atom_node_str, fact_colour(pred_idx, ILGFactDescription::NON_GOAL));
-        if (store_changes) {
-          n_nodes_added++;
-        }
+      add_atom(*graph,
+               problem->get_atom_id(*atom),
+               graph->get_store_node_names() ? atom->to_string() : no_name,
+               store_changes,
+               object_ids);
+    }
+    return graph;
+  }
 
-        for (size_t r = 0; r < atom->objects.size(); r++) {
-          // object nodes should never be needed to be added
-          object_node = graph->get_node_index(atom->objects[r].to_string());
-          graph->add_edge(atom_node, r, object_node);
-          graph->add_edge(object_node, r, atom_node);
-          if (store_changes) {
-            n_edges_added[object_node]++;
-          }
-        }
-      }
+  void ILGGenerator::modify_graph_from_state(const planning::State &state,
+                                             GraphOverlay &overlay) {
+    std::vector<int> object_ids;
+    const std::string no_name;
+    for (const auto &atom : state.atoms) {
+      add_atom(overlay, problem->get_atom_id(*atom), no_name, false, object_ids);
     }
+  }
 
+  std::shared_ptr<GraphBuilder>
+  ILGGenerator::modify_graph_from_state(const planning::InternedState &state,
+                                        const std::shared_ptr<GraphBuilder> graph,
+                                        bool store_changes) {
+    start_changes(*graph, store_changes);
+    std::vector<int> object_ids;
+    const std::string no_name;
+    for (const planning::AtomId atom_id : state.atom_ids) {
+      add_atom(*graph,
+               atom_id,
+               graph->get_store_node_names() ? problem->get_atom(atom_id).to_string() : no_name,
+               store_changes,
+               object_ids);
+    }
     return graph;
   }
 
@@ -145,30 +193,35 @@ namespace wlplan::graph_generator {
           fact_colour(pos_goal_changed_pred[i], ILGFactDescription::F_POS_GOAL));
     }
 
-    for (const auto &node : neg_goal_changed) {
+    for (size_t i = 0; i < neg_goal_changed.size(); i++) {
       base_graph->change_node_colour(
-          node, fact_colour(neg_goal_changed_pred[node], ILGFactDescription::F_NEG_GOAL));
+          neg_goal_changed[i],
+          fact_colour(neg_goal_changed_pred[i], ILGFactDescription::F_NEG_GOAL));
     }
 
-    for (int i = 0; i < n_nodes_added; i++) {
-      base_graph->nodes.pop_back();
-    }
+    // added atom nodes and their edges all come after the base graph nodes and edges
+    base_graph->truncate(n_base_nodes, n_base_edges);
+    base_graph->set_store_node_names(true);
+  }
 
-    for (int i = 0; i < n_nodes_added; i++) {
-      base_graph->edges.pop_back();
-    }
+  std::shared_ptr<Graph> ILGGenerator::to_graph(const planning::State &state) {
+    std::shared_ptr<GraphBuilder> graph = std::make_shared<GraphBuilder>(*base_graph);
+    graph = modify_graph_from_state(state, graph, false);
+    return graph->to_graph();
+  }
 
-    for (size_t i = 0; i < base_graph->nodes.size(); i++) {
-      for (int j = 0; j < n_edges_added[i]; j++) {
-        base_graph->edges[i].pop_back();
-      }
-    }
+  std::shared_ptr<Graph> ILGGenerator::to_graph(const planning::State &state,
+                                                GraphOverlay &overlay) {
+    overlay.reset(*base_graph);
+    modify_graph_from_state(state, overlay);
+    return overlay.to_graph();
   }
 
-  std::shared_ptr<Graph> ILGGenerator::to_graph(const planning::State &state) {
-    std::shared_ptr<Graph> graph = std::make_shared<Graph>(*base_graph);
+  std::shared_ptr<Graph> ILGGenerator::to_graph(const planning::InternedState &state) {
+    // node names are not copied as they are only needed for debugging
+    auto graph = std::make_shared<GraphBuilder>(*base_graph, /*store_node_names=*/false);
     graph = modify_graph_from_state(state, graph, false);
-    return graph;
+    return graph->to_graph();
   }
 
   std::shared_ptr<Graph> ILGGenerator::to_graph(const planning::State &state,
@@ -180,6 +233,78 @@ namespace wlplan::graph_generator {
 
   std::shared_ptr<Graph> ILGGenerator::to_graph_opt(const planning::State &state) {
     base_graph = modify_graph_from_state(state, base_graph, true);
-    return base_graph;
+    base_graph->to_graph(*opt_graph);
+    return opt_graph;
+  }
+
+  std::shared_ptr<DynamicGraph>
+  ILGGenerator::to_dynamic_graph(const planning::State &state) const {
+    auto graph = std::make_shared<DynamicGraph>(dynamic_base_graph);
+    apply_transition(*graph, state.get_atoms(), std::vector<planning::Atom>());
+    return graph;
+  }
+
+  std::vector<int>
+  ILGGenerator::apply_transition(DynamicGraph &graph,
+                                 const std::vector<planning::Atom> &add_atoms,
+                                 const std::vector<planning::Atom> &del_atoms) const {
+    std::vector<int> changed;
+    std::vector<int> object_ids;
+    std::vector<std::pair<int, int>> edges;
+    planning::AtomId atom_id;
+    int atom_node, goal_node, pred_idx;
+
+    // goal atoms only change colour, and other atoms are nodes keyed by their atom id that are
+    // connected to their objects, whose nodes are their object ids. Deleting an atom that is false
+    // or adding an atom that is true changes nothing, so that transitions can be given as the
+    // delete and add effects of an action.
+    for (const auto &atom : del_atoms) {
+      atom_id = problem->get_atom_id(atom);
+      pred_idx = problem->get_atom_predicate(atom_id);
+      goal_node = get_goal_node(atom_id);
+      if (goal_node >= 0) {
+        const int new_colour =
+            fact_colour(pred_idx,
+                        goal_node >= first_neg_goal_node ? ILGFactDescription::F_NEG_GOAL
+                                                         : ILGFactDescription::F_POS_GOAL);
+        if (graph.get_node_colour(goal_node) != new_colour) {
+          graph.change_node_colour(goal_node, new_colour);
+          changed.push_back(goal_node);
+        }
+      } else if ((atom_node = graph.get_node_index(atom_id)) != -1) {
+        changed.push_back(atom_node);
+        for (const int object_node : graph.remove_node(atom_id)) {
+          changed.push_back(object_node);
+        }
+      }
+    }
+
+    for (const auto &atom : add_atoms) {
+      atom_id = problem->get_atom_id(atom);
+      pred_idx = problem->get_atom_predicate(atom_id);
+      goal_node = get_goal_node(atom_id);
+      if (goal_node >= 0) {
+        const int new_colour =
+            fact_colour(pred_idx,
+                        goal_node >= first_neg_goal_node ? ILGFactDescription::T_NEG_GOAL
+                                                         : ILGFactDescription::T_POS_GOAL);
+        if (graph.get_node_colour(goal_node) != new_colour) {
+          graph.change_node_colour(goal_node, new_colour);
+          changed.push_back(goal_node);
+        }
+      } else if (graph.get_node_index(atom_id) == -1) {
+        problem->get_atom_object_ids(atom_id, object_ids);
+        edges.clear();
+        for (size_t r = 0; r < object_ids.size(); r++) {
+          edges.push_back(std::make_pair(r, object_ids[r]));
+          changed.push_back(object_ids[r]);
+        }
+        atom_node =
+            graph.add_node(atom_id, fact_colour(pred_idx, ILGFactDescription::NON_GOAL), edges);
+        changed.push_back(atom_node);
+      }
+    }
+
+    return changed;
   }
 }  // namespace wlplan::graph_generator
@@ -1,5 +1,7 @@
 #include "../../../include/graph_generator/graph_generators/nilg.hpp"
 
+#include "../../../include/utils/exceptions.hpp"
+
 namespace wlplan::graph_generator {
   NILGGenerator::NILGGenerator(const planning::Domain &domain, bool differentiate_constant_objects)
       : ILGGenerator(domain, differentiate_constant_objects) {
@@ -29,7 +31,9 @@ namespace wlplan::graph_generator {
 
   void NILGGenerator::set_problem(const planning::Problem &problem) {
     ILGGenerator::set_problem(problem);
-    Graph graph = *base_graph;
+    GraphBuilder graph = *base_graph;
+    fluent_nodes = std::vector<int>();
+    numeric_goal_nodes = std::vector<int>();
 
     // add fluents
     std::vector<planning::Fluent> fluents = problem.get_fluents();
@@ -39,7 +43,7 @@ namespace wlplan::graph_generator {
       planning::Fluent fluent = fluents[i];
       std::string fluent_node = fluent.to_string();
       int colour = fluent_to_colour[fluent.function->name];
-      graph.add_node(fluent_node, colour, fluent_values[i]);
+      fluent_nodes.push_back(graph.add_node(fluent_node, colour, fluent_values[i]));
 
       // add edges
       for (size_t r = 0; r < fluent.objects.size(); r++) {
@@ -59,7 +63,7 @@ namespace wlplan::graph_generator {
       // not matter what we initialise it to.
       int colour = 0;
       double value = 0;
-      graph.add_node(goal_node, colour, value);
+      numeric_goal_nodes.push_back(graph.add_node(goal_node, colour, value));
 
       // add edges
       for (int fluent_id : goal.get_fluent_ids()) {
@@ -70,29 +74,23 @@ namespace wlplan::graph_generator {
     }
 
     // set pointer
-    base_graph = std::make_shared<Graph>(graph);
-    n_edges_added = std::vector<int>(base_graph->nodes.size(), 0);
+    base_graph = std::make_shared<GraphBuilder>(graph);
   }
 
-  std::shared_ptr<Graph>
-  NILGGenerator::modify_graph_from_numerics(const planning::State &state,
-                                            const std::shared_ptr<Graph> graph) {
-    std::vector<planning::Fluent> fluents = problem->get_fluents();
-    std::vector<double> fluent_values = state.values;
-    for (size_t i = 0; i < fluents.size(); i++) {
-      std::string fluent_node = fluents[i].to_string();
-      int fluent_node_i = graph->get_node_index(fluent_node);
-      graph->change_node_value(fluent_node_i, fluent_values[i]);
+  template <typename G>
+  void NILGGenerator::set_numeric_nodes(const std::vector<double> &fluent_values,
+                                        G &graph) const {
+    for (size_t i = 0; i < fluent_nodes.size(); i++) {
+      graph.change_node_value(fluent_nodes[i], fluent_values[i]);
     }
 
     std::pair<bool, double> goal_eval;
     std::vector<planning::NumericCondition> num_goals = problem->get_numeric_goals();
     int goal_colour, goal_node_i;
     for (size_t i = 0; i < num_goals.size(); i++) {
-      std::string goal_node = "_numeric_goal_" + std::to_string(i);
-      goal_node_i = graph->get_node_index(goal_node);
-      goal_eval = num_goals[i].evaluate_formula_and_error(state.values);
-      graph->change_node_value(goal_node_i, goal_eval.second);
+      goal_node_i = numeric_goal_nodes[i];
+      goal_eval = num_goals[i].evaluate_formula_and_error(fluent_values);
+      graph.change_node_value(goal_node_i, goal_eval.second);
 
       switch (num_goals[i].get_comparator_type()) {
       case planning::ComparatorType::GreaterThan:
@@ -105,21 +103,50 @@ namespace wlplan::graph_generator {
         goal_colour = goal_eval.first ? ACHIEVED_EQ_GOAL : UNACHIEVED_EQ_GOAL;
         break;
       }
-      graph->change_node_colour(goal_node_i, goal_colour);
+      graph.change_node_colour(goal_node_i, goal_colour);
     }
+  }
 
+  std::shared_ptr<GraphBuilder>
+  NILGGenerator::modify_graph_from_numerics(const std::vector<double> &fluent_values,
+                                            const std::shared_ptr<GraphBuilder> graph) {
+    set_numeric_nodes(fluent_values, *graph);
     return graph;
   }
 
   std::shared_ptr<Graph> NILGGenerator::to_graph(const planning::State &state) {
-    std::shared_ptr<Graph> graph = ILGGenerator::to_graph(state);
-    graph = modify_graph_from_numerics(state, graph);
-    return graph;
+    std::shared_ptr<GraphBuilder> graph = std::make_shared<GraphBuilder>(*base_graph);
+    graph = modify_graph_from_state(state, graph, false);
+    graph = modify_graph_from_numerics(state.values, graph);
+    return graph->to_graph();
+  }
+
+  std::shared_ptr<Graph> NILGGenerator::to_graph(const planning::State &state,
+                                                 GraphOverlay &overlay) {
+    overlay.reset(*base_graph);
+    modify_graph_from_state(state, overlay);
+    set_numeric_nodes(state.values, overlay);
+    return overlay.to_graph();
+  }
+
+  std::shared_ptr<Graph> NILGGenerator::to_graph(const planning::InternedState &state) {
+    auto graph = std::make_shared<GraphBuilder>(*base_graph, /*store_node_names=*/false);
+    graph = modify_graph_from_state(state, graph, false);
+    graph = modify_graph_from_numerics(state.values, graph);
+    return graph->to_graph();
   }
 
   std::shared_ptr<Graph> NILGGenerator::to_graph_opt(const planning::State &state) {
-    base_graph = ILGGenerator::to_graph_opt(state);
-    base_graph = modify_graph_from_numerics(state, base_graph);
-    return base_graph;
+    base_graph = modify_graph_from_state(state, base_graph, true);
+    base_graph = modify_graph_from_numerics(state.values, base_graph);
+    base_graph->to_graph(*opt_graph);
+    return opt_graph;
+  }
+
+  std::shared_ptr<DynamicGraph>
+  NILGGenerator::to_dynamic_graph(const planning::State &state) const {
+    // numeric values are not updated incrementally
+    (void)state;
+    throw NotSupportedError("NILGGenerator.to_dynamic_graph(state)");
   }
 }  // namespace wlplan::graph_generator
@@ -63,7 +63,7 @@ namespace wlplan::graph_generator {
       positive_goal_names.insert(atom.to_string());
     }
 
-    Graph graph = Graph(/*store_node_names=*/true);
+    GraphBuilder graph = GraphBuilder(/*store_node_names=*/true);
 
     /* add nodes */
     int colour;
@@ -87,12 +87,12 @@ namespace wlplan::graph_generator {
     }
 
     /* set pointer */
-    base_graph = std::make_shared<Graph>(graph);
+    base_graph = std::make_shared<GraphBuilder>(graph);
+    n_base_edges = base_graph->get_n_edges();
   }
 
-  std::shared_ptr<Graph>
-  PLOIGGenerator::modify_graph_from_state(const planning::State &state,
-                                          const std::shared_ptr<Graph> graph) {
+  template <typename G>
+  void PLOIGGenerator::add_state_edges(const planning::State &state, G &graph) const {
 
     /* add edges */
 
@@ -120,18 +120,18 @@ namespace wlplan::graph_generator {
       }
     }
 
-    // add obj <-> obj edges
+    // add obj <-> obj edges, where object nodes are numbered like object ids of the problem
     for (const auto &atom : ag) {
       std::string predicate = atom->predicate->name;
       std::vector<planning::Object> objects = atom->objects;
       int arity = (int)objects.size();
-      std::map<std::pair<int, int>, int> mapper = ag_to_e_col[predicate];
+      const std::map<std::pair<int, int>, int> &mapper = ag_to_e_col.at(predicate);
       for (int i = 0; i < arity; i++) {
         for (int j = i + 1; j < arity; j++) {
-          std::string object_node_i = objects[i].to_string();
-          std::string object_node_j = objects[j].to_string();
-          graph->add_edge(object_node_i, mapper[std::make_pair(i, j)], object_node_j);
-          graph->add_edge(object_node_j, mapper[std::make_pair(j, i)], object_node_i);
+          int object_node_i = problem->get_object_id(objects[i]);
+          int object_node_j = problem->get_object_id(objects[j]);
+          graph.add_edge(object_node_i, mapper.at(std::make_pair(i, j)), object_node_j);
+          graph.add_edge(object_node_j, mapper.at(std::make_pair(j, i)), object_node_i);
         }
       }
     }
@@ -140,13 +140,13 @@ namespace wlplan::graph_generator {
       std::string predicate = atom->predicate->name;
       std::vector<planning::Object> objects = atom->objects;
       int arity = (int)objects.size();
-      std::map<std::pair<int, int>, int> mapper = ug_to_e_col[predicate];
+      const std::map<std::pair<int, int>, int> &mapper = ug_to_e_col.at(predicate);
       for (int i = 0; i < arity; i++) {
         for (int j = i + 1; j < arity; j++) {
-          std::string object_node_i = objects[i].to_string();
-          std::string object_node_j = objects[j].to_string();
-          graph->add_edge(object_node_i, mapper[std::make_pair(i, j)], object_node_j);
-          graph->add_edge(object_node_j, mapper[std::make_pair(j, i)], object_node_i);
+          int object_node_i = problem->get_object_id(objects[i]);
+          int object_node_j = problem->get_object_id(objects[j]);
+          graph.add_edge(object_node_i, mapper.at(std::make_pair(i, j)), object_node_j);
+          graph.add_edge(object_node_j, mapper.at(std::make_pair(j, i)), object_node_i);
         }
       }
     }
@@ -155,31 +155,41 @@ namespace wlplan::graph_generator {
       std::string predicate = atom->predicate->name;
       std::vector<planning::Object> objects = atom->objects;
       int arity = (int)objects.size();
-      std::map<std::pair<int, int>, int> mapper = ap_to_e_col[predicate];
+      const std::map<std::pair<int, int>, int> &mapper = ap_to_e_col.at(predicate);
       for (int i = 0; i < arity; i++) {
         for (int j = i + 1; j < arity; j++) {
-          std::string object_node_i = objects[i].to_string();
-          std::string object_node_j = objects[j].to_string();
-          graph->add_edge(object_node_i, mapper[std::make_pair(i, j)], object_node_j);
-          graph->add_edge(object_node_j, mapper[std::make_pair(j, i)], object_node_i);
+          int object_node_i = problem->get_object_id(objects[i]);
+          int object_node_j = problem->get_object_id(objects[j]);
+          graph.add_edge(object_node_i, mapper.at(std::make_pair(i, j)), object_node_j);
+          graph.add_edge(object_node_j, mapper.at(std::make_pair(j, i)), object_node_i);
         }
       }
     }
+  }
 
+  std::shared_ptr<GraphBuilder>
+  PLOIGGenerator::modify_graph_from_state(const planning::State &state,
+                                          const std::shared_ptr<GraphBuilder> graph) {
+    add_state_edges(state, *graph);
     return graph;
   }
 
   void PLOIGGenerator::reset_graph() const {
-    // Delete all edges, keep nodes
-    for (size_t i = 0; i < base_graph->nodes.size(); i++) {
-      base_graph->edges[i].clear();
-    }
+    // states only add edges, which all come after the base graph edges
+    base_graph->truncate(base_graph->get_n_nodes(), n_base_edges);
   }
 
   std::shared_ptr<Graph> PLOIGGenerator::to_graph(const planning::State &state) {
-    std::shared_ptr<Graph> graph = std::make_shared<Graph>(*base_graph);
+    std::shared_ptr<GraphBuilder> graph = std::make_shared<GraphBuilder>(*base_graph);
     graph = modify_graph_from_state(state, graph);
-    return graph;
+    return graph->to_graph();
+  }
+
+  std::shared_ptr<Graph> PLOIGGenerator::to_graph(const planning::State &state,
+                                                  GraphOverlay &overlay) {
+    overlay.reset(*base_graph);
+    add_state_edges(state, overlay);
+    return overlay.to_graph();
   }
 
   std::shared_ptr<Graph> PLOIGGenerator::to_graph(const planning::State &state,
@@ -190,8 +200,10 @@ namespace wlplan::graph_generator {
   }
 
   std::shared_ptr<Graph> PLOIGGenerator::to_graph_opt(const planning::State &state) {
+    n_base_edges = base_graph->get_n_edges();
     base_graph = modify_graph_from_state(state, base_graph);
-    return base_graph;
+    base_graph->to_graph(*opt_graph);
+    return opt_graph;
   }
 
 }  // namespace wlplan::graph_generator
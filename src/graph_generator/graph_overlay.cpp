@@ -0,0 +1,74 @@
+#include "../../include/graph_generator/graph_overlay.hpp"
+
+namespace wlplan::graph_generator {
+  GraphOverlay::GraphOverlay() : base(nullptr), graph(std::make_shared<Graph>()) {}
+
+  void GraphOverlay::reset(const GraphBuilder &base) {
+    this->base = &base;
+    nodes.assign(base.nodes.begin(), base.nodes.end());
+    node_values.assign(base.node_values.begin(), base.node_values.end());
+    edge_sources.clear();
+    edge_labels.clear();
+    edge_targets.clear();
+  }
+
+  int GraphOverlay::add_node(const std::string &node_name, int colour, double value) {
+    (void)node_name;
+    int index = nodes.size();
+    nodes.push_back(colour);
+    node_values.push_back(value);
+    return index;
+  }
+
+  int GraphOverlay::add_node(const std::string &node_name, int colour) {
+    return add_node(node_name, colour, 0);
+  }
+
+  void GraphOverlay::add_edge(const int u, const int r, const int v) {
+    edge_sources.push_back(u);
+    edge_labels.push_back(r);
+    edge_targets.push_back(v);
+  }
+
+  std::shared_ptr<Graph> GraphOverlay::to_graph() {
+    int n_nodes = nodes.size();
+    int n_base_edges = base->edge_sources.size();
+    int n_edges = n_base_edges + edge_sources.size();
+
+    graph->nodes.assign(nodes.begin(), nodes.end());
+    graph->node_values.assign(node_values.begin(), node_values.end());
+    graph->store_node_names = false;
+    graph->index_to_node_.clear();
+
+    // same counting sort as GraphBuilder::to_graph() with base edges before added edges, so the
+    // result equals that of a modified copy of the base graph
+    graph->offsets.assign(n_nodes + 1, 0);
+    for (int j = 0; j < n_base_edges; j++) {
+      graph->offsets[base->edge_sources[j] + 1]++;
+    }
+    for (const int u : edge_sources) {
+      graph->offsets[u + 1]++;
+    }
+    for (int u = 0; u < n_nodes; u++) {
+      graph->offsets[u + 1] += graph->offsets[u];
+    }
+
+    graph->edge_labels.resize(n_edges);
+    graph->neighbours.resize(n_edges);
+    for (int j = 0; j < n_base_edges; j++) {
+      int pos = graph->offsets[base->edge_sources[j]]++;
+      graph->edge_labels[pos] = base->edge_labels[j];
+      graph->neighbours[pos] = base->edge_targets[j];
+    }
+    for (size_t j = 0; j < edge_sources.size(); j++) {
+      int pos = graph->offsets[edge_sources[j]]++;
+      graph->edge_labels[pos] = edge_labels[j];
+      graph->neighbours[pos] = edge_targets[j];
+    }
+    for (int u = n_nodes; u > 0; u--) {
+      graph->offsets[u] = graph->offsets[u - 1];
+    }
+    graph->offsets[0] = 0;
+    return graph;
+  }
+}  // namespace wlplan::graph_generator
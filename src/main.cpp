@@ -1,12 +1,15 @@
 #include "../include/data/dataset.hpp"
+#include "../include/data/problem_source.hpp"
 #include "../include/feature_generator/feature_generators/ccwl.hpp"
 #include "../include/feature_generator/feature_generators/ccwla.hpp"
 #include "../include/feature_generator/feature_generators/iwl.hpp"
 #include "../include/feature_generator/feature_generators/kwl2.hpp"
 #include "../include/feature_generator/feature_generators/lwl2.hpp"
 #include "../include/feature_generator/feature_generators/niwl.hpp"
+#include "../include/feature_generator/feature_generators/slwl2.hpp"
 #include "../include/feature_generator/feature_generators/wl.hpp"
 #include "../include/feature_generator/features.hpp"
+#include "../include/feature_generator/maxsat.hpp"
 #include "../include/feature_generator/pruning_options.hpp"
 #include "../include/graph_generator/graph_generators/aoag.hpp"
 #include "../include/graph_generator/graph_generators/iilg.hpp"
@@ -27,6 +30,7 @@
 #include "../include/utils/exceptions.hpp"
 
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/typing.h>
@@ -37,6 +41,48 @@
 namespace py = pybind11;
 using namespace py::literals;
 
+// hands a vector over to a numpy array without copying its buffer
+template <typename T> py::array_t<T> vector_to_numpy(std::vector<T> &&vec) {
+  auto *owner = new std::vector<T>(std::move(vec));
+  py::capsule capsule(owner, [](void *p) { delete reinterpret_cast<std::vector<T> *>(p); });
+  return py::array_t<T>(owner->size(), owner->data(), capsule);
+}
+
+// returns ((data, indices, indptr), shape) for scipy.sparse.csr_matrix
+py::tuple csr_to_numpy(wlplan::feature_generator::CSRMatrix &&X) {
+  py::tuple buffers = py::make_tuple(vector_to_numpy(std::move(X.data)),
+                                     vector_to_numpy(std::move(X.indices)),
+                                     vector_to_numpy(std::move(X.indptr)));
+  return py::make_tuple(buffers, py::make_tuple(X.n_rows, X.n_cols));
+}
+
+using DenseMatrix = py::array_t<double, py::array::c_style>;
+
+void check_dense_matrix(const DenseMatrix &X) {
+  if (X.ndim() != 2) {
+    throw std::runtime_error("Expected a 2D array but got " + std::to_string(X.ndim()) + "D");
+  }
+}
+
+// lets problem sources be implemented in Python
+class PyProblemSource : public wlplan::data::ProblemSource {
+ public:
+  void reset() override { PYBIND11_OVERRIDE_PURE(void, wlplan::data::ProblemSource, reset, ); }
+
+  std::shared_ptr<const wlplan::data::ProblemDataset> next() override {
+    py::gil_scoped_acquire gil;
+    py::function override = py::get_override(this, "next");
+    if (!override) {
+      throw std::runtime_error("ProblemSource.next() is not implemented");
+    }
+    py::object problem_states = override();
+    if (problem_states.is_none()) {
+      return nullptr;
+    }
+    return problem_states.cast<std::shared_ptr<wlplan::data::ProblemDataset>>();
+  }
+};
+
 PYBIND11_MODULE(_wlplan, m) {
   m.doc() = "WLPlan: WL Features for PDDL Planning";
 
@@ -441,6 +487,17 @@ PYBIND11_MODULE(_wlplan, m) {
       .def_property_readonly("positive_goals", &wlplan::planning::Problem::get_positive_goals)
       .def_property_readonly("negative_goals", &wlplan::planning::Problem::get_negative_goals)
       .def_property_readonly("numeric_goals", &wlplan::planning::Problem::get_numeric_goals)
+      .def("get_n_objects", &wlplan::planning::Problem::get_n_objects)
+      .def("get_object_id", &wlplan::planning::Problem::get_object_id, "object"_a)
+      .def("get_object", &wlplan::planning::Problem::get_object, "object_id"_a)
+      .def("get_n_atom_ids", &wlplan::planning::Problem::get_n_atom_ids)
+      .def("get_atom_id",
+           py::overload_cast<const wlplan::planning::Atom &>(
+               &wlplan::planning::Problem::get_atom_id, py::const_),
+           "atom"_a)
+      .def("get_atom", &wlplan::planning::Problem::get_atom, "atom_id"_a)
+      .def("intern_state", &wlplan::planning::Problem::intern_state, "state"_a)
+      .def("get_state", &wlplan::planning::Problem::get_state, "state"_a)
       .def("__repr__", &wlplan::planning::Problem::to_string)
       .def("__eq__", &wlplan::planning::Problem::operator==)
       .def(py::pickle(&__getstate__<wlplan::planning::Problem>,
@@ -469,6 +526,29 @@ PYBIND11_MODULE(_wlplan, m) {
       .def(py::pickle(&__getstate__<wlplan::planning::State>,
                       &__setstate__<wlplan::planning::State>));
 
+  // InternedState
+  py::class_<wlplan::planning::InternedState>(planning_m,
+                                              "InternedState",
+                                              R"(State given by atom ids of its problem, see
+Problem.intern_state.
+
+Parameters
+----------
+    atom_ids : list[int]
+        List of atom ids, which are sorted on construction.
+
+    values : list[float], optional
+        List of values for fluents defined in the problem.
+)")
+      .def(py::init<const std::vector<wlplan::planning::AtomId> &>(), "atom_ids"_a)
+      .def(py::init<const std::vector<wlplan::planning::AtomId> &, const std::vector<double> &>(),
+           "atom_ids"_a,
+           "values"_a)
+      .def_readonly("atom_ids", &wlplan::planning::InternedState::atom_ids)
+      .def_readonly("values", &wlplan::planning::InternedState::values)
+      .def("__eq__", &::wlplan::planning::InternedState::operator==)
+      .def("__hash__", &::wlplan::planning::InternedState::hash);
+
   //////////////////////////////////////////////////////////////////////////////
   // Data
   //////////////////////////////////////////////////////////////////////////////
@@ -499,8 +579,9 @@ Parameters
                       &__setstate__<wlplan::data::DomainDataset>));
 
   // ProblemDataset
-  py::class_<wlplan::data::ProblemDataset>(data_m,
-                                           "ProblemDataset",
+  py::class_<wlplan::data::ProblemDataset, std::shared_ptr<wlplan::data::ProblemDataset>>(
+      data_m,
+      "ProblemDataset",
                                            R"(Stores a problem and training states for the problem.
 
 Upon initialisation, the problem and states are checked for consistency.
@@ -532,6 +613,22 @@ Parameters
       .def(py::pickle(&__getstate__<wlplan::data::ProblemDataset>,
                       &__setstate__<wlplan::data::ProblemDataset>));
 
+  // ProblemSource
+  py::class_<wlplan::data::ProblemSource, PyProblemSource>(
+      data_m,
+      "ProblemSource",
+      R"(Pull-style source of problems and their states, for datasets that are too large to be held
+in memory at once.
+
+Subclasses implement ``reset()``, which restarts from the first problem, and ``next()``, which
+returns the next ProblemDataset or None after the last one. Collection reads the source once and
+keeps the generated graphs, in memory or in the spill directory if one is set. Without a spill
+directory, all graphs and their colourings are held in memory, so memory grows with the number of
+states; call ``set_spill_directory`` on the feature generator to bound it.
+)")
+      .def(py::init<>())
+      .def("reset", &wlplan::data::ProblemSource::reset);
+
   //////////////////////////////////////////////////////////////////////////////
   // Graph
   //////////////////////////////////////////////////////////////////////////////
@@ -603,7 +700,7 @@ Methods
            "edges"_a)
       .def_readonly("node_colours", &wlplan::graph_generator::Graph::nodes)
       .def_readonly("node_values", &wlplan::graph_generator::Graph::node_values)
-      .def_readonly("edges", &wlplan::graph_generator::Graph::edges)
+      .def_property_readonly("edges", &wlplan::graph_generator::Graph::get_edges)
       .def("get_node_name", &wlplan::graph_generator::Graph::get_node_name, "u"_a)
       .def("dump", &wlplan::graph_generator::Graph::dump)
       .def("__repr__", &::wlplan::graph_generator::Graph::to_string);
@@ -624,7 +721,32 @@ Methods
            py::overload_cast<const wlplan::planning::State &, const wlplan::planning::Actions &>(
                &wlplan::graph_generator::GraphGenerator::to_graph),
            "state"_a,
-           "actions"_a);
+           "actions"_a)
+      .def("to_graph",
+           py::overload_cast<const wlplan::planning::InternedState &>(
+               &wlplan::graph_generator::GraphGenerator::to_graph),
+           "state"_a)
+      .def("to_graph_opt",
+           py::overload_cast<const wlplan::planning::State &>(
+               &wlplan::graph_generator::GraphGenerator::to_graph_opt),
+           "state"_a,
+           R"(Graph of a state built in place on the base graph of the problem, which is only valid
+until the next call and must be followed by ``reset_graph()`` before converting another state.
+)")
+      .def(
+          "to_graph_opt",
+          [](wlplan::graph_generator::GraphGenerator &self,
+             const wlplan::planning::State &state,
+             const wlplan::planning::Actions &actions) {
+            wlplan::planning::ActionPointers action_pointers;
+            for (const auto &action : actions) {
+              action_pointers.push_back(std::make_shared<wlplan::planning::Action>(action));
+            }
+            return self.to_graph_opt(state, action_pointers);
+          },
+          "state"_a,
+          "actions"_a)
+      .def("reset_graph", &wlplan::graph_generator::GraphGenerator::reset_graph);
 
   // ILGGenerator
   py::class_<wlplan::graph_generator::ILGGenerator, wlplan::graph_generator::GraphGenerator>(
@@ -669,42 +791,196 @@ Methods
       .def_readonly_static("NONE", &wlplan::feature_generator::PruningOptions::NONE)
       .def_static("get_all", &wlplan::feature_generator::PruningOptions::get_all);
 
+  // MaxSatProblem
+  py::class_<wlplan::feature_generator::MaxSatProblem>(feature_generator_m,
+                                                       "MaxSatProblem",
+                                                       R"(Weighted partial MaxSAT problem over DIMACS literals, as solved for pruning features.
+)")
+      .def(py::init<>())
+      .def(
+          "add_hard",
+          [](wlplan::feature_generator::MaxSatProblem &self, const std::vector<int> &literals) {
+            self.add_hard(std::span<const int>(literals));
+          },
+          "literals"_a)
+      .def(
+          "add_soft",
+          [](wlplan::feature_generator::MaxSatProblem &self,
+             const std::vector<int> &literals,
+             const long weight) { self.add_soft(std::span<const int>(literals), weight); },
+          "literals"_a,
+          "weight"_a)
+      .def("get_n_variables", &wlplan::feature_generator::MaxSatProblem::get_n_variables)
+      .def("get_n_clauses", &wlplan::feature_generator::MaxSatProblem::get_n_clauses)
+      .def("get_cost", &wlplan::feature_generator::MaxSatProblem::get_cost, "values"_a)
+      .def("__repr__", &wlplan::feature_generator::MaxSatProblem::to_string);
+
+  // MaxSatSolution
+  py::class_<wlplan::feature_generator::MaxSatSolution>(feature_generator_m, "MaxSatSolution")
+      .def_readonly("found", &wlplan::feature_generator::MaxSatSolution::found)
+      .def_readonly("optimal", &wlplan::feature_generator::MaxSatSolution::optimal)
+      .def_readonly("cost", &wlplan::feature_generator::MaxSatSolution::cost)
+      .def_readonly("lower_bound", &wlplan::feature_generator::MaxSatSolution::lower_bound)
+      .def_readonly("values", &wlplan::feature_generator::MaxSatSolution::values);
+
+  // MaxSatSolver
+  py::class_<wlplan::feature_generator::MaxSatSolver,
+             std::shared_ptr<wlplan::feature_generator::MaxSatSolver>>(feature_generator_m,
+                                                                       "MaxSatSolver")
+      .def("solve",
+           &wlplan::feature_generator::MaxSatSolver::solve,
+           "problem"_a,
+           "time_limit"_a = 0.0);
+
+  py::class_<wlplan::feature_generator::CoreGuidedMaxSatSolver,
+             wlplan::feature_generator::MaxSatSolver,
+             std::shared_ptr<wlplan::feature_generator::CoreGuidedMaxSatSolver>>(
+      feature_generator_m, "CoreGuidedMaxSatSolver")
+      .def(py::init<>());
+
+  py::class_<wlplan::feature_generator::ExternalMaxSatSolver,
+             wlplan::feature_generator::MaxSatSolver,
+             std::shared_ptr<wlplan::feature_generator::ExternalMaxSatSolver>>(
+      feature_generator_m, "ExternalMaxSatSolver")
+      .def(py::init<const std::string &>(), "command"_a);
+
+  py::class_<wlplan::feature_generator::DecomposingMaxSatSolver,
+             wlplan::feature_generator::MaxSatSolver,
+             std::shared_ptr<wlplan::feature_generator::DecomposingMaxSatSolver>>(
+      feature_generator_m, "DecomposingMaxSatSolver")
+      .def(py::init<const std::string &, const int>(), "solver_name"_a, "n_threads"_a)
+      .def("set_fallback",
+           &wlplan::feature_generator::DecomposingMaxSatSolver::set_fallback,
+           "values"_a)
+      .def("get_n_fixed_variables",
+           &wlplan::feature_generator::DecomposingMaxSatSolver::get_n_fixed_variables)
+      .def("get_n_components",
+           &wlplan::feature_generator::DecomposingMaxSatSolver::get_n_components)
+      .def("get_largest_component",
+           &wlplan::feature_generator::DecomposingMaxSatSolver::get_largest_component)
+      .def("get_n_unsolved_components",
+           &wlplan::feature_generator::DecomposingMaxSatSolver::get_n_unsolved_components);
+
+  feature_generator_m.def(
+      "new_maxsat_solver", &wlplan::feature_generator::new_maxsat_solver, "name"_a);
+
   // Features
   py::class_<wlplan::feature_generator::Features>(feature_generator_m, "Features")
       .def("collect",
-           py::overload_cast<const wlplan::data::DomainDataset>(
+           py::overload_cast<const wlplan::data::DomainDataset &>(
                &wlplan::feature_generator::Features::collect_from_dataset),
            "dataset"_a)
+      .def("collect",
+           &wlplan::feature_generator::Features::collect_from_source,
+           "source"_a)
       .def("collect",
            py::overload_cast<const std::vector<wlplan::graph_generator::Graph> &>(
                &wlplan::feature_generator::Features::collect),
            "graphs"_a)
       .def("to_graphs", &wlplan::feature_generator::Features::to_graphs, "dataset"_a)
       .def("set_problem", &wlplan::feature_generator::Features::set_problem, "problem"_a)
-      .def("get_string_representation",
-           py::overload_cast<const wlplan::feature_generator::Embedding &>(
-               &wlplan::feature_generator::Features::get_string_representation),
-           "embedding"_a)
+      .def(
+          "get_string_representation",
+          [](wlplan::feature_generator::Features &self, const std::map<int, int> &embedding) {
+            return self.get_string_representation(
+                wlplan::feature_generator::map_to_embedding(embedding));
+          },
+          "embedding"_a)
       .def("get_string_representation",
            py::overload_cast<const wlplan::planning::State &>(
                &wlplan::feature_generator::Features::get_string_representation),
            "state"_a)
-      .def("embed",
-           py::overload_cast<const wlplan::data::DomainDataset &>(
-               &wlplan::feature_generator::Features::embed_dataset),
-           "dataset"_a)
-      .def("embed",
-           py::overload_cast<const std::vector<wlplan::graph_generator::Graph> &>(
-               &wlplan::feature_generator::Features::embed_graphs),
-           "graphs"_a)
-      .def("embed",
-           py::overload_cast<const wlplan::graph_generator::Graph &>(
-               &wlplan::feature_generator::Features::embed_graph),
-           "graph"_a)
-      .def("embed",
-           py::overload_cast<const wlplan::planning::State &>(
-               &wlplan::feature_generator::Features::embed_state),
-           "state"_a)
+      // embeddings are returned to Python as {colour: count} dictionaries
+      .def(
+          "embed",
+          [](wlplan::feature_generator::Features &self, const wlplan::data::DomainDataset &dataset) {
+            std::vector<std::map<int, int>> X;
+            for (const auto &x : self.embed_dataset(dataset)) {
+              X.push_back(wlplan::feature_generator::embedding_to_map(x));
+            }
+            return X;
+          },
+          "dataset"_a)
+      .def(
+          "embed",
+          [](wlplan::feature_generator::Features &self,
+             const std::vector<wlplan::graph_generator::Graph> &graphs) {
+            std::vector<std::map<int, int>> X;
+            for (const auto &x : self.embed_graphs(graphs)) {
+              X.push_back(wlplan::feature_generator::embedding_to_map(x));
+            }
+            return X;
+          },
+          "graphs"_a)
+      .def(
+          "embed",
+          [](wlplan::feature_generator::Features &self, const wlplan::graph_generator::Graph &graph) {
+            return wlplan::feature_generator::embedding_to_map(self.embed_graph(graph));
+          },
+          "graph"_a)
+      .def(
+          "embed",
+          [](wlplan::feature_generator::Features &self, const wlplan::planning::State &state) {
+            return wlplan::feature_generator::embedding_to_map(self.embed_state(state));
+          },
+          "state"_a)
+      .def(
+          "embed",
+          [](wlplan::feature_generator::Features &self,
+             const wlplan::planning::InternedState &state) {
+            return wlplan::feature_generator::embedding_to_map(self.embed_state(state));
+          },
+          "state"_a)
+      // feature matrices are written into numpy buffers
+      .def(
+          "embed_csr",
+          [](wlplan::feature_generator::Features &self, const wlplan::data::DomainDataset &dataset) {
+            wlplan::feature_generator::CSRMatrix X;
+            {
+              py::gil_scoped_release release;
+              X = self.embed_dataset_csr(dataset);
+            }
+            return csr_to_numpy(std::move(X));
+          },
+          "dataset"_a)
+      .def(
+          "embed_csr",
+          [](wlplan::feature_generator::Features &self,
+             const std::vector<wlplan::graph_generator::Graph> &graphs) {
+            wlplan::feature_generator::CSRMatrix X;
+            {
+              py::gil_scoped_release release;
+              X = self.embed_graphs_csr(graphs);
+            }
+            return csr_to_numpy(std::move(X));
+          },
+          "graphs"_a)
+      .def(
+          "embed_dense",
+          [](wlplan::feature_generator::Features &self,
+             const wlplan::data::DomainDataset &dataset,
+             DenseMatrix X) {
+            check_dense_matrix(X);
+            double *data = X.mutable_data();
+            size_t n_rows = X.shape(0), n_cols = X.shape(1);
+            py::gil_scoped_release release;
+            self.embed_dataset_dense(dataset, data, n_rows, n_cols);
+          },
+          "dataset"_a,
+          "X"_a.noconvert())
+      .def(
+          "embed_dense",
+          [](wlplan::feature_generator::Features &self,
+             const std::vector<wlplan::graph_generator::Graph> &graphs,
+             DenseMatrix X) {
+            check_dense_matrix(X);
+            double *data = X.mutable_data();
+            size_t n_rows = X.shape(0), n_cols = X.shape(1);
+            py::gil_scoped_release release;
+            self.embed_graphs_dense(graphs, data, n_rows, n_cols);
+          },
+          "graphs"_a,
+          "X"_a.noconvert())
       .def("get_n_features", &wlplan::feature_generator::Features::get_n_features)
       .def("get_n_colours", &wlplan::feature_generator::Features::get_n_colours)
       .def("get_seen_counts", &wlplan::feature_generator::Features::get_seen_counts)
@@ -724,6 +1000,23 @@ Methods
       .def("get_colour_hash_list", &wlplan::feature_generator::Features::get_colour_hash_list)
       .def("get_n_relation", &wlplan::feature_generator::Features::get_n_relation)
       .def("get_multiset_hash", &wlplan::feature_generator::Features::get_multiset_hash)
+      .def("get_n_threads", &wlplan::feature_generator::Features::get_n_threads)
+      .def("set_n_threads", &wlplan::feature_generator::Features::set_n_threads, "n_threads"_a)
+      .def("get_spill_directory", &wlplan::feature_generator::Features::get_spill_directory)
+      .def("set_spill_directory",
+           &wlplan::feature_generator::Features::set_spill_directory,
+           "spill_directory"_a)
+      .def("get_maxsat_solver", &wlplan::feature_generator::Features::get_maxsat_solver)
+      .def("set_maxsat_solver",
+           &wlplan::feature_generator::Features::set_maxsat_solver,
+           "maxsat_solver"_a)
+      .def("get_maxsat_time_limit", &wlplan::feature_generator::Features::get_maxsat_time_limit)
+      .def("set_maxsat_time_limit",
+           &wlplan::feature_generator::Features::set_maxsat_time_limit,
+           "maxsat_time_limit"_a)
+      .def("freeze", &wlplan::feature_generator::Features::freeze)
+      .def("unfreeze", &wlplan::feature_generator::Features::unfreeze)
+      .def("is_frozen", &wlplan::feature_generator::Features::is_frozen)
       .def("get_colour_to_description", &wlplan::feature_generator::Features::get_colour_to_description)
 
       .def("predict",
@@ -734,6 +1027,20 @@ Methods
            py::overload_cast<const wlplan::planning::State &>(
                &wlplan::feature_generator::Features::predict),
            "state"_a)
+      .def("predict",
+           py::overload_cast<const wlplan::planning::InternedState &>(
+               &wlplan::feature_generator::Features::predict),
+           "state"_a)
+      .def("predict_batch",
+           py::overload_cast<const std::vector<wlplan::graph_generator::Graph> &>(
+               &wlplan::feature_generator::Features::predict_batch),
+           "graphs"_a,
+           py::call_guard<py::gil_scoped_release>())
+      .def("predict_batch",
+           py::overload_cast<const std::vector<wlplan::planning::State> &>(
+               &wlplan::feature_generator::Features::predict_batch),
+           "states"_a,
+           py::call_guard<py::gil_scoped_release>())
       .def("save",
            py::overload_cast<const std::string &>(&wlplan::feature_generator::Features::save),
            "filename"_a)
@@ -742,6 +1049,17 @@ Methods
                &wlplan::feature_generator::Features::save),
            "filename"_a,
            "weights"_a)
+      .def("save_json", &wlplan::feature_generator::Features::save_json, "filename"_a)
+      .def("save_binary",
+           &wlplan::feature_generator::Features::save_binary,
+           "filename"_a,
+           "compress_keys"_a = false)
+      .def_static("is_binary_model",
+                  &wlplan::feature_generator::Features::is_binary_model,
+                  "filename"_a)
+      .def_static("read_feature_name",
+                  &wlplan::feature_generator::Features::read_feature_name,
+                  "filename"_a)
       .def("set_save_unseen_colours",
            py::overload_cast<const std::string &>(&wlplan::feature_generator::Features::set_save_unseen_colours),
            "filename"_a)
@@ -753,6 +1071,11 @@ Methods
            "filename"_a)
       ;
 
+  // WLContext
+  py::class_<wlplan::feature_generator::WLContext,
+             std::shared_ptr<wlplan::feature_generator::WLContext>>(feature_generator_m,
+                                                                    "WLContext");
+
   // WLFeatures
   py::class_<wlplan::feature_generator::WLFeatures, wlplan::feature_generator::Features>(
       feature_generator_m, "WLFeatures")
@@ -763,7 +1086,23 @@ Methods
            "graph_representation"_a,
            "iterations"_a,
            "pruning"_a,
-           "multiset_hash"_a);
+           "multiset_hash"_a)
+      .def("init_context", &wlplan::feature_generator::WLFeatures::init_context, "state"_a)
+      .def("successor_context",
+           &wlplan::feature_generator::WLFeatures::successor_context,
+           "parent"_a,
+           "add_atoms"_a,
+           "del_atoms"_a)
+      .def(
+          "embed_context",
+          [](wlplan::feature_generator::WLFeatures &self,
+             const std::shared_ptr<wlplan::feature_generator::WLContext> &context) {
+            return wlplan::feature_generator::embedding_to_map(self.embed_context(context));
+          },
+          "context"_a)
+      .def("predict_context",
+           &wlplan::feature_generator::WLFeatures::predict_context,
+           "context"_a);
 
   // LWL2Features
   py::class_<wlplan::feature_generator::LWL2Features, wlplan::feature_generator::Features>(
@@ -775,7 +1114,26 @@ Methods
            "graph_representation"_a,
            "iterations"_a,
            "pruning"_a,
-           "multiset_hash"_a);
+           "multiset_hash"_a)
+      .def("get_max_pair_entries",
+           &wlplan::feature_generator::LWL2Features::get_max_pair_entries)
+      .def("set_max_pair_entries",
+           &wlplan::feature_generator::LWL2Features::set_max_pair_entries,
+           "max_pair_entries"_a);
+
+  // SLWL2Features
+  py::class_<wlplan::feature_generator::SLWL2Features, wlplan::feature_generator::LWL2Features>(
+      feature_generator_m, "SLWL2Features")
+      .def(py::init<const std::string &>(), "filename"_a)
+      .def(py::init<const std::string &, bool>(), "filename"_a, "quiet"_a)
+      .def(py::init<wlplan::planning::Domain &, std::string, int, std::string, bool, int>(),
+           "domain"_a,
+           "graph_representation"_a,
+           "iterations"_a,
+           "pruning"_a,
+           "multiset_hash"_a,
+           "radius"_a)
+      .def("get_radius", &wlplan::feature_generator::SLWL2Features::get_radius);
 
   // KWL2Features
   py::class_<wlplan::feature_generator::KWL2Features, wlplan::feature_generator::Features>(
@@ -25,11 +25,11 @@ namespace wlplan {
       std::sort(this->constant_objects.begin(), this->constant_objects.end());
       type_to_colour = std::unordered_map<std::string, int>();
       for (size_t i = 0; i < this->types.size(); i++) {
-        type_to_colour[types[i]] = i;
+        type_to_colour[this->types[i]] = i;
       }
       predicate_to_colour = std::unordered_map<std::string, int>();
       for (size_t i = 0; i < this->predicates.size(); i++) {
-        predicate_to_colour[predicates[i].name] = i;
+        predicate_to_colour[this->predicates[i].name] = i;
       }
     }
 	
@@ -4,11 +4,59 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
 
 #define PYBIND11_DETAILED_ERROR_MESSAGES 1
 
 namespace wlplan {
   namespace planning {
+    /* Atom ids in the order atoms are first seen. An atom is keyed by its predicate index followed
+       by its object ids. Lookups may come from several embedding threads at once. */
+    class AtomTable {
+     public:
+      AtomId get_atom_id(const std::vector<int> &key) {
+        {
+          std::shared_lock lock(mutex);
+          auto it = ids.find(key);
+          if (it != ids.end()) {
+            return it->second;
+          }
+        }
+        std::unique_lock lock(mutex);
+        auto [it, inserted] = ids.try_emplace(key, (AtomId)keys.size());
+        if (inserted) {
+          keys.push_back(key);
+        }
+        return it->second;
+      }
+
+      void get_key(const AtomId atom_id, std::vector<int> &key) const {
+        std::shared_lock lock(mutex);
+        if (atom_id < 0 || atom_id >= (AtomId)keys.size()) {
+          throw std::runtime_error("Error: " + std::to_string(atom_id) + " is not an atom id.");
+        }
+        key = keys[atom_id];
+      }
+
+     private:
+      struct KeyHash {
+        std::size_t operator()(const std::vector<int> &key) const {
+          std::size_t ret = key.size();
+          for (const int x : key) {
+            ret ^= std::hash<int>()(x) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+          }
+          return ret;
+        }
+      };
+
+      mutable std::shared_mutex mutex;
+      std::unordered_map<std::vector<int>, AtomId, KeyHash> ids;
+      std::vector<std::vector<int>> keys;
+    };
+
     Problem::Problem(const Domain &domain,
                      const std::vector<Object> &objects,
                      const std::vector<Atom> &statics,
@@ -33,6 +81,7 @@ namespace wlplan {
         object_to_id[object] = cnt;
         constant_objects_set.insert(object);
         constant_objects.push_back(object);
+        id_to_object.push_back(object);
         cnt++;
       }
 
@@ -43,9 +92,40 @@ namespace wlplan {
         object_to_id[object] = cnt;
         constant_objects_set.insert(object);
         problem_objects.push_back(object);
+        id_to_object.push_back(object);
         cnt++;
       }
 
+      // handle atom ids, which only fit into 64 bits for moderate numbers of objects and arities
+      bool atom_ids_overflow = false;
+      atom_id_offsets = std::vector<AtomId>(1, 0);
+      for (const auto &predicate : domain.predicates) {
+        AtomId n_atoms = 1;
+        for (int i = 0; i < predicate.arity && !atom_ids_overflow; i++) {
+          if (cnt > 0 && n_atoms > std::numeric_limits<AtomId>::max() / cnt) {
+            atom_ids_overflow = true;
+          } else {
+            n_atoms *= cnt;
+          }
+        }
+        if (atom_ids_overflow ||
+            atom_id_offsets.back() > std::numeric_limits<AtomId>::max() - n_atoms) {
+          atom_ids_overflow = true;
+          break;
+        }
+        atom_id_offsets.push_back(atom_id_offsets.back() + n_atoms);
+      }
+      if (atom_ids_overflow) {
+        atom_id_offsets = std::vector<AtomId>();
+        atom_table = std::make_shared<AtomTable>();
+        for (const auto &atom : positive_goals) {
+          get_atom_id(atom);
+        }
+        for (const auto &atom : negative_goals) {
+          get_atom_id(atom);
+        }
+      }
+
       // handle fluents
       if (fluents.size() != fluent_values.size()) {
         std::cout << "Error: Number of fluent variables and fluent values do not match."
@@ -99,6 +179,94 @@ namespace wlplan {
                      const std::vector<Atom> &negative_goals)
         : Problem(domain, objects, {}, {}, {}, positive_goals, negative_goals, {}, "") {}
 
+    AtomId Problem::get_n_atom_ids() const {
+      if (atom_table) {
+        return std::numeric_limits<AtomId>::max();
+      }
+      return atom_id_offsets.back();
+    }
+
+    AtomId Problem::get_atom_id(const Atom &atom) const {
+      const int predicate_idx = domain->predicate_to_colour.at(atom.predicate->name);
+      std::vector<int> object_ids;
+      object_ids.reserve(atom.objects.size());
+      for (const auto &object : atom.objects) {
+        object_ids.push_back(object_to_id.at(object));
+      }
+      return get_atom_id(predicate_idx, object_ids);
+    }
+
+    AtomId Problem::get_atom_id(const int predicate_idx, const std::vector<int> &object_ids) const {
+      if (atom_table) {
+        std::vector<int> key;
+        key.reserve(object_ids.size() + 1);
+        key.push_back(predicate_idx);
+        key.insert(key.end(), object_ids.begin(), object_ids.end());
+        return atom_table->get_atom_id(key);
+      }
+      AtomId atom_id = 0;
+      for (int i = object_ids.size() - 1; i >= 0; i--) {
+        atom_id = atom_id * get_n_objects() + object_ids[i];
+      }
+      return atom_id_offsets[predicate_idx] + atom_id;
+    }
+
+    int Problem::get_atom_predicate(const AtomId atom_id) const {
+      if (atom_table) {
+        std::vector<int> key;
+        atom_table->get_key(atom_id, key);
+        return key[0];
+      }
+      if (atom_id < 0 || atom_id >= get_n_atom_ids()) {
+        throw std::runtime_error("Error: " + std::to_string(atom_id) + " is not an atom id.");
+      }
+      auto it = std::upper_bound(atom_id_offsets.begin(), atom_id_offsets.end(), atom_id);
+      return (it - atom_id_offsets.begin()) - 1;
+    }
+
+    void Problem::get_atom_object_ids(const AtomId atom_id, std::vector<int> &object_ids) const {
+      if (atom_table) {
+        atom_table->get_key(atom_id, object_ids);
+        object_ids.erase(object_ids.begin());
+        return;
+      }
+      const int predicate_idx = get_atom_predicate(atom_id);
+      AtomId rest = atom_id - atom_id_offsets[predicate_idx];
+      object_ids.resize(domain->predicates[predicate_idx].arity);
+      for (size_t i = 0; i < object_ids.size(); i++) {
+        object_ids[i] = rest % get_n_objects();
+        rest /= get_n_objects();
+      }
+    }
+
+    Atom Problem::get_atom(const AtomId atom_id) const {
+      std::vector<int> object_ids;
+      get_atom_object_ids(atom_id, object_ids);
+      std::vector<Object> objects;
+      for (const int object_id : object_ids) {
+        objects.push_back(id_to_object[object_id]);
+      }
+      return Atom(domain->predicates[get_atom_predicate(atom_id)], objects);
+    }
+
+    InternedState Problem::intern_state(const State &state) const {
+      std::vector<AtomId> atom_ids;
+      atom_ids.reserve(state.atoms.size());
+      for (const auto &atom : state.atoms) {
+        atom_ids.push_back(get_atom_id(*atom));
+      }
+      return InternedState(atom_ids, state.values);
+    }
+
+    State Problem::get_state(const InternedState &state) const {
+      std::vector<std::shared_ptr<Atom>> atoms;
+      atoms.reserve(state.atom_ids.size());
+      for (const AtomId atom_id : state.atom_ids) {
+        atoms.push_back(std::make_shared<Atom>(get_atom(atom_id)));
+      }
+      return State(atoms, state.values);
+    }
+
     std::string Problem::to_string() const {
       std::string t1 = "\n  ";
       std::string t2 = "\n    ";
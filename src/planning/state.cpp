@@ -65,5 +65,25 @@ namespace wlplan {
     }
 
     size_t State::hash() const { return std::hash<std::string>()(to_string()); }
+
+    InternedState::InternedState(const std::vector<AtomId> &atom_ids,
+                                 const std::vector<double> &values)
+        : atom_ids(atom_ids), values(values) {
+      std::sort(this->atom_ids.begin(), this->atom_ids.end());
+    }
+
+    InternedState::InternedState(const std::vector<AtomId> &atom_ids)
+        : InternedState(atom_ids, {}) {}
+
+    size_t InternedState::hash() const {
+      size_t ret = atom_ids.size();
+      for (const AtomId atom_id : atom_ids) {
+        ret ^= std::hash<AtomId>()(atom_id) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+      }
+      for (const double value : values) {
+        ret ^= std::hash<double>()(value) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+      }
+      return ret;
+    }
   }  // namespace planning
 }  // namespace wlplan
@@ -0,0 +1,36 @@
+import logging
+
+import numpy as np
+from ipc23lt import get_dataset
+from util import to_dense
+
+from wlplan.feature_generator import init_feature_generator
+
+
+LOGGER = logging.getLogger(__name__)
+
+
+def test_embed_buffers():
+    """Check CSR and dense embeddings match the dictionary embeddings"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    n_features = feature_generator.get_n_features()
+    X = to_dense(feature_generator.embed(dataset), d=n_features)
+
+    (data, indices, indptr), shape = feature_generator.embed_csr(dataset)
+    assert shape == X.shape
+    X_csr = np.zeros(shape)
+    for i in range(shape[0]):
+        X_csr[i, indices[indptr[i] : indptr[i + 1]]] = data[indptr[i] : indptr[i + 1]]
+    assert np.array_equal(X, X_csr)
+
+    X_dense = np.full(X.shape, -1.0)
+    feature_generator.embed_dense(dataset, X_dense)
+    assert np.array_equal(X, X_dense)
+    LOGGER.info(f"{X.shape=}, nnz={len(data)}")
@@ -10,6 +10,7 @@ from util import to_dense
 
 from wlplan.feature_generator import init_feature_generator
 from wlplan.graph_generator import (
+    AOAGGenerator,
     IILGGenerator,
     ILGGenerator,
     NILGGenerator,
@@ -17,7 +18,7 @@ from wlplan.graph_generator import (
     from_networkx,
     to_networkx,
 )
-from wlplan.planning import parse_domain
+from wlplan.planning import Action, parse_domain
 
 
 LOGGER = logging.getLogger(__name__)
@@ -118,6 +119,47 @@ def test_iilg():
             assert nx_graph is not None
 
 
+
+@pytest.mark.parametrize("generator_class", [ILGGenerator, PLOIGGenerator, AOAGGenerator])
+def test_to_graph_opt(generator_class):
+    """Check graphs built in place on the base graph match copied graphs over consecutive states,
+    and that resetting after each state leaves the base graph unchanged"""
+    domain, dataset, _ = get_ipc23lt_dataset(domain_name="blocksworld", keep_statics=False)
+    problem, states = dataset[0]
+    states = states[:6]
+    generator = generator_class(domain, differentiate_constant_objects=True)
+    generator.set_problem(problem)
+
+    # a varying number of actions, so that resetting removes a varying number of action nodes
+    objects = problem.objects
+    actions = [
+        [
+            Action(schema, [objects[(k + j) % len(objects)] for j in range(schema.arity)])
+            for k, schema in enumerate(schemata)
+        ]
+        for schemata in [domain.schemata[: i % 4] for i in range(len(states))]
+    ]
+
+    def graph_data(graph):
+        return graph.node_colours, graph.node_values, graph.edges
+
+    def copied_graphs():
+        if generator_class is AOAGGenerator:
+            graphs = [generator.to_graph(s, a) for s, a in zip(states, actions)]
+        else:
+            graphs = [generator.to_graph(s) for s in states]
+        return [graph_data(graph) for graph in graphs]
+
+    expected = copied_graphs()
+    for state, state_actions, graph in zip(states, actions, expected):
+        if generator_class is AOAGGenerator:
+            assert graph_data(generator.to_graph_opt(state, state_actions)) == graph
+        else:
+            assert graph_data(generator.to_graph_opt(state)) == graph
+        generator.reset_graph()
+    assert copied_graphs() == expected
+
+
 if __name__ == "__main__":
     # Manually test drawing
     import matplotlib.pyplot as plt
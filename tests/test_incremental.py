@@ -0,0 +1,148 @@
+import logging
+
+import numpy as np
+import pytest
+from ipc23lt import get_dataset
+
+from wlplan.feature_generator import init_feature_generator
+
+
+LOGGER = logging.getLogger(__name__)
+
+
+def _transition(parent, child):
+    parent_atoms = {repr(atom): atom for atom in parent.atoms}
+    child_atoms = {repr(atom): atom for atom in child.atoms}
+    add_atoms = [atom for name, atom in child_atoms.items() if name not in parent_atoms]
+    del_atoms = [atom for name, atom in parent_atoms.items() if name not in child_atoms]
+    return add_atoms, del_atoms
+
+
+def test_incremental():
+    """Check successor contexts give the same embeddings as embedding states from scratch"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    weights = np.random.default_rng(0).normal(size=feature_generator.get_n_features())
+    feature_generator.set_weights(weights.tolist())
+
+    n_checks = 0
+    for problem_dataset in dataset.data[:5]:
+        feature_generator.set_problem(problem_dataset.problem)
+        states = problem_dataset.states
+        context = feature_generator.init_context(states[0])
+        for parent, child in zip(states[:-1], states[1:]):
+            add_atoms, del_atoms = _transition(parent, child)
+            context = feature_generator.successor_context(context, add_atoms, del_atoms)
+
+            assert feature_generator.embed_context(context) == feature_generator.embed(child)
+            h = feature_generator.predict(child)
+            assert np.isclose(feature_generator.predict_context(context), h)
+            n_checks += 1
+    LOGGER.info(f"{n_checks=}")
+
+
+def test_incremental_branching():
+    """Check contexts stay valid when the search jumps between branches and problems"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    weights = np.random.default_rng(0).normal(size=feature_generator.get_n_features())
+    feature_generator.set_weights(weights.tolist())
+
+    rng = np.random.default_rng(0)
+    for problem_dataset in dataset.data[:5]:
+        feature_generator.set_problem(problem_dataset.problem)
+        states = problem_dataset.states
+        # every state is a successor of a random earlier state, and several trees are kept
+        contexts = [(feature_generator.init_context(states[0]), states[0])]
+        for i, child in enumerate(states[1:]):
+            if i % 10 == 9:
+                contexts.append((feature_generator.init_context(child), child))
+                continue
+            parent_context, parent = contexts[rng.integers(len(contexts))]
+            add_atoms, del_atoms = _transition(parent, child)
+            context = feature_generator.successor_context(parent_context, add_atoms, del_atoms)
+            contexts.append((context, child))
+
+        for j in rng.permutation(len(contexts)):
+            context, state = contexts[j]
+            assert feature_generator.embed_context(context) == feature_generator.embed(state)
+            assert np.isclose(
+                feature_generator.predict_context(context), feature_generator.predict(state)
+            )
+
+
+def test_context_of_other_problem():
+    """Check contexts cannot be used after another problem is set"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+
+    problem_a, problem_b = dataset.data[0], dataset.data[1]
+    feature_generator.set_problem(problem_a.problem)
+    context = feature_generator.init_context(problem_a.states[0])
+    add_atoms, del_atoms = _transition(problem_a.states[0], problem_a.states[1])
+    child = feature_generator.successor_context(context, add_atoms, del_atoms)
+
+    feature_generator.set_problem(problem_b.problem)
+    with pytest.raises(RuntimeError, match="different problem"):
+        feature_generator.successor_context(context, add_atoms, del_atoms)
+    with pytest.raises(RuntimeError, match="different problem"):
+        feature_generator.embed_context(child)
+
+
+def test_incremental_redundant_effects():
+    """Check adding atoms that are already true and deleting atoms that are already false, as
+    action effects often do, gives the same embeddings as exact transitions"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    weights = np.random.default_rng(0).normal(size=feature_generator.get_n_features())
+    feature_generator.set_weights(weights.tolist())
+
+    n_redundant = 0
+    for problem_dataset in dataset.data[:5]:
+        feature_generator.set_problem(problem_dataset.problem)
+        states = problem_dataset.states
+        all_atoms = {repr(atom): atom for state in states for atom in state.atoms}
+        context = feature_generator.init_context(states[0])
+        for parent, child in zip(states[:-1], states[1:]):
+            add_atoms, del_atoms = _transition(parent, child)
+            parent_names = {repr(atom) for atom in parent.atoms}
+            child_names = {repr(atom) for atom in child.atoms}
+            true_atoms = [atom for atom in child.atoms if repr(atom) in parent_names]
+            false_atoms = [
+                atom
+                for name, atom in all_atoms.items()
+                if name not in parent_names and name not in child_names
+            ]
+            add_atoms = add_atoms + true_atoms[:3] + add_atoms[:1]
+            del_atoms = del_atoms + false_atoms[:3]
+            n_redundant += len(true_atoms[:3]) + len(false_atoms[:3])
+            context = feature_generator.successor_context(context, add_atoms, del_atoms)
+
+            assert feature_generator.embed_context(context) == feature_generator.embed(child)
+            h = feature_generator.predict(child)
+            assert np.isclose(feature_generator.predict_context(context), h)
+    assert n_redundant > 0
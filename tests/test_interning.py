@@ -0,0 +1,147 @@
+import logging
+
+import numpy as np
+from ipc23lt import get_dataset
+
+from wlplan.data import DomainDataset, ProblemDataset
+from wlplan.feature_generator import init_feature_generator
+from wlplan.planning import Atom, Domain, Object, Predicate, Problem, State
+
+
+LOGGER = logging.getLogger(__name__)
+
+
+def test_interning():
+    """Check interned states give the same embeddings as states of atoms"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    weights = np.random.default_rng(0).normal(size=feature_generator.get_n_features())
+    feature_generator.set_weights(weights.tolist())
+
+    n_checks = 0
+    for problem_dataset in dataset.data[:5]:
+        problem = problem_dataset.problem
+        feature_generator.set_problem(problem)
+        for state in problem_dataset.states:
+            interned_state = problem.intern_state(state)
+            assert interned_state.atom_ids == sorted(interned_state.atom_ids)
+            for atom, atom_id in zip(state.atoms, map(problem.get_atom_id, state.atoms)):
+                assert problem.get_atom(atom_id) == atom
+            assert problem.intern_state(problem.get_state(interned_state)) == interned_state
+
+            assert feature_generator.embed(interned_state) == feature_generator.embed(state)
+            h = feature_generator.predict(state)
+            assert np.isclose(feature_generator.predict(interned_state), h)
+            n_checks += 1
+    LOGGER.info(f"{n_checks=}")
+
+
+def _hand_built_problem(predicates, n_objects):
+    domain = Domain(
+        name="hand_built",
+        predicates=predicates,
+        functions=[],
+        schemata=[],
+        types=["object"],
+        constant_objects=[],
+    )
+    name_to_predicate = {p.name: p for p in domain.predicates}
+    objects = [Object(f"o{i}") for i in range(n_objects)]
+    positive_goals = [Atom(name_to_predicate["on"], [objects[0], objects[1]])]
+    negative_goals = [Atom(name_to_predicate["clear"], [objects[2]])]
+    problem = Problem(domain, objects, positive_goals, negative_goals)
+    return domain, problem, name_to_predicate, objects
+
+
+def test_unsorted_predicates():
+    """Check atom ids and ILG colours do not depend on the order predicates are given in"""
+    predicates = [Predicate("on", 2), Predicate("clear", 1), Predicate("holding", 1)]
+    domain, problem, name_to_predicate, objects = _hand_built_problem(predicates, 3)
+    sorted_domain, sorted_problem, _, _ = _hand_built_problem(sorted(predicates, key=repr), 3)
+    assert domain == sorted_domain
+
+    on, clear, holding = (name_to_predicate[name] for name in ["on", "clear", "holding"])
+    states = [
+        State([Atom(on, [objects[1], objects[0]]), Atom(clear, [objects[2]])]),
+        State([Atom(holding, [objects[1]]), Atom(clear, [objects[0]]), Atom(clear, [objects[2]])]),
+        State([Atom(on, [objects[0], objects[1]]), Atom(holding, [objects[2]])]),
+    ]
+    for state in states:
+        for atom in state.atoms:
+            atom_id = problem.get_atom_id(atom)
+            assert problem.get_atom(atom_id) == atom
+            assert sorted_problem.get_atom_id(atom) == atom_id
+
+    embeddings = []
+    for d, p in [(domain, problem), (sorted_domain, sorted_problem)]:
+        feature_generator = init_feature_generator(
+            feature_algorithm="wl",
+            domain=d,
+            graph_representation="ilg",
+            iterations=2,
+        )
+        feature_generator.collect(
+            DomainDataset(domain=d, data=[ProblemDataset(problem=p, states=states)])
+        )
+        feature_generator.set_problem(p)
+        embedding = [feature_generator.embed(s) for s in states]
+        assert [feature_generator.embed(p.intern_state(s)) for s in states] == embedding
+
+        # incremental embeddings colour atoms by Domain.predicate_to_colour
+        context = feature_generator.init_context(states[0])
+        for parent, child in zip(states[:-1], states[1:]):
+            parent_atoms = {repr(atom): atom for atom in parent.atoms}
+            child_atoms = {repr(atom): atom for atom in child.atoms}
+            add_atoms = [atom for name, atom in child_atoms.items() if name not in parent_atoms]
+            del_atoms = [atom for name, atom in parent_atoms.items() if name not in child_atoms]
+            context = feature_generator.successor_context(context, add_atoms, del_atoms)
+            assert feature_generator.embed_context(context) == feature_generator.embed(child)
+        embeddings.append(embedding)
+    assert embeddings[0] == embeddings[1]
+
+
+def test_overflowing_atom_ids():
+    """Check atoms are interned in a table if their ids do not fit into 64 bits"""
+    # 101^10 atoms of the arity 10 predicate do not fit into 64 bits
+    predicates = [Predicate("on", 2), Predicate("clear", 1), Predicate("big", 10)]
+    domain, problem, name_to_predicate, objects = _hand_built_problem(predicates, 101)
+    on, clear, big = (name_to_predicate[name] for name in ["on", "clear", "big"])
+
+    # goals are interned first
+    goal_ids = [problem.get_atom_id(atom) for atom in problem.positive_goals + problem.negative_goals]
+    assert sorted(goal_ids) == [0, 1]
+
+    states = [
+        State([Atom(on, [objects[1], objects[0]]), Atom(big, objects[:10])]),
+        State([Atom(big, objects[-10:]), Atom(clear, [objects[0]]), Atom(clear, [objects[2]])]),
+        State([Atom(on, [objects[0], objects[1]]), Atom(big, objects[:10])]),
+    ]
+    for state in states:
+        for atom in state.atoms:
+            atom_id = problem.get_atom_id(atom)
+            assert problem.get_atom(atom_id) == atom
+            assert problem.get_atom_id(atom) == atom_id
+        assert problem.intern_state(problem.get_state(problem.intern_state(state))) == (
+            problem.intern_state(state)
+        )
+    assert problem.get_atom_id(states[0].atoms[1]) == problem.get_atom_id(states[2].atoms[1])
+    assert problem.get_atom_id(states[0].atoms[1]) != problem.get_atom_id(states[1].atoms[0])
+
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=2,
+    )
+    feature_generator.collect(
+        DomainDataset(domain=domain, data=[ProblemDataset(problem=problem, states=states)])
+    )
+    feature_generator.set_problem(problem)
+    for state in states:
+        assert feature_generator.embed(problem.intern_state(state)) == feature_generator.embed(state)
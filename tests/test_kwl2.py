@@ -0,0 +1,172 @@
+import logging
+
+import pytest
+from ipc23lt import get_dataset
+from util import custom_graph_domain
+
+from wlplan.data import DomainDataset
+from wlplan.feature_generator import init_feature_generator, load_feature_generator
+from wlplan.graph_generator import Graph
+
+LOGGER = logging.getLogger(__name__)
+
+
+def _graph(node_colours, edges):
+    """Undirected graph with edge label 0"""
+    adjacency = [[] for _ in node_colours]
+    for u, v in edges:
+        adjacency[u].append((0, v))
+        adjacency[v].append((0, u))
+    return Graph(node_colours=node_colours, edges=adjacency)
+
+
+def _path(n):
+    return _graph([0] * n, [(i, i + 1) for i in range(n - 1)])
+
+
+def _cycle(n, coloured=None):
+    """Cycle whose nodes have colour 0, except for the coloured node which has colour 1"""
+    node_colours = [int(u == coloured) for u in range(n)]
+    return _graph(node_colours, [(i, (i + 1) % n) for i in range(n)])
+
+
+def _layer_counts(feature_generator, graph):
+    """Sorted counts of the colours of each iteration in the embedding of a graph"""
+    colour_to_layer = feature_generator.get_colour_to_layer()
+    counts = {}
+    for colour, count in feature_generator.embed(graph).items():
+        counts.setdefault(colour_to_layer[colour], []).append(count)
+    return {layer: sorted(layer_counts) for layer, layer_counts in counts.items()}
+
+
+def _custom_feature_generator(feature_algorithm, multiset_hash, **kwargs):
+    return init_feature_generator(
+        feature_algorithm=feature_algorithm,
+        domain=custom_graph_domain(),
+        graph_representation="custom",
+        iterations=2,
+        pruning="none",
+        multiset_hash=multiset_hash,
+        **kwargs,
+    )
+
+
+@pytest.mark.parametrize("multiset_hash", [False, True])
+@pytest.mark.parametrize("n_threads", [1, 4])
+def test_kwl2_cycles(multiset_hash, n_threads):
+    """Check 2-KWL colours pairs of nodes of cycles by their distance, with rows of lengths that
+    are not multiples of the vector width"""
+    feature_generator = _custom_feature_generator("kwl2", multiset_hash)
+    feature_generator.set_n_threads(n_threads)
+    feature_generator.collect([_cycle(5), _cycle(6), _cycle(7)])
+
+    # pairs of a node with itself share their initial colour with non-edges, and pairs are refined
+    # into the distances 0, 1, ..., n // 2 between their nodes
+    assert _layer_counts(feature_generator, _cycle(5)) == {
+        0: [10, 15],
+        1: [5, 10, 10],
+        2: [5, 10, 10],
+    }
+    assert _layer_counts(feature_generator, _cycle(6)) == {
+        0: [12, 24],
+        1: [6, 6, 12, 12],
+        2: [6, 6, 12, 12],
+    }
+    assert _layer_counts(feature_generator, _cycle(7)) == {
+        0: [14, 35],
+        1: [7, 14, 14, 14],
+        2: [7, 14, 14, 14],
+    }
+
+    # Pairs with a node of an unseen colour are unseen, and every pair has such a node as a
+    # neighbour in later iterations. The unseen node lands in the vectorised part of rows or in
+    # their scalar tail depending on its position.
+    for coloured in range(7):
+        assert _layer_counts(feature_generator, _cycle(7, coloured)) == {0: [10, 26]}
+    for coloured in range(5):
+        assert _layer_counts(feature_generator, _cycle(5, coloured)) == {0: [6, 10]}
+
+
+@pytest.mark.parametrize("feature_algorithm", ["kwl2", "lwl2"])
+@pytest.mark.parametrize("pruning", ["none", "i-g", "i-mf"])
+def test_collect_dataset(feature_algorithm, pruning):
+    """Check collecting 2-WL colours from a dataset with several threads matches collecting from
+    its graphs with one"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    dataset = DomainDataset(domain=domain, data=dataset.data[:3])
+    kwargs = dict(
+        feature_algorithm=feature_algorithm,
+        domain=domain,
+        graph_representation="ilg",
+        iterations=2,
+        pruning=pruning,
+    )
+    from_dataset = init_feature_generator(**kwargs)
+    from_dataset.set_n_threads(4)
+    from_dataset.collect(dataset)
+    from_graphs = init_feature_generator(**kwargs)
+    from_graphs.collect(from_graphs.to_graphs(dataset))
+
+    assert from_dataset.get_n_features() > 0
+    assert from_dataset.get_n_features() == from_graphs.get_n_features()
+    assert from_dataset.embed(dataset) == from_graphs.embed(dataset)
+
+
+@pytest.mark.parametrize("max_pair_entries", [0, 1 << 24])
+def test_lwl2_paths(max_pair_entries):
+    """Check 2-LWL colours of paths with pair neighbourhoods generated on the fly or stored"""
+    expected = {
+        # the neighbours of the pair {1, 2} of the path 0-1-2-3 give it the same set of
+        # neighbour colours as {0, 1} but not the same multiset
+        False: {0: [3, 3], 1: [1, 2, 3], 2: [1, 2, 3]},
+        True: {0: [3, 3], 1: [1, 1, 2, 2], 2: [1, 1, 2, 2]},
+    }
+    for multiset_hash in [False, True]:
+        feature_generator = _custom_feature_generator("lwl2", multiset_hash)
+        feature_generator.set_max_pair_entries(max_pair_entries)
+        feature_generator.collect([_path(3), _path(4)])
+        assert _layer_counts(feature_generator, _path(3)) == {0: [1, 2], 1: [1, 2], 2: [1, 2]}
+        assert _layer_counts(feature_generator, _path(4)) == expected[multiset_hash]
+
+
+@pytest.mark.parametrize("multiset_hash", [False, True])
+@pytest.mark.parametrize("radius", [1, 2])
+def test_slwl2_path(multiset_hash, radius):
+    """Check sparse 2-LWL only colours pairs of the path 0-1-2-3 within the radius"""
+    expected = {
+        # only the edges, whose neighbourhoods include far pairs
+        (False, 1): {0: [3], 1: [3], 2: [3]},
+        (True, 1): {0: [3], 1: [1, 2], 2: [1, 2]},
+        # all pairs but {0, 3}
+        (False, 2): {0: [2, 3], 1: [2, 3], 2: [2, 3]},
+        (True, 2): {0: [2, 3], 1: [1, 2, 2], 2: [1, 2, 2]},
+    }
+    feature_generator = _custom_feature_generator("slwl2", multiset_hash, radius=radius)
+    feature_generator.collect([_path(4)])
+    assert _layer_counts(feature_generator, _path(4)) == expected[(multiset_hash, radius)]
+
+
+@pytest.mark.parametrize("radius", [1, 2])
+def test_slwl2_save_load(tmp_path, radius):
+    """Check sparse 2-LWL models keep their radius when saved and loaded"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    dataset = DomainDataset(domain=domain, data=dataset.data[:3])
+    feature_generator = init_feature_generator(
+        feature_algorithm="slwl2",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=2,
+        pruning="i-mf",
+        radius=radius,
+    )
+    feature_generator.collect(dataset)
+    X = feature_generator.embed(dataset)
+    assert feature_generator.get_n_features() > 0
+
+    save_file = tmp_path / f"slwl2_{radius}"
+    feature_generator.save(f"{save_file}.json")
+    feature_generator.save_binary(f"{save_file}.bin")
+    for filename in [f"{save_file}.json", f"{save_file}.bin"]:
+        loaded = load_feature_generator(filename)
+        assert loaded.get_radius() == radius
+        assert loaded.embed(dataset) == X
@@ -0,0 +1,200 @@
+import logging
+import os
+import time
+
+import pytest
+from ipc23lt import get_dataset
+
+from wlplan.feature_generator import (
+    CoreGuidedMaxSatSolver,
+    DecomposingMaxSatSolver,
+    ExternalMaxSatSolver,
+    MaxSatProblem,
+    init_feature_generator,
+)
+
+LOGGER = logging.getLogger(__name__)
+
+UWRMAXSAT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "uwrmaxsat")
+
+
+@pytest.mark.parametrize("pruning", ["i-mf", "a-m"])
+def test_embedded_matches_external(pruning):
+    """Check the embedded MaxSAT solver prunes to as many features as an external solver"""
+    if not os.access(UWRMAXSAT, os.X_OK):
+        pytest.skip("uwrmaxsat is not available")
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    n_features = {}
+    for solver in ["embedded", UWRMAXSAT]:
+        feature_generator = init_feature_generator(
+            feature_algorithm="wl",
+            domain=domain,
+            graph_representation="ilg",
+            iterations=2,
+            pruning=pruning,
+        )
+        feature_generator.set_maxsat_solver(solver)
+        feature_generator.collect(dataset)
+        n_features[solver] = feature_generator.get_n_features()
+    LOGGER.info(f"n_features={n_features}")
+    assert n_features["embedded"] == n_features[UWRMAXSAT]
+
+
+@pytest.mark.parametrize("pruning", ["i-mf", "a-m"])
+def test_parallel_components(pruning):
+    """Check solving MaxSAT components in parallel prunes the same features as in serial"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    embeddings = {}
+    for n_threads in [1, 4]:
+        feature_generator = init_feature_generator(
+            feature_algorithm="wl",
+            domain=domain,
+            graph_representation="ilg",
+            iterations=2,
+            pruning=pruning,
+        )
+        feature_generator.set_n_threads(n_threads)
+        feature_generator.collect(dataset)
+        embeddings[n_threads] = feature_generator.embed(dataset)
+    assert embeddings[1] == embeddings[4]
+
+
+def _solvers():
+    return [CoreGuidedMaxSatSolver(), DecomposingMaxSatSolver("embedded", 2)]
+
+
+@pytest.mark.parametrize("solver", _solvers())
+def test_unsat_hard_clauses(solver):
+    """Check no assignment is found if the hard clauses are unsatisfiable"""
+    problem = MaxSatProblem()
+    problem.add_hard([1, 2])
+    problem.add_hard([-1])
+    problem.add_hard([-2])
+    problem.add_soft([3], 1)
+    solution = solver.solve(problem)
+    assert not solution.found
+    assert not solution.optimal
+
+
+@pytest.mark.parametrize("solver", _solvers())
+def test_weighted_optimum(solver):
+    """Check the optimum cost of weighted soft clauses"""
+    problem = MaxSatProblem()
+    problem.add_hard([2, 3])
+    problem.add_soft([1], 3)
+    problem.add_soft([-1], 5)
+    problem.add_soft([-2], 2)
+    problem.add_soft([-3], 4)
+    problem.add_soft([-2, -4], 1)
+    problem.add_soft([4], 1)
+    solution = solver.solve(problem)
+    assert solution.found and solution.optimal
+    # violate [1], [-2] and one of the last two clauses
+    assert solution.cost == 6
+    assert solution.lower_bound == 6
+    assert problem.get_cost(solution.values) == 6
+    assert not solution.values[1] and solution.values[2] and not solution.values[3]
+
+
+@pytest.mark.parametrize("solver", _solvers())
+def test_cores_of_size_one(solver):
+    """Check soft clauses contradicting hard units give cores of size one with the right bound"""
+    problem = MaxSatProblem()
+    problem.add_hard([-1])
+    problem.add_hard([-2, -3])
+    problem.add_soft([1], 3)
+    problem.add_soft([1], 2)
+    problem.add_soft([2], 4)
+    problem.add_soft([3], 1)
+    solution = solver.solve(problem)
+    assert solution.found and solution.optimal
+    assert solution.cost == solution.lower_bound == 6
+    assert not solution.values[1] and solution.values[2] and not solution.values[3]
+
+
+def _pigeonhole(n_holes):
+    """Each pigeon should be in a hole but holes take one pigeon, so one pigeon is left out"""
+    problem = MaxSatProblem()
+    var = lambda p, h: p * n_holes + h + 1
+    for p in range(n_holes + 1):
+        problem.add_soft([var(p, h) for h in range(n_holes)], 1)
+    for h in range(n_holes):
+        for p in range(n_holes + 1):
+            for q in range(p + 1, n_holes + 1):
+                problem.add_hard([-var(p, h), -var(q, h)])
+    return problem
+
+
+def test_time_limited_anytime():
+    """Check bounds of a solution cut off by the time limit are consistent"""
+    problem = _pigeonhole(10)
+    start = time.time()
+    solution = CoreGuidedMaxSatSolver().solve(problem, 0.05)
+    assert time.time() - start < 5
+    assert solution.found
+    assert problem.get_cost(solution.values) == solution.cost >= 1
+    assert solution.lower_bound <= solution.cost
+    assert solution.optimal == (solution.lower_bound == solution.cost)
+
+
+def _write_solver(tmp_path, body):
+    path = tmp_path / "solver.sh"
+    path.write_text("#!/bin/sh\n" + body)
+    path.chmod(0o755)
+    return str(path)
+
+
+@pytest.mark.parametrize("trap", ["", "trap '' TERM\n"])
+def test_external_time_limit(tmp_path, trap):
+    """Check an external solver is stopped at the time limit and its last assignment is used,
+    including when it ignores SIGTERM"""
+    problem = MaxSatProblem()
+    problem.add_hard([1, 2])
+    problem.add_soft([-1], 1)
+    problem.add_soft([-2], 1)
+    command = _write_solver(tmp_path, trap + "echo 'o 1'\necho 'v 1 -2 0'\nsleep 60\n")
+    start = time.time()
+    solution = ExternalMaxSatSolver(command).solve(problem, 0.5)
+    assert time.time() - start < 10
+    assert solution.found and not solution.optimal
+    assert solution.cost == 1
+    assert solution.lower_bound == 0
+    assert solution.values[1] and not solution.values[2]
+
+
+def test_external_time_limit_without_assignment(tmp_path):
+    """Check nothing is found if an external solver is stopped before printing an assignment"""
+    problem = MaxSatProblem()
+    problem.add_soft([1], 1)
+    command = _write_solver(tmp_path, "sleep 60\n")
+    solution = ExternalMaxSatSolver(command).solve(problem, 0.2)
+    assert not solution.found
+
+
+def test_decomposing_fallback(tmp_path):
+    """Check components that time out take the fallback assignment while the others keep their
+    solutions, and that nothing is found without a fallback"""
+    problem = MaxSatProblem()
+    # small component solved in process, which keeps one of variables 1 and 2
+    problem.add_hard([-1, -2])
+    problem.add_soft([1], 1)
+    problem.add_soft([2], 1)
+    # large component for the external solver, which prints no assignment before the time limit
+    for v in range(3, 102):
+        problem.add_hard([v, -(v + 1)])
+    for v in range(3, 103):
+        problem.add_soft([v], 1)
+    command = _write_solver(tmp_path, "sleep 60\n")
+
+    solver = DecomposingMaxSatSolver(command, 2)
+    assert not solver.solve(problem, 0.2).found
+    assert solver.get_n_unsolved_components() == 1
+
+    solver.set_fallback([False] * (problem.get_n_variables() + 1))
+    solution = solver.solve(problem, 0.2)
+    assert solver.get_n_components() == 2
+    assert solver.get_n_unsolved_components() == 1
+    assert solution.found and not solution.optimal
+    assert solution.values[1] != solution.values[2]
+    assert not any(solution.values[3:])
+    assert problem.get_cost(solution.values) == solution.cost == 101
@@ -0,0 +1,48 @@
+import logging
+
+import numpy as np
+import pytest
+from ipc23lt import get_dataset
+from util import to_dense
+
+from wlplan.feature_generator import init_feature_generator
+
+
+LOGGER = logging.getLogger(__name__)
+
+
+def test_predict_batch():
+    """Check batch predictions match per-state predictions and the dot product of embeddings with
+    the weights, with one thread and several"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+    )
+    feature_generator.collect(dataset)
+    graphs = feature_generator.to_graphs(dataset)
+    problem_dataset = dataset.data[0]
+    states = problem_dataset.states
+    feature_generator.set_problem(problem_dataset.problem)
+
+    with pytest.raises(RuntimeError, match="Weights have not been set"):
+        feature_generator.predict_batch(graphs)
+    with pytest.raises(RuntimeError, match="Weights have not been set"):
+        feature_generator.predict_batch(states)
+
+    n_features = feature_generator.get_n_features()
+    weights = np.random.default_rng(0).uniform(-1, 1, n_features)
+    feature_generator.set_weights(weights.tolist())
+    h_graphs = to_dense(feature_generator.embed(graphs), d=n_features) @ weights
+    h_states = [feature_generator.predict(state) for state in states]
+
+    for n_threads in [1, 4]:
+        feature_generator.set_n_threads(n_threads)
+        h_batch = feature_generator.predict_batch(graphs)
+        assert np.allclose(h_batch, h_graphs)
+        assert h_batch == [feature_generator.predict(graph) for graph in graphs]
+        assert feature_generator.predict_batch(states) == h_states
+        assert feature_generator.predict_batch([]) == []
+    LOGGER.info(f"{len(graphs)=}, {len(states)=}")
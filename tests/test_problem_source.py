@@ -0,0 +1,54 @@
+import logging
+
+import pytest
+from ipc23lt import get_dataset
+
+from wlplan.data import ProblemSource
+from wlplan.feature_generator import init_feature_generator
+
+LOGGER = logging.getLogger(__name__)
+
+
+class ListSource(ProblemSource):
+    def __init__(self, data):
+        super().__init__()
+        self._data = data
+        self._index = 0
+        self.n_resets = 0
+
+    def reset(self):
+        self._index = 0
+        self.n_resets += 1
+
+    def next(self):
+        if self._index >= len(self._data):
+            return None
+        self._index += 1
+        return self._data[self._index - 1]
+
+
+@pytest.mark.parametrize("n_threads", [1, 4])
+@pytest.mark.parametrize("pruning", ["none", "i-g"])
+def test_problem_source(pruning, n_threads):
+    """Check collecting from a problem source gives the same features as collecting the graphs of
+    the dataset with one thread"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    kwargs = dict(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+        pruning=pruning,
+    )
+    from_graphs = init_feature_generator(**kwargs)
+    from_graphs.collect(from_graphs.to_graphs(dataset))
+    from_source = init_feature_generator(**kwargs)
+    from_source.set_n_threads(n_threads)
+    source = ListSource(list(dataset.data))
+    from_source.collect(source)
+
+    # graphs are stored after the first pass instead of being regenerated in each iteration
+    assert source.n_resets == 1
+    assert from_source.get_n_features() == from_graphs.get_n_features()
+    assert from_source.embed(dataset) == from_graphs.embed(dataset)
+    LOGGER.info(f"n_features={from_source.get_n_features()}")
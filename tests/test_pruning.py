@@ -3,8 +3,10 @@ from itertools import product
 
 import pytest
 from colours import DOMAINS, colours_test
+from ipc23lt import get_dataset
+from util import to_dense
 
-from wlplan.feature_generator import PruningOptions
+from wlplan.feature_generator import PruningOptions, init_feature_generator
 
 
 LOGGER = logging.getLogger(__name__)
@@ -17,6 +19,35 @@ def test_domain(domain_name, pruning):
     colours_test(domain_name, 2, "wl", pruning)
 
 
+
+def _columns(feature_generator, graphs):
+    X = to_dense(feature_generator.embed(graphs), d=feature_generator.get_n_features())
+    return [tuple(column) for column in X.T]
+
+
+@pytest.mark.parametrize("n_threads", [1, 4])
+def test_equivalence_groups(n_threads):
+    """Check pruning equivalent features keeps one feature of each group of features with equal
+    columns on the collected graphs, grouped by comparing all pairs of columns"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    kwargs = dict(domain=domain, graph_representation="ilg", iterations=2)
+    full = init_feature_generator(feature_algorithm="wl", pruning="none", **kwargs)
+    graphs = full.to_graphs(dataset)
+    full.collect(graphs)
+    columns = _columns(full, graphs)
+    groups = []
+    for column in columns:
+        if all(column != other for other in groups):
+            groups.append(column)
+
+    pruned = init_feature_generator(feature_algorithm="wl", pruning="a-m", **kwargs)
+    pruned.set_n_threads(n_threads)
+    pruned.collect(graphs)
+    pruned_columns = _columns(pruned, graphs)
+    assert len(groups) <= pruned.get_n_features() < full.get_n_features()
+    assert set(pruned_columns) == set(groups)
+    LOGGER.info(f"{len(columns)=}, {len(groups)=}, {len(pruned_columns)=}")
+
 # TODO fix this test, something went wrong after a1ea97f although it shouldn't affect lwl2?
 # @pytest.mark.parametrize("domain_name,pruning", product(DOMAINS, ["i-mf"]))
 # def test_expressive(domain_name, pruning):
@@ -2,13 +2,15 @@
 
 import itertools
 import logging
+import os
+import sys
 
 import numpy as np
 import pytest
 from ipc23lt import get_dataset
 from util import to_dense
 
-from wlplan.feature_generator import init_feature_generator, load_feature_generator
+from wlplan.feature_generator import Features, init_feature_generator, load_feature_generator
 
 
 LOGGER = logging.getLogger(__name__)
@@ -52,6 +54,71 @@ def test_save_load(domain_name, desc):
     assert loaded_X.shape == X.shape
     assert (loaded_X == X).all()
 
+    ## frozen colour hash gives the same embeddings
+    feature_generator.freeze()
+    frozen_X = to_dense(feature_generator.embed(dataset)).astype(float)
+    assert (frozen_X == X).all()
+
+    ## binary models give the same embeddings
+    for compress_keys in [False, True]:
+        binary_file = save_file.replace(".json", ".bin")
+        feature_generator.save_binary(binary_file, compress_keys=compress_keys)
+        binary_generator = load_feature_generator(binary_file)
+        binary_X = to_dense(binary_generator.embed(dataset)).astype(float)
+        assert (binary_X == X).all()
+
+    ## save writes JSON whatever the extension
+    model_file = save_file.replace(".json", ".model")
+    feature_generator.save(model_file)
+    assert not Features.is_binary_model(model_file)
+
+
+@pytest.mark.skipif(not os.path.exists("/dev/full"), reason="needs /dev/full")
+def test_save_binary_write_error():
+    """Check failing to write a binary model raises instead of leaving a truncated file"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl", domain=domain, graph_representation="ilg", iterations=2
+    )
+    feature_generator.collect(dataset)
+    with pytest.raises(RuntimeError, match="/dev/full"):
+        feature_generator.save_binary("/dev/full")
+
+
+
+def _first_colour_table(data: bytes) -> int:
+    """Offset of the first colour table of a binary model"""
+    offset = 8 + 3 * 4
+    for _ in range(4):
+        offset += 4 + int.from_bytes(data[offset : offset + 4], sys.byteorder)
+    offset += 4 + 1
+    for _ in range(2):
+        offset += 4 + int.from_bytes(data[offset : offset + 4], sys.byteorder)
+    return offset + 4
+
+
+@pytest.mark.parametrize("compress_keys", [False, True])
+@pytest.mark.parametrize("field,change", [("n_key_ints", 1), ("n_key_ints", -1), ("n_bytes", 1)])
+def test_load_binary_corrupt_table(tmp_path, compress_keys, field, change):
+    """Check loading a binary model whose colour table sizes do not match its data raises"""
+    if field == "n_bytes" and not compress_keys:
+        pytest.skip("only compressed tables store their number of bytes")
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    feature_generator = init_feature_generator(
+        feature_algorithm="wl", domain=domain, graph_representation="ilg", iterations=2
+    )
+    feature_generator.collect(dataset)
+    binary_file = str(tmp_path / "model.bin")
+    feature_generator.save_binary(binary_file, compress_keys=compress_keys)
+    load_feature_generator(binary_file)
+
+    data = bytearray(open(binary_file, "rb").read())
+    offset = _first_colour_table(data) + {"n_key_ints": 8, "n_bytes": 16}[field]
+    value = int.from_bytes(data[offset : offset + 8], sys.byteorder) + change
+    data[offset : offset + 8] = value.to_bytes(8, sys.byteorder)
+    open(binary_file, "wb").write(data)
+    with pytest.raises(RuntimeError):
+        load_feature_generator(binary_file)
 
 if __name__ == "__main__":
     test_save_load("blocksworld")
@@ -0,0 +1,35 @@
+import logging
+
+import pytest
+from ipc23lt import get_dataset
+
+from wlplan.feature_generator import init_feature_generator
+
+LOGGER = logging.getLogger(__name__)
+
+
+@pytest.mark.parametrize("pruning", ["i-g", "a-m"])
+@pytest.mark.parametrize("n_threads", [1, 4])
+def test_spill(tmp_path, n_threads, pruning):
+    """Check collecting with colourings and statistics spilled to disk gives the same features as
+    collecting the graphs of the dataset in memory with one thread"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    kwargs = dict(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+        pruning=pruning,
+    )
+    in_memory = init_feature_generator(**kwargs)
+    in_memory.set_n_threads(1)
+    in_memory.collect(in_memory.to_graphs(dataset))
+    spilled = init_feature_generator(**kwargs)
+    spilled.set_n_threads(n_threads)
+    spilled.set_spill_directory(str(tmp_path))
+    spilled.collect(dataset)
+
+    assert spilled.get_n_features() == in_memory.get_n_features()
+    assert spilled.embed(dataset) == in_memory.embed(dataset)
+    assert list(tmp_path.iterdir()) == []
+    LOGGER.info(f"n_features={spilled.get_n_features()}")
@@ -116,6 +116,7 @@ def test_train_eval_blocks():
         h_api = feature_generator.predict(state)
         h_loaded = x @ w_loaded.T
         assert np.isclose(h_raw, h_api)
+        assert np.allclose(feature_generator.predict_batch([state, state]), h_api)
         assert np.isclose(h_raw, h_loaded)
         h_raw = round(h_raw[0])
         return h_raw
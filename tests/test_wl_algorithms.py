@@ -2,6 +2,12 @@ import logging
 
 import pytest
 from colours import DOMAINS, colours_test
+from ipc23lt import get_dataset
+from util import custom_graph_domain, to_dense
+
+from wlplan.data import DomainDataset
+from wlplan.feature_generator import init_feature_generator
+from wlplan.graph_generator import Graph
 
 
 LOGGER = logging.getLogger(__name__)
@@ -11,3 +17,133 @@ LOGGER = logging.getLogger(__name__)
 @pytest.mark.parametrize("wl_algorithm", ["wl", "iwl", "niwl", "lwl2"])
 def test_domain(domain_name: str, wl_algorithm: str):
     colours_test(domain_name=domain_name, iterations=2, feature_algorithm=wl_algorithm)
+
+
+@pytest.mark.parametrize("pruning", ["none", "i-mf"])
+def test_collect_graphs_threads(tmp_path, pruning: str):
+    """Check collecting from graphs with several threads gives the same colour ids as with one"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    kwargs = dict(
+        feature_algorithm="wl",
+        domain=domain,
+        graph_representation="ilg",
+        iterations=3,
+        pruning=pruning,
+    )
+    sequential = init_feature_generator(**kwargs)
+    graphs = sequential.to_graphs(dataset)
+    sequential.set_n_threads(1)
+    sequential.collect(graphs)
+    parallel = init_feature_generator(**kwargs)
+    parallel.set_n_threads(4)
+    parallel.collect(graphs)
+
+    # the saved colour hash maps each colour key to its id, so equal files mean equal ids
+    sequential.save(str(tmp_path / "sequential.json"))
+    parallel.save(str(tmp_path / "parallel.json"))
+    saved = (tmp_path / "sequential.json").read_text()
+    assert saved == (tmp_path / "parallel.json").read_text()
+    assert parallel.embed(graphs) == sequential.embed(graphs)
+
+
+@pytest.mark.parametrize("wl_algorithm", ["wl", "iwl", "niwl", "kwl2", "lwl2"])
+def test_embed_threads(wl_algorithm: str):
+    """Check embedding a dataset or its graphs with several threads gives the same rows and the
+    same merged seen and unseen colour counts as with one"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    dataset = DomainDataset(domain=domain, data=dataset.data[:4])
+    feature_generator = init_feature_generator(
+        feature_algorithm=wl_algorithm,
+        domain=domain,
+        graph_representation="ilg",
+        iterations=2,
+    )
+    # collecting from part of the data leaves colours unseen in the rest
+    feature_generator.collect(DomainDataset(domain=domain, data=dataset.data[:1]))
+    graphs = feature_generator.to_graphs(dataset)
+
+    def embed_with_counts(data):
+        seen = feature_generator.get_seen_counts()
+        unseen = feature_generator.get_unseen_counts()
+        X = feature_generator.embed(data)
+        seen = [b - a for a, b in zip(seen, feature_generator.get_seen_counts())]
+        unseen = [b - a for a, b in zip(unseen, feature_generator.get_unseen_counts())]
+        return X, seen, unseen
+
+    results = {}
+    for n_threads in [1, 4]:
+        feature_generator.set_n_threads(n_threads)
+        results[n_threads] = embed_with_counts(dataset), embed_with_counts(graphs)
+    assert results[4] == results[1]
+    assert sum(results[1][0][2]) > 0
+    assert results[1][0] == results[1][1]
+
+
+@pytest.mark.parametrize("wl_algorithm", ["iwl", "niwl"])
+def test_individualisation_threads(wl_algorithm: str):
+    """Check individualising nodes of single graphs in parallel and embedding graphs in parallel
+    match embedding with one thread, and that collecting from a dataset with several threads
+    matches collecting from its graphs with one"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    dataset = DomainDataset(domain=domain, data=dataset.data[:3])
+    kwargs = dict(
+        feature_algorithm=wl_algorithm,
+        domain=domain,
+        graph_representation="ilg",
+        iterations=2,
+    )
+    from_graphs = init_feature_generator(**kwargs)
+    graphs = from_graphs.to_graphs(dataset)
+    from_graphs.collect(graphs)
+    X = from_graphs.embed(graphs)
+    from_dataset = init_feature_generator(**kwargs)
+    from_dataset.set_n_threads(4)
+    from_dataset.collect(dataset)
+    assert from_dataset.get_n_features() == from_graphs.get_n_features()
+
+    from_graphs.set_n_threads(4)
+    assert from_graphs.embed(graphs) == X
+    assert [from_graphs.embed(graph) for graph in graphs] == X
+    assert from_dataset.embed(graphs) == X
+
+
+@pytest.mark.parametrize("wl_algorithm", ["iwl", "niwl"])
+def test_individualisation_pruning(wl_algorithm: str):
+    """Check pruning equivalent IWL features only removes columns that equal kept columns on the
+    collected data, as colours shared by individualisations are counted once for each of them"""
+    domain, dataset, _ = get_dataset("blocksworld", keep_statics=False)
+    dataset = DomainDataset(domain=domain, data=dataset.data[:3])
+    columns = {}
+    for pruning in ["none", "a-m"]:
+        feature_generator = init_feature_generator(
+            feature_algorithm=wl_algorithm, domain=domain, iterations=2, pruning=pruning
+        )
+        feature_generator.collect(dataset)
+        X = to_dense(feature_generator.embed(dataset), d=feature_generator.get_n_features())
+        columns[pruning] = {tuple(column) for column in X.T if column.any()}
+    assert columns["a-m"] == columns["none"]
+
+
+@pytest.mark.parametrize("n_threads", [1, 4])
+def test_individualisation_directed_path(n_threads: int):
+    """Check IWL colours of the directed path 0 -> 1 -> 2, where the ball of a node is made of the
+    nodes with a path to it, as nodes are refined with the colours of their successors"""
+    feature_generator = init_feature_generator(
+        feature_algorithm="iwl",
+        domain=custom_graph_domain(),
+        graph_representation="custom",
+        iterations=1,
+    )
+    feature_generator.set_n_threads(n_threads)
+    graph = Graph(node_colours=[0, 0, 0], edges=[[(0, 1)], [(0, 2)], []])
+    feature_generator.collect([graph])
+
+    # Each of the 3 individualisations has 1 individualised node and 2 other nodes. After one
+    # iteration, (individualised, successor), (plain, plain successor), (plain, no successor) and
+    # (plain, individualised successor) occur twice each, and (individualised, no successor) once.
+    colour_to_layer = feature_generator.get_colour_to_layer()
+    counts = {0: [], 1: []}
+    for colour, count in feature_generator.embed(graph).items():
+        counts[colour_to_layer[colour]].append(count)
+    assert sorted(counts[0]) == [3, 6]
+    assert sorted(counts[1]) == [1, 2, 2, 2, 2]
@@ -2,6 +2,8 @@ import logging
 
 import numpy as np
 
+from wlplan.planning import Domain
+
 LOGGER = logging.getLogger(__name__)
 
 
@@ -29,4 +31,17 @@ def to_dense(X, n=None, d=None):
         for k, v in x_sparse.items():
             X_dense[i][k] = v
 
-    return X_dense
\ No newline at end of file
+    return X_dense
+
+
+def custom_graph_domain() -> Domain:
+    """Domain without predicates for feature generators of custom graphs"""
+    return Domain(
+        name="graphs",
+        predicates=[],
+        functions=[],
+        schemata=[],
+        types=["object"],
+        constant_objects=[],
+    )
+
@@ -1,4 +1,4 @@
-from _wlplan.data import DomainDataset, ProblemDataset
+from _wlplan.data import DomainDataset, ProblemDataset, ProblemSource
 
 
-__all__ = ["DomainDataset", "ProblemDataset"]
+__all__ = ["DomainDataset", "ProblemDataset", "ProblemSource"]
@@ -1,15 +1,21 @@
-import json
 import os
 
 from _wlplan.feature_generator import (
     CCWLaFeatures,
     CCWLFeatures,
+    CoreGuidedMaxSatSolver,
+    DecomposingMaxSatSolver,
+    ExternalMaxSatSolver,
     Features,
     IWLFeatures,
     KWL2Features,
     LWL2Features,
+    MaxSatProblem,
+    MaxSatSolution,
+    MaxSatSolver,
     NIWLFeatures,
     PruningOptions,
+    SLWL2Features,
     WLFeatures,
 )
 from _wlplan.planning import Domain
@@ -22,13 +28,32 @@ __all__ = [
     "get_available_graph_generators",
     "get_available_pruning_methods",
     "Features",
-    "load_feature_generator"
+    "load_feature_generator",
+    "MaxSatProblem",
+    "MaxSatSolution",
+    "MaxSatSolver",
+    "CoreGuidedMaxSatSolver",
+    "ExternalMaxSatSolver",
+    "DecomposingMaxSatSolver",
 ]
 
 _FEATURE_ALGORITHMS = {
     "wl": WLFeatures,
     "kwl2": KWL2Features,
     "lwl2": LWL2Features,
+    "slwl2": SLWL2Features,
+    "iwl": IWLFeatures,
+    "niwl": NIWLFeatures,
+    "ccwl": CCWLFeatures,
+    "ccwl-a": CCWLaFeatures,
+}
+
+# feature names that models are saved with, which differ from the names above for 2-WL variants
+_SAVED_FEATURE_ALGORITHMS = {
+    "wl": WLFeatures,
+    "2-kwl": KWL2Features,
+    "2-lwl": LWL2Features,
+    "2-slwl": SLWL2Features,
     "iwl": IWLFeatures,
     "niwl": NIWLFeatures,
     "ccwl": CCWLFeatures,
@@ -51,6 +76,7 @@ def init_feature_generator(
     iterations: int = 2,
     pruning: str = "none",
     multiset_hash: bool = False,
+    radius: int = 1,
 ) -> Features:
     """
     Returns a feature generator based on the specified feature algorithm.
@@ -75,6 +101,10 @@ def init_feature_generator(
         multiset_hash : bool, default=False
             Choose to use either set or multiset to store neighbour colours.
 
+        radius : int, default=1
+            For `"slwl2"`, only pairs of nodes with a path of at most this many edges between them
+            are coloured. Ignored by other feature algorithms.
+
     Returns
     -------
         FeatureGenerator: The instantiated feature generator.
@@ -99,15 +129,20 @@ def init_feature_generator(
     if pruning not in prune_choices:
         raise ValueError(f"Unknown value {pruning=}. Must be from {prune_choices}")
 
-    if pruning.startswith("i-") and feature_algorithm not in {"wl", "lwl2"}:
+    if pruning.startswith("i-") and feature_algorithm not in {"wl", "kwl2", "lwl2", "slwl2"}:
         raise NotImplementedError(f"{pruning=} and {feature_algorithm=} are not compatible")
 
+    kwargs = {}
+    if feature_algorithm == "slwl2":
+        kwargs["radius"] = radius
+
     return FeatureGenerator(
         domain=domain,
         graph_representation=graph_representation,
         iterations=iterations,
         pruning=pruning,
         multiset_hash=multiset_hash,
+        **kwargs,
     )
 
 
@@ -130,11 +165,10 @@ def load_feature_generator(filename: str, quiet: bool = False) -> Features:
     if not os.path.exists(filename):
         raise FileNotFoundError(f"Model file not found: {filename}")
 
-    with open(filename, "r") as f:
-        data = json.load(f)
-    feature_generator = data["feature_name"]
+    # handles both JSON and binary models
+    feature_generator = Features.read_feature_name(filename)
 
-    if feature_generator not in _FEATURE_ALGORITHMS:
+    if feature_generator not in _SAVED_FEATURE_ALGORITHMS:
         raise ValueError(f"Unknown {feature_generator=} in {filename=}")
 
-    return _FEATURE_ALGORITHMS[feature_generator](filename=filename, quiet=quiet)
+    return _SAVED_FEATURE_ALGORITHMS[feature_generator](filename=filename, quiet=quiet)
@@ -145,7 +145,8 @@ def to_networkx(graph: Graph) -> nx.Graph:
     for u, colour in enumerate(graph.node_colours):
         node_name = graph.get_node_name(u)
         G.add_node(node_name, colour=colour)
-    for u in range(len(graph.edges)):
-        for r, v in graph.edges[u]:
+    edges = graph.edges
+    for u in range(len(edges)):
+        for r, v in edges[u]:
             G.add_edge(graph.get_node_name(u), graph.get_node_name(v), relation=r)
     return G
@@ -16,6 +16,7 @@ from _wlplan.planning import (
     FluentExpression,
     FormulaExpression,
     Function,
+    InternedState,
     NumericCondition,
     NumericExpression,
     OperatorType,
@@ -27,7 +28,16 @@ from _wlplan.planning import (
 )
 
 
-__all__ = ["parse_domain", "parse_problem", "Predicate", "State", "Atom", "Object", "Domain"]
+__all__ = [
+    "parse_domain",
+    "parse_problem",
+    "Predicate",
+    "State",
+    "InternedState",
+    "Atom",
+    "Object",
+    "Domain",
+]
 
 _PDDL_TO_WLPLAN_BINARY_OPS = {
     pddl.logic.functions.Plus: OperatorType.Plus,